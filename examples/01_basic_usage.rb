@@ -63,10 +63,11 @@ Dir.mktmpdir("zvec_demo") do |dir|
     make_doc("mov5", "Amélie",             2001, [0.0, 0.1, 0.8, 0.9]),
   ]
 
-  # Insert returns a Status per document
-  statuses = col.insert(movies)
-  statuses.each_with_index do |s, i|
-    puts "  Insert #{movies[i].pk}: #{s}"
+  # Insert returns a WriteResult for the whole batch
+  result = col.insert(movies)
+  puts "  #{result}"
+  result.failures.each do |f|
+    puts "  Insert #{f.pk} failed: #{f.message}"
   end
 
   # Flush writes buffered data to disk
@@ -101,8 +102,8 @@ Dir.mktmpdir("zvec_demo") do |dir|
 
   # ── 5. Delete a document ─────────────────────────────────────────────
 
-  del_statuses = col.delete(["mov1"])
-  puts "\nDelete mov1: #{del_statuses.first}"
+  del_result = col.delete(["mov1"])
+  puts "\nDelete mov1: #{del_result}"
   col.flush
 
   remaining = col.fetch(["mov1"])
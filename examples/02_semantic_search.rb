@@ -71,9 +71,10 @@ Dir.mktmpdir("zvec_semantic") do |dir|
     doc
   end
 
-  statuses = col.insert(zvec_docs)
-  statuses.each_with_index do |s, i|
-    puts "  Insert #{docs[i][:filename]}: #{s}"
+  result = col.insert(zvec_docs)
+  puts "  Inserted #{result.ok_count} of #{result.size} documents"
+  result.failures.each do |f|
+    puts "  Insert #{docs[f.index][:filename]} failed: #{f.message}"
   end
   col.flush
 
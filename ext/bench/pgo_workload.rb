@@ -0,0 +1,60 @@
+# frozen_string_literal: true
+
+# Training workload for profile-guided builds (rake ext:pgo). Exercises the
+# hot binding paths — doc conversion, batched writes, filtered HNSW queries,
+# fetch, quantized refine queries and scans — against a scratch collection.
+#
+#   ruby -Ilib ext/bench/pgo_workload.rb [docs] [dimension] [queries]
+
+require "zvec"
+require "tmpdir"
+
+docs_count = Integer(ARGV[0] || 20_000)
+dim = Integer(ARGV[1] || 128)
+queries = Integer(ARGV[2] || 2_000)
+rng = Random.new(42)
+random_vector = -> { Array.new(dim) { rng.rand(-1.0..1.0) } }
+
+Dir.mktmpdir("zvec-pgo") do |dir|
+  schema = Zvec::CollectionSchema.create("pgo", [
+    Zvec::FieldSchema.create("pk", Zvec::DataType::STRING),
+    Zvec::FieldSchema.create("year", Zvec::DataType::INT32,
+      index_params: Zvec::InvertIndexParams.new),
+    Zvec::FieldSchema.create("embedding", Zvec::DataType::VECTOR_FP32, dimension: dim,
+      index_params: Zvec::HnswIndexParams.new(Zvec::MetricType::IP)),
+    Zvec::FieldSchema.create("embedding_int8", Zvec::DataType::VECTOR_INT8, dimension: dim,
+      index_params: Zvec::HnswIndexParams.new(Zvec::MetricType::IP))
+  ])
+  col = Zvec::Collection.create_and_open(File.join(dir, "pgo"), schema)
+
+  sample = Array.new(1_000) { random_vector.call }
+  quantizer = Zvec::Quantizer.fit(sample, type: :int8)
+
+  docs_count.times.each_slice(500) do |ids|
+    docs = ids.map do |i|
+      vec = random_vector.call
+      doc = Zvec::Doc.new
+      doc.pk = "doc-#{i}"
+      doc.set_field("pk", Zvec::DataType::STRING, doc.pk)
+      doc.set_field("year", Zvec::DataType::INT32, 1990 + (i % 35))
+      doc.set_field("embedding", Zvec::DataType::VECTOR_FP32, vec)
+      doc.set_packed_vector("embedding_int8", Zvec::DataType::VECTOR_INT8, quantizer.quantize_vector(vec))
+      doc
+    end
+    col.upsert(docs)
+  end
+  col.flush
+  col.optimize
+
+  filter = Zvec::Filter.compile("year >= ? AND year < ?", schema: schema)
+  queries.times do |i|
+    vec = random_vector.call
+    col.query_vector("embedding", vec, top_k: 10)
+    col.query_vector("embedding", vec, top_k: 10, filter: filter.bind(2000, 2000 + (i % 20)))
+    col.refine_query_vector("embedding_int8", "embedding", vec, top_k: 10, quantizer: quantizer)
+    col.fetch(Array.new(10) { "doc-#{rng.rand(docs_count)}" })
+  end
+  col.scan(batch_size: 1_000).each { |_doc| nil }
+
+  col.destroy!
+end
@@ -0,0 +1,302 @@
+# frozen_string_literal: true
+
+# Mixed read/write soak test (rake soak). Runs concurrent query, fetch,
+# upsert, delete, flush and optimize workers against one collection for a
+# fixed time and checks every result. It reports throughput, latency
+# percentiles and RSS once per interval. Worker threads spend their engine
+# calls without the GVL, so they run in parallel natively. --ractors adds
+# Ractor readers that run Ruby-side work in parallel through a
+# SharedCollection.
+#
+#   ruby -Ilib ext/bench/soak.rb --duration 3600 --mix query=8,fetch=4,upsert=4,delete=1,flush=1,optimize=1
+#
+# Checks:
+#   - fetched docs are whole: the vector matches the version stored with it
+#   - versions seen by a reader never go backwards; a writer reads its own write
+#   - query results are unique, sorted, at most top_k, and known pks
+#   - after the run, doc_count matches the writers' live pks
+#   - RSS after warm-up grows by at most --max-rss-growth MB
+#
+# Exits 1 if any check fails.
+
+require "zvec"
+require "json"
+require "optparse"
+require "tmpdir"
+
+options = {
+  duration: 60, interval: 5, docs: 20_000, dim: 64, top_k: 10,
+  mix: "query=4,fetch=2,upsert=2,delete=1,flush=1,optimize=1",
+  ractors: 0, warmup: 0.2, max_rss_growth: 64.0, json: nil, path: nil
+}
+OptionParser.new do |o|
+  o.banner = "usage: soak.rb [options]"
+  o.on("--duration SECONDS", Float, "Run time (default 60)") { |v| options[:duration] = v }
+  o.on("--interval SECONDS", Float, "Report interval (default 5)") { |v| options[:interval] = v }
+  o.on("--docs N", Integer, "Primary key space (default 20000)") { |v| options[:docs] = v }
+  o.on("--dim N", Integer, "Vector dimension (default 64)") { |v| options[:dim] = v }
+  o.on("--mix SPEC", "Workers per op, e.g. query=8,fetch=4,upsert=4") { |v| options[:mix] = v }
+  o.on("--ractors N", Integer, "Extra Ractor query workers (default 0)") { |v| options[:ractors] = v }
+  o.on("--warmup FRACTION", Float, "Share of the run before RSS is judged (default 0.2)") { |v| options[:warmup] = v }
+  o.on("--max-rss-growth MB", Float, "Allowed RSS growth after warm-up (default 64)") { |v| options[:max_rss_growth] = v }
+  o.on("--json PATH", "Also write one JSON object per interval to PATH") { |v| options[:json] = v }
+  o.on("--path DIR", "Collection directory (default: a temp dir)") { |v| options[:path] = v }
+end.parse!
+
+OPS = %w[query fetch upsert delete flush optimize].freeze
+mix = options[:mix].split(",").to_h do |pair|
+  op, n = pair.split("=", 2)
+  raise ArgumentError, "unknown op #{op.inspect} in --mix" unless OPS.include?(op)
+
+  [op, Integer(n)]
+end
+writer_count = mix.fetch("upsert", 0) + mix.fetch("delete", 0)
+abort "--mix needs at least one upsert or delete worker" if writer_count.zero?
+
+DIM = options[:dim]
+DOCS = options[:docs]
+TOP_K = options[:top_k]
+
+def pk_for(i) = "doc-#{i}"
+
+# The vector a doc must hold at a given version
+def vector_for(i, version)
+  rng = Random.new((i * 1_000_003) + version)
+  Array.new(DIM) { rng.rand(-1.0..1.0) }
+end
+
+def make_doc(i, version)
+  doc = Zvec::Doc.new
+  doc.pk = pk_for(i)
+  doc.set_field("pk", Zvec::DataType::STRING, doc.pk)
+  doc.set_field("version", Zvec::DataType::INT64, version)
+  doc.set_field("shard", Zvec::DataType::INT32, i % 16)
+  doc.set_field("embedding", Zvec::DataType::VECTOR_FP32, vector_for(i, version))
+  doc
+end
+
+def rss_mb
+  if File.readable?("/proc/self/status")
+    File.read("/proc/self/status")[/VmRSS:\s+(\d+)/, 1].to_i / 1024.0
+  else
+    `ps -o rss= -p #{Process.pid}`.to_i / 1024.0
+  end
+end
+
+def percentile(sorted, q)
+  return 0.0 if sorted.empty?
+
+  sorted[[(q * sorted.size).ceil - 1, 0].max]
+end
+
+# Latency samples for the current interval and consistency failures
+class Recorder
+  attr_reader :errors, :error_count
+
+  def initialize
+    @mutex = Mutex.new
+    @samples = Hash.new { |h, k| h[k] = [] }
+    @errors = []
+    @error_count = 0
+  end
+
+  def time(op)
+    start = Process.clock_gettime(Process::CLOCK_MONOTONIC)
+    result = yield
+    ms = (Process.clock_gettime(Process::CLOCK_MONOTONIC) - start) * 1000.0
+    @mutex.synchronize { @samples[op] << ms }
+    result
+  end
+
+  def fail(message)
+    @mutex.synchronize do
+      @error_count += 1
+      @errors << message if @errors.size < 20
+    end
+    warn "CONSISTENCY: #{message}" if @error_count <= 20
+  end
+
+  def drain
+    @mutex.synchronize do
+      out = @samples
+      @samples = Hash.new { |h, k| h[k] = [] }
+      out
+    end
+  end
+end
+
+def check_doc(rec, i, doc, last_seen)
+  version = doc.get_field("version", Zvec::DataType::INT64)
+  got = doc.get_field("embedding", Zvec::DataType::VECTOR_FP32)
+  unless got.pack("f*") == vector_for(i, version).pack("f*")
+    rec.fail("#{doc.pk}: vector does not match version #{version}")
+  end
+  if last_seen && last_seen[i] && version < last_seen[i]
+    rec.fail("#{doc.pk}: version went back from #{last_seen[i]} to #{version}")
+  end
+  last_seen[i] = version if last_seen
+  version
+end
+
+def check_results(rec, docs)
+  pks = docs.map(&:pk)
+  rec.fail("query returned #{pks.size} > #{TOP_K} docs") if pks.size > TOP_K
+  rec.fail("query returned duplicate pks") if pks.uniq.size != pks.size
+  rec.fail("query returned unknown pk") unless pks.all? { |pk| pk.start_with?("doc-") && pk[4..].to_i < DOCS }
+  scores = docs.map(&:score)
+  rec.fail("query scores are not ascending (L2)") unless scores.each_cons(2).all? { |a, b| a <= b }
+end
+
+schema = Zvec::CollectionSchema.create("soak", [
+  Zvec::FieldSchema.create("pk", Zvec::DataType::STRING),
+  Zvec::FieldSchema.create("version", Zvec::DataType::INT64),
+  Zvec::FieldSchema.create("shard", Zvec::DataType::INT32,
+    index_params: Zvec::InvertIndexParams.new),
+  Zvec::FieldSchema.create("embedding", Zvec::DataType::VECTOR_FP32, dimension: DIM,
+    index_params: Zvec::HnswIndexParams.new(Zvec::MetricType::L2))
+])
+
+run = lambda do |dir|
+  path = File.join(dir, "soak")
+  col = Zvec::Collection.create_and_open(path, schema)
+  rec = Recorder.new
+
+  # Writer w owns the pks with i % writer_count == w and is the only thread
+  # that writes them, so its versions are the truth for its shard
+  shards = Array.new(writer_count) { |w| (w...DOCS).step(writer_count).to_a }
+  live = Array.new(writer_count) { {} }
+  shards.each_with_index do |ids, w|
+    ids.each_slice(1_000) { |slice| col.upsert(slice.map { |i| make_doc(i, 0) }) }
+    ids.each { |i| live[w][i] = 0 }
+  end
+  col.flush
+
+  stop = false
+  threads = []
+  writer = 0
+  mix.each do |op, count|
+    count.times do |n|
+      w = %w[upsert delete].include?(op) ? (writer += 1) - 1 : nil
+      threads << Thread.new do
+        rng = Random.new(n + (OPS.index(op) * 1000))
+        last_seen = {}
+        until stop
+          case op
+          when "query"
+            vec = Array.new(DIM) { rng.rand(-1.0..1.0) }
+            filter = rng.rand < 0.5 ? "shard = #{rng.rand(16)}" : nil
+            docs = rec.time("query") { col.query_vector("embedding", vec, top_k: TOP_K, filter: filter) }
+            check_results(rec, docs)
+          when "fetch"
+            ids = Array.new(10) { rng.rand(DOCS) }
+            found = rec.time("fetch") { col.fetch(ids.map { |i| pk_for(i) }) }
+            ids.uniq.each { |i| (doc = found[pk_for(i)]) && check_doc(rec, i, doc, last_seen) }
+          when "upsert"
+            i = shards[w].sample(random: rng)
+            version = (live[w][i] || last_seen[i] || 0) + 1
+            rec.time("upsert") { col.upsert([make_doc(i, version)]) }
+            live[w][i] = last_seen[i] = version
+            doc = col.fetch([pk_for(i)])[pk_for(i)]
+            got = doc && doc.get_field("version", Zvec::DataType::INT64)
+            rec.fail("#{pk_for(i)}: wrote version #{version}, read back #{got.inspect}") unless got == version
+          when "delete"
+            i = shards[w].sample(random: rng)
+            if live[w].key?(i)
+              last_seen[i] = live[w].delete(i)
+              rec.time("delete") { col.delete([pk_for(i)]) }
+              rec.fail("#{pk_for(i)}: still visible after delete") if col.fetch([pk_for(i)]).key?(pk_for(i))
+            else
+              version = (last_seen[i] || 0) + 1
+              rec.time("upsert") { col.upsert([make_doc(i, version)]) }
+              live[w][i] = last_seen[i] = version
+            end
+          when "flush"
+            rec.time("flush") { col.flush }
+            sleep 0.5
+          when "optimize"
+            rec.time("optimize") { col.optimize }
+            sleep 2
+          end
+        end
+      rescue => e
+        rec.fail("#{op} worker raised #{e.class}: #{e.message}")
+      end
+    end
+  end
+
+  # Ractor readers run the query loop and return their own totals
+  ractors = Array.new(options[:ractors]) do |r|
+    Warning[:experimental] = false
+    handle = Zvec::SharedCollection.open(path)
+    Ractor.new(handle, options[:duration], DIM, TOP_K, r) do |h, duration, dim, top_k, seed|
+      rng = Random.new(seed)
+      deadline = Process.clock_gettime(Process::CLOCK_MONOTONIC) + duration
+      count = 0
+      bad = 0
+      while Process.clock_gettime(Process::CLOCK_MONOTONIC) < deadline
+        pks = h.query_vector("embedding", Array.new(dim) { rng.rand(-1.0..1.0) }, top_k: top_k).map(&:pk)
+        bad += 1 if pks.size > top_k || pks.uniq.size != pks.size
+        count += 1
+      end
+      [count, bad]
+    end
+  end
+
+  json = options[:json] && File.open(options[:json], "w")
+  rss = []
+  started = Process.clock_gettime(Process::CLOCK_MONOTONIC)
+  loop do
+    elapsed = Process.clock_gettime(Process::CLOCK_MONOTONIC) - started
+    break if elapsed >= options[:duration]
+
+    sleep [options[:interval], options[:duration] - elapsed].min
+    elapsed = Process.clock_gettime(Process::CLOCK_MONOTONIC) - started
+    rss << [elapsed, rss_mb]
+    row = {t: elapsed.round(1), rss_mb: rss.last[1].round(1), errors: rec.error_count, ops: {}}
+    puts format("t=%7.1fs  rss %8.1f MB  errors %d", elapsed, rss.last[1], rec.error_count)
+    rec.drain.sort.each do |op, ms|
+      ms.sort!
+      stats = {count: ms.size, per_s: (ms.size / options[:interval]).round(1),
+               p50: percentile(ms, 0.50).round(3), p95: percentile(ms, 0.95).round(3),
+               p99: percentile(ms, 0.99).round(3), max: ms.last.round(3)}
+      row[:ops][op] = stats
+      puts format("  %-9s %8.1f ops/s  p50 %8.3f  p95 %8.3f  p99 %8.3f  max %9.3f ms",
+                  op, stats[:per_s], stats[:p50], stats[:p95], stats[:p99], stats[:max])
+    end
+    json&.puts(JSON.generate(row))
+  end
+
+  stop = true
+  threads.each(&:join)
+  ractors.each_with_index do |r, n|
+    count, bad = r.value
+    puts format("  ractor %-2d %8.1f queries/s", n, count / options[:duration])
+    bad.times { rec.fail("ractor #{n}: malformed query result") }
+  end
+  Zvec::Collection.close_shared(path) if options[:ractors].positive?
+  json&.close
+
+  col.flush
+  expected = live.sum(&:size)
+  actual = col.stats.doc_count
+  rec.fail("doc_count #{actual}, writers expect #{expected}") unless actual == expected
+
+  # Compare the first and last thirds after warm-up, so one-off growth such
+  # as an index build or page cache fill-in is not mistaken for a leak
+  judged = rss.select { |t, _| t >= options[:duration] * options[:warmup] }.map(&:last)
+  growth = 0.0
+  if judged.size >= 3
+    third = judged.size / 3
+    median = ->(a) { a.sort[a.size / 2] }
+    growth = median.call(judged.last(third)) - median.call(judged.first(third))
+  end
+  puts format("rss growth after warm-up: %.1f MB (limit %.1f)", growth, options[:max_rss_growth])
+  leaked = growth > options[:max_rss_growth]
+
+  col.destroy!
+  puts "consistency errors: #{rec.error_count}"
+  rec.error_count.zero? && !leaked
+end
+
+ok = options[:path] ? run.call(options[:path]) : Dir.mktmpdir("zvec-soak") { |dir| run.call(dir) }
+exit(ok ? 0 : 1)
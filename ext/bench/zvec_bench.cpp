@@ -0,0 +1,245 @@
+// Native micro-benchmarks for the binding's bulk kernels.
+//
+//   cmake --preset macos-release -DZVEC_BUILD_BENCH=ON
+//   cmake --build build/macos-release --target zvec_bench
+//   ./build/macos-release/zvec_bench [dimension] [vectors]
+//
+// Every dispatched kernel is checked against its scalar reference before it
+// is timed, so a wrong SIMD path fails loudly instead of looking fast.
+
+#include "zvec_arena.hpp"
+#include "zvec_kernels.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <new>
+#include <vector>
+
+namespace kernels = zvec_rb::kernels;
+
+// Every heap allocation in the process, for the allocations-per-doc report
+static std::atomic<size_t> g_allocations{0};
+
+void* operator new(size_t n) {
+  g_allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void* p = std::malloc(n ? n : 1)) return p;
+  throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+namespace {
+
+template <typename F>
+double time_per_element_ns(size_t elements, F&& fn) {
+  // Warm up, then take the best of a few runs
+  fn();
+  double best = 1e300;
+  for (int run = 0; run < 5; run++) {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    auto end = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(end - start).count();
+    if (ns < best) best = ns;
+  }
+  return best / static_cast<double>(elements);
+}
+
+void report(const char* name, double scalar_ns, double simd_ns) {
+  std::printf("  %-18s scalar %7.3f ns/elem   %-7s %7.3f ns/elem   %5.1fx\n",
+              name, scalar_ns, kernels::isa(), simd_ns, scalar_ns / simd_ns);
+}
+
+[[noreturn]] void fail(const char* what) {
+  std::fprintf(stderr, "MISMATCH: %s differs from the scalar reference\n", what);
+  std::exit(1);
+}
+
+void bench_fp16(size_t n) {
+  std::mt19937 rng(42);
+  std::normal_distribution<float> dist(0.0f, 4.0f);
+  std::vector<float> src(n);
+  for (auto& v : src) v = dist(rng);
+
+  std::vector<uint16_t> ref_h(n), h(n);
+  std::vector<float> ref_f(n), f(n);
+  kernels::scalar::f32_to_f16(src.data(), ref_h.data(), n);
+  kernels::f32_to_f16(src.data(), h.data(), n);
+  if (ref_h != h) fail("f32_to_f16");
+  kernels::scalar::f16_to_f32(h.data(), ref_f.data(), n);
+  kernels::f16_to_f32(h.data(), f.data(), n);
+  if (std::memcmp(ref_f.data(), f.data(), n * sizeof(float)) != 0) fail("f16_to_f32");
+
+  report("f32 -> f16",
+         time_per_element_ns(n, [&] { kernels::scalar::f32_to_f16(src.data(), h.data(), n); }),
+         time_per_element_ns(n, [&] { kernels::f32_to_f16(src.data(), h.data(), n); }));
+  report("f16 -> f32",
+         time_per_element_ns(n, [&] { kernels::scalar::f16_to_f32(h.data(), f.data(), n); }),
+         time_per_element_ns(n, [&] { kernels::f16_to_f32(h.data(), f.data(), n); }));
+}
+
+void bench_int4(size_t n) {
+  std::mt19937 rng(7);
+  std::uniform_int_distribution<int> dist(-8, 7);
+  std::vector<int8_t> src(n);
+  for (auto& v : src) v = static_cast<int8_t>(dist(rng));
+
+  std::vector<uint8_t> ref_p(kernels::int4_packed_size(n)), p(kernels::int4_packed_size(n));
+  std::vector<int8_t> out(n);
+  kernels::scalar::pack_int4(src.data(), ref_p.data(), n);
+  kernels::pack_int4(src.data(), p.data(), n);
+  if (ref_p != p) fail("pack_int4");
+  kernels::unpack_int4(p.data(), out.data(), n);
+  if (out != src) fail("unpack_int4");
+
+  report("int8 -> int4",
+         time_per_element_ns(n, [&] { kernels::scalar::pack_int4(src.data(), p.data(), n); }),
+         time_per_element_ns(n, [&] { kernels::pack_int4(src.data(), p.data(), n); }));
+  report("int4 -> int8",
+         time_per_element_ns(n, [&] { kernels::scalar::unpack_int4(p.data(), out.data(), n); }),
+         time_per_element_ns(n, [&] { kernels::unpack_int4(p.data(), out.data(), n); }));
+}
+
+// Distances reassociate the sum, so compare with a relative tolerance
+void bench_distance(size_t dim, size_t count) {
+  std::mt19937 rng(11);
+  std::normal_distribution<float> dist(0.0f, 1.0f);
+  std::vector<float> base(dim * count), query(dim);
+  for (auto& v : base) v = dist(rng);
+  for (auto& v : query) v = dist(rng);
+
+  for (size_t r = 0; r < count; r++) {
+    const float* row = base.data() + r * dim;
+    float ref_d = kernels::scalar::dot(query.data(), row, dim);
+    float ref_l = kernels::scalar::l2_sqr(query.data(), row, dim);
+    if (std::fabs(kernels::dot(query.data(), row, dim) - ref_d) > 1e-3f * (1.0f + std::fabs(ref_d))) fail("dot");
+    if (std::fabs(kernels::l2_sqr(query.data(), row, dim) - ref_l) > 1e-3f * (1.0f + ref_l)) fail("l2_sqr");
+  }
+
+  volatile float sink = 0.0f;
+  auto scan = [&](float (*fn)(const float*, const float*, size_t)) {
+    float acc = 0.0f;
+    for (size_t r = 0; r < count; r++) acc += fn(query.data(), base.data() + r * dim, dim);
+    sink = acc;
+  };
+  size_t n = dim * count;
+  report("dot", time_per_element_ns(n, [&] { scan(kernels::scalar::dot); }),
+         time_per_element_ns(n, [&] { scan(kernels::dot); }));
+  report("l2_sqr", time_per_element_ns(n, [&] { scan(kernels::scalar::l2_sqr); }),
+         time_per_element_ns(n, [&] { scan(kernels::l2_sqr); }));
+  (void)sink;
+}
+
+// A batch of queries scored as one blocked tile, versus the same batch as
+// independent dispatched dot products
+void bench_dot_tile(size_t dim, size_t count) {
+  const size_t nq = 64;
+  std::mt19937 rng(13);
+  std::normal_distribution<float> dist(0.0f, 1.0f);
+  std::vector<float> base(dim * count), queries(dim * nq);
+  for (auto& v : base) v = dist(rng);
+  for (auto& v : queries) v = dist(rng);
+
+  std::vector<float> ref(nq * count), out(nq * count);
+  kernels::scalar::dot_tile(queries.data(), nq, base.data(), count, dim, ref.data());
+  kernels::dot_tile(queries.data(), nq, base.data(), count, dim, out.data());
+  for (size_t i = 0; i < ref.size(); i++) {
+    if (std::fabs(out[i] - ref[i]) > 1e-3f * (1.0f + std::fabs(ref[i]))) fail("dot_tile");
+  }
+
+  auto per_query = [&] {
+    for (size_t i = 0; i < nq; i++) {
+      for (size_t j = 0; j < count; j++) {
+        out[i * count + j] = kernels::dot(queries.data() + i * dim, base.data() + j * dim, dim);
+      }
+    }
+  };
+  size_t n = dim * count * nq;
+  report("dot_tile (64 q)",
+         time_per_element_ns(n, [&] { kernels::scalar::dot_tile(queries.data(), nq, base.data(), count, dim, out.data()); }),
+         time_per_element_ns(n, [&] { kernels::dot_tile(queries.data(), nq, base.data(), count, dim, out.data()); }));
+  std::printf("  %-18s %-7s %7.3f ns/elem (independent dot calls)\n", "", kernels::isa(),
+              time_per_element_ns(n, per_query));
+}
+
+// Native side of converting one document with an FP16 vector, an INT4
+// vector and a sparse vector, as DocBuilder#build_many does it. The FP16 and
+// INT4 outputs and the sparse pair are stored in the Doc, so they are heap
+// allocations either way. Before: staging buffers came from the heap and the
+// sparse pair grew by push_back. After: staging comes from the per-call
+// ScratchArena and the sparse pair is reserved up front.
+void bench_conversion_allocs(size_t dim, size_t rows) {
+  const size_t nnz = dim / 8;
+  std::mt19937 rng(17);
+  std::normal_distribution<float> dist(0.0f, 1.0f);
+  std::vector<float> src(dim);
+  for (auto& v : src) v = dist(rng);
+  std::vector<int8_t> src_i(dim);
+  for (size_t i = 0; i < dim; i++) src_i[i] = static_cast<int8_t>(static_cast<int>(i % 16) - 8);
+
+  volatile size_t sink = 0;
+  auto convert = [&](std::pmr::memory_resource* scratch, bool reserve) {
+    std::pmr::vector<float> staging(dim, scratch);
+    std::memcpy(staging.data(), src.data(), dim * sizeof(float));
+    std::vector<uint16_t> fp16(dim);
+    kernels::f32_to_f16(staging.data(), fp16.data(), dim);
+
+    std::pmr::vector<int8_t> staging_i(dim, scratch);
+    std::memcpy(staging_i.data(), src_i.data(), dim);
+    std::vector<uint8_t> int4(kernels::int4_packed_size(dim));
+    kernels::pack_int4(staging_i.data(), int4.data(), dim);
+
+    std::vector<uint32_t> indices;
+    std::vector<float> values;
+    if (reserve) {
+      indices.reserve(nnz);
+      values.reserve(nnz);
+    }
+    for (size_t i = 0; i < nnz; i++) {
+      indices.push_back(static_cast<uint32_t>(i * 8));
+      values.push_back(src[i]);
+    }
+    sink = sink + fp16[0] + int4[0] + indices.size();
+  };
+
+  auto run = [&](bool arena_on) {
+    size_t before = g_allocations.load();
+    auto start = std::chrono::steady_clock::now();
+    zvec_rb::ScratchArena arena;
+    for (size_t r = 0; r < rows; r++) {
+      convert(arena_on ? arena.resource() : std::pmr::new_delete_resource(), arena_on);
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    std::printf("  %-18s %7.2f allocs/doc   %9.1f ns/doc\n", arena_on ? "arena + reserve" : "heap staging",
+                static_cast<double>(g_allocations.load() - before) / static_cast<double>(rows),
+                ns / static_cast<double>(rows));
+  };
+  run(false);
+  run(true);
+  (void)sink;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  size_t dim = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 768;
+  size_t count = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 10000;
+  size_t n = dim * count;
+
+  std::printf("zvec_bench: %zu vectors x %zu dims, dispatch=%s\n", count, dim, kernels::isa());
+  std::printf("conversion kernels\n");
+  bench_fp16(n);
+  bench_int4(n);
+  std::printf("distance kernels\n");
+  bench_distance(dim, count);
+  bench_dot_tile(dim, count);
+  std::printf("doc conversion (fp16 + int4 + sparse, %zu rows)\n", count);
+  bench_conversion_allocs(dim, count);
+  return 0;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+
+namespace zvec_rb {
+
+// Scratch memory for one batch conversion call. Staging buffers come from a
+// pool that sits on a monotonic arena starting in an inline block, so once
+// the first rows have sized the pool, later rows take their staging buffers
+// without touching malloc. Everything goes back to the heap when the arena
+// leaves scope. Not thread-safe: one arena per call.
+class ScratchArena {
+ public:
+  ScratchArena() : mono_(inline_, sizeof(inline_)), pool_(pool_options(), &mono_) {}
+
+  ScratchArena(const ScratchArena&) = delete;
+  ScratchArena& operator=(const ScratchArena&) = delete;
+
+  std::pmr::memory_resource* resource() { return &pool_; }
+
+ private:
+  static std::pmr::pool_options pool_options() {
+    std::pmr::pool_options opts;
+    // Pooled up to a 64K-dim float32 staging buffer; larger ones go to the
+    // arena directly and are only reclaimed at the end of the call
+    opts.largest_required_pool_block = 256 * 1024;
+    return opts;
+  }
+
+  alignas(std::max_align_t) std::byte inline_[8 * 1024];
+  std::pmr::monotonic_buffer_resource mono_;
+  std::pmr::unsynchronized_pool_resource pool_;
+};
+
+}  // namespace zvec_rb
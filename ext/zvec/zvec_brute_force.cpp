@@ -0,0 +1,209 @@
+#include "zvec_brute_force.hpp"
+#include "zvec_cursor.hpp"
+#include "zvec_kernels.hpp"
+#include "zvec_pool.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace Rice;
+
+namespace zvec_rb {
+
+// Tile sizes: a vector tile (kTileVectors x dim floats) stays in L2 while
+// every query block is scored against it
+static const size_t kTileVectors = 128;
+static const size_t kTileQueries = 32;
+
+zvec::Status load_field_vectors(const zvec::Collection& collection, const zvec::FieldSchema& field,
+                                const std::string& filter, uint32_t batch_size,
+                                std::vector<float>& data, std::vector<std::string>& pks) {
+  zvec::DataType dt = field.data_type();
+  if (dt != zvec::DataType::VECTOR_FP32 && dt != zvec::DataType::VECTOR_FP16)
+    throw std::invalid_argument("field must be VECTOR_FP32 or VECTOR_FP16");
+  if (batch_size == 0) throw std::invalid_argument("batch_size must be positive");
+  const uint32_t dim = field.dimension();
+
+  zvec::VectorQuery q;
+  q.filter_ = filter;
+  q.include_vector_ = true;
+  q.output_fields_ = std::vector<std::string>{field.name()};
+  ScanPager pager(std::move(q), batch_size);
+
+  std::vector<zvec::Doc::Ptr> docs;
+  for (bool last = false; !last;) {
+    zvec::Status status = pager.next(collection, docs, last);
+    if (!status.ok()) return status;
+    for (auto& doc : docs) {
+      size_t offset = data.size();
+      if (dt == zvec::DataType::VECTOR_FP32) {
+        auto v = doc->get<std::vector<float>>(field.name());
+        if (!v || v->size() != dim) continue;
+        data.insert(data.end(), v->begin(), v->end());
+      } else {
+        auto v = doc->get<std::vector<zvec::ailego::Float16>>(field.name());
+        if (!v || v->size() != dim) continue;
+        data.resize(offset + dim);
+        kernels::f16_to_f32(reinterpret_cast<const uint16_t*>(v->data()), data.data() + offset, dim);
+      }
+      pks.push_back(doc->pk());
+    }
+  }
+  return zvec::Status();
+}
+
+zvec::Status BruteForceIndex::load(const zvec::Collection& collection, const zvec::FieldSchema& field,
+                                   zvec::MetricType metric, const std::string& filter,
+                                   uint32_t batch_size, std::unique_ptr<BruteForceIndex>& out) {
+  if (metric == zvec::MetricType::UNDEFINED) metric = zvec::MetricType::L2;
+  if (metric == zvec::MetricType::MIPSL2) metric = zvec::MetricType::IP;
+
+  std::unique_ptr<BruteForceIndex> index(new BruteForceIndex(field.name(), field.dimension(), metric));
+  const uint32_t dim = index->dim_;
+  zvec::Status status = load_field_vectors(collection, field, filter, batch_size, index->data_, index->pks_);
+  if (!status.ok()) return status;
+
+  size_t n = index->pks_.size();
+  if (metric == zvec::MetricType::COSINE) {
+    for (size_t r = 0; r < n; r++) kernels::normalize(index->data_.data() + r * dim, dim);
+  } else if (metric == zvec::MetricType::L2) {
+    index->norms_.resize(n);
+    for (size_t r = 0; r < n; r++) {
+      const float* row = index->data_.data() + r * dim;
+      index->norms_[r] = kernels::dot(row, row, dim);
+    }
+  }
+  out = std::move(index);
+  return zvec::Status();
+}
+
+std::vector<std::vector<BruteForceIndex::Hit>> BruteForceIndex::search(const float* queries, size_t nq,
+                                                                       size_t topk,
+                                                                       size_t concurrency) const {
+  std::vector<std::vector<Hit>> results(nq);
+  size_t n = pks_.size();
+  if (nq == 0 || n == 0 || topk == 0) return results;
+
+  std::vector<float> q(queries, queries + nq * dim_);
+  std::vector<float> qnorms(nq, 0.0f);
+  for (size_t i = 0; i < nq; i++) {
+    float* row = q.data() + i * dim_;
+    if (metric_ == zvec::MetricType::COSINE) kernels::normalize(row, dim_);
+    if (metric_ == zvec::MetricType::L2) qnorms[i] = kernels::dot(row, row, dim_);
+  }
+
+  // Heaps keep the topk smallest keys; inner product is negated so every
+  // metric ranks ascending
+  bool negate = metric_ == zvec::MetricType::IP;
+  auto worse = [](const Hit& a, const Hit& b) { return a.score < b.score; };
+  auto offer = [&](std::vector<Hit>& heap, Hit h) {
+    if (heap.size() < topk) {
+      heap.push_back(h);
+      std::push_heap(heap.begin(), heap.end(), worse);
+    } else if (h.score < heap.front().score) {
+      std::pop_heap(heap.begin(), heap.end(), worse);
+      heap.back() = h;
+      std::push_heap(heap.begin(), heap.end(), worse);
+    }
+  };
+
+  size_t tiles = (n + kTileVectors - 1) / kTileVectors;
+  size_t threads = std::max<size_t>(1, std::min(thread_count(concurrency), tiles));
+  std::vector<std::vector<std::vector<Hit>>> heaps(threads, std::vector<std::vector<Hit>>(nq));
+  std::vector<std::vector<float>> scratch(threads);
+
+  parallel_for(tiles, threads, [&](size_t w, size_t t) {
+    auto& scores = scratch[w];
+    scores.resize(kTileQueries * kTileVectors);
+    auto& mine = heaps[w];
+    size_t x0 = t * kTileVectors;
+    size_t nx = std::min(kTileVectors, n - x0);
+    const float* x = data_.data() + x0 * dim_;
+    for (size_t q0 = 0; q0 < nq; q0 += kTileQueries) {
+      size_t bq = std::min(kTileQueries, nq - q0);
+      kernels::dot_tile(q.data() + q0 * dim_, bq, x, nx, dim_, scores.data());
+      for (size_t i = 0; i < bq; i++) {
+        const float* s = scores.data() + i * nx;
+        for (size_t j = 0; j < nx; j++) {
+          float key;
+          if (metric_ == zvec::MetricType::L2) key = std::max(0.0f, qnorms[q0 + i] + norms_[x0 + j] - 2.0f * s[j]);
+          else if (metric_ == zvec::MetricType::COSINE) key = 1.0f - s[j];
+          else key = -s[j];
+          offer(mine[q0 + i], Hit{static_cast<uint32_t>(x0 + j), key});
+        }
+      }
+    }
+  });
+
+  for (size_t i = 0; i < nq; i++) {
+    auto& out = results[i];
+    for (auto& per_worker : heaps) {
+      for (const Hit& h : per_worker[i]) offer(out, h);
+    }
+    std::sort(out.begin(), out.end(), [](const Hit& a, const Hit& b) {
+      return a.score < b.score || (a.score == b.score && a.row < b.row);
+    });
+    if (negate) {
+      for (Hit& h : out) h.score = -h.score;
+    }
+  }
+  return results;
+}
+
+std::vector<float> float_matrix(Rice::Object queries, uint32_t dim, size_t& nq) {
+  VALUE v = queries.value();
+  std::vector<float> out;
+  if (RB_TYPE_P(v, T_STRING)) {
+    size_t len = static_cast<size_t>(RSTRING_LEN(v));
+    if (dim == 0 || len % (dim * sizeof(float)) != 0)
+      throw std::invalid_argument("packed vectors must be a multiple of dimension * 4 bytes");
+    nq = len / (dim * sizeof(float));
+    out.resize(nq * dim);
+    std::memcpy(out.data(), RSTRING_PTR(v), len);
+    return out;
+  }
+  Rice::Array rows(queries);
+  nq = rows.size();
+  out.reserve(nq * dim);
+  for (size_t i = 0; i < nq; i++) {
+    Rice::Array row(rows[i]);
+    if (row.size() != dim) throw std::invalid_argument("vector dimension does not match field");
+    for (size_t k = 0; k < dim; k++) out.push_back(Rice::detail::From_Ruby<float>().convert(row[k].value()));
+  }
+  return out;
+}
+
+}  // namespace zvec_rb
+
+using zvec_rb::BruteForceIndex;
+
+void init_zvec_brute_force(Rice::Module& m) {
+  Rice::define_class_under<BruteForceIndex>(m, "BruteForceIndex")
+    .define_method("size", &BruteForceIndex::size)
+    .define_method("dimension", &BruteForceIndex::dimension)
+    .define_method("metric", &BruteForceIndex::metric)
+    .define_method("field", &BruteForceIndex::field)
+    // One Array of [pk, score] per query, best first
+    .define_method("search", [](const BruteForceIndex& index, Rice::Object queries,
+                                uint32_t topk, uint32_t concurrency) {
+      size_t nq = 0;
+      std::vector<float> q = zvec_rb::float_matrix(queries, index.dimension(), nq);
+      std::vector<std::vector<BruteForceIndex::Hit>> hits;
+      zvec_rb::without_gvl([&] { hits = index.search(q.data(), nq, topk, concurrency); });
+      Rice::Array out;
+      for (const auto& list : hits) {
+        Rice::Array row;
+        for (const auto& h : list) {
+          Rice::Array pair;
+          pair.push(index.pk(h.row));
+          pair.push(h.score);
+          row.push(pair);
+        }
+        out.push(row);
+      }
+      return out;
+    },
+      Rice::Arg("queries"),
+      Rice::Arg("topk") = (uint32_t)10,
+      Rice::Arg("concurrency") = (uint32_t)0);
+}
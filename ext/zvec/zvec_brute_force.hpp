@@ -0,0 +1,59 @@
+#pragma once
+
+#include "zvec_common.hpp"
+
+namespace zvec_rb {
+
+// Append every vector of a VECTOR_FP32/FP16 field matching filter to data
+// (row-major float32) and its pk to pks, reading through scan pages. Rows
+// with a missing or mis-sized vector are skipped. No Ruby calls.
+zvec::Status load_field_vectors(const zvec::Collection& collection, const zvec::FieldSchema& field,
+                                const std::string& filter, uint32_t batch_size,
+                                std::vector<float>& data, std::vector<std::string>& pks);
+
+// Exact k-NN over an in-memory copy of one dense vector field. A batch of
+// queries is scored as blocked query x vector tiles with the dot_tile kernel
+// on a thread pool, each worker keeping a bounded heap per query, instead of
+// running one engine scan per query. Meant for Flat-sized catalogs and for
+// ground truth in recall checks.
+class BruteForceIndex {
+ public:
+  struct Hit {
+    uint32_t row;
+    float score;
+  };
+
+  // Read every vector of field (FP32 or FP16) matching filter through scan
+  // pages. No Ruby calls, so it may run without the GVL.
+  static zvec::Status load(const zvec::Collection& collection, const zvec::FieldSchema& field,
+                           zvec::MetricType metric, const std::string& filter, uint32_t batch_size,
+                           std::unique_ptr<BruteForceIndex>& out);
+
+  // queries is nq x dimension() row-major. Hits per query are best first:
+  // inner product descending, squared L2 and 1 - cosine ascending.
+  std::vector<std::vector<Hit>> search(const float* queries, size_t nq, size_t topk,
+                                       size_t concurrency) const;
+
+  size_t size() const { return pks_.size(); }
+  uint32_t dimension() const { return dim_; }
+  zvec::MetricType metric() const { return metric_; }
+  const std::string& field() const { return field_; }
+  const std::string& pk(uint32_t row) const { return pks_[row]; }
+
+ private:
+  BruteForceIndex(std::string field, uint32_t dim, zvec::MetricType metric)
+      : field_(std::move(field)), dim_(dim), metric_(metric) {}
+
+  std::string field_;
+  uint32_t dim_;
+  zvec::MetricType metric_;
+  std::vector<float> data_;   // size() x dim_, unit length for COSINE
+  std::vector<float> norms_;  // squared norms, for L2
+  std::vector<std::string> pks_;
+};
+
+// Row-major float32 matrix from an Array of Arrays or one packed float32
+// String, each row dim wide; rows is set to the row count
+std::vector<float> float_matrix(Rice::Object rows, uint32_t dim, size_t& count);
+
+}  // namespace zvec_rb
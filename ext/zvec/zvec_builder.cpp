@@ -0,0 +1,200 @@
+#include "zvec_builder.hpp"
+#include "zvec_doc_builder.hpp"
+
+#include <filesystem>
+
+using namespace Rice;
+
+namespace fs = std::filesystem;
+
+namespace zvec_rb {
+
+using Clock = std::chrono::steady_clock;
+
+static uint32_t all_cores() { return std::max(1u, std::thread::hardware_concurrency()); }
+
+CollectionBuilder* CollectionBuilder::create(const std::string& path, const zvec::CollectionSchema& schema,
+                                             const zvec::CollectionOptions& options, uint32_t concurrency,
+                                             zvec::Status& status) {
+  if (fs::exists(path)) throw std::invalid_argument("path already exists: " + path);
+  std::string partial = path + ".partial";
+  // Left over from a build that never finished
+  if (fs::exists(partial)) fs::remove_all(partial);
+
+  zvec::CollectionOptions opts = options;
+  opts.read_only_ = false;
+  auto created = zvec::Collection::CreateAndOpen(partial, schema, opts);
+  if (!created.has_value()) {
+    status = created.error();
+    return nullptr;
+  }
+  return new CollectionBuilder(path, std::move(created.value()), concurrency ? concurrency : all_cores());
+}
+
+CollectionBuilder::CollectionBuilder(std::string path, zvec::Collection::Ptr collection, uint32_t concurrency)
+    : path_(std::move(path)),
+      partial_(path_ + ".partial"),
+      collection_(std::move(collection)),
+      concurrency_(concurrency),
+      started_(Clock::now()) {
+  for (uint32_t i = 0; i < concurrency_; i++) writers_.emplace_back([this] { writer(); });
+}
+
+CollectionBuilder::~CollectionBuilder() {
+  // Dropped without finish or abort, possibly during GC: don't write the
+  // queued batches, only wait for the ones already in the engine. Whatever
+  // was written stays in .partial for the next builder to remove.
+  stop(true);
+}
+
+void CollectionBuilder::writer() {
+  for (;;) {
+    std::vector<zvec::Doc> docs;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      ready_.wait(lock, [&] { return closing_ || !queue_.empty(); });
+      if (queue_.empty()) return;
+      docs = std::move(queue_.front());
+      queue_.pop_front();
+      room_.notify_one();
+    }
+
+    auto result = collection_->Insert(docs);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!result.has_value()) {
+      if (error_.ok()) error_ = result.error();
+      failed_ += docs.size();
+      continue;
+    }
+    const auto& statuses = result.value();
+    for (size_t i = 0; i < statuses.size(); i++) {
+      if (statuses[i].ok()) {
+        written_++;
+        continue;
+      }
+      if (failed_++ == 0) first_failure_ = docs[i].pk() + ": " + statuses[i].message();
+    }
+  }
+}
+
+zvec::Status CollectionBuilder::add(std::vector<zvec::Doc> docs) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  room_.wait(lock, [&] { return closing_ || queue_.size() < concurrency_; });
+  if (closing_) return error_.ok() ? zvec::Status::InvalidArgument("builder is finished") : error_;
+  if (!error_.ok()) return error_;
+  queue_.push_back(std::move(docs));
+  ready_.notify_one();
+  return zvec::Status();
+}
+
+zvec::Status CollectionBuilder::stop(bool discard) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    closing_ = true;
+    if (discard) queue_.clear();
+  }
+  ready_.notify_all();
+  room_.notify_all();
+  for (auto& t : writers_) t.join();
+  writers_.clear();
+  std::lock_guard<std::mutex> lock(mutex_);
+  return error_;
+}
+
+zvec::Status CollectionBuilder::finish() {
+  if (finished_ || !collection_) return zvec::Status::InvalidArgument("builder is finished");
+  zvec::Status status = stop(false);
+  if (!status.ok()) return status;
+  ingest_ms_ = ms_since(started_);
+
+  auto start = Clock::now();
+  status = collection_->Flush();
+  if (status.ok()) status = collection_->Optimize(zvec::OptimizeOptions{static_cast<int>(all_cores())});
+  if (status.ok()) status = collection_->Flush();
+  optimize_ms_ = ms_since(start);
+  if (!status.ok()) return status;
+
+  // Close before the rename so no file handle points into .partial
+  collection_.reset();
+  std::error_code ec;
+  fs::rename(partial_, path_, ec);
+  if (ec) return zvec::Status::InvalidArgument("rename " + partial_ + " -> " + path_ + ": " + ec.message());
+  finished_ = true;
+  return zvec::Status();
+}
+
+zvec::Status CollectionBuilder::abort() {
+  stop(true);
+  if (!collection_) return zvec::Status();
+  zvec::Status status = collection_->Destroy();
+  collection_.reset();
+  std::error_code ec;
+  fs::remove_all(partial_, ec);
+  return status;
+}
+
+std::string CollectionBuilder::first_failure() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return first_failure_;
+}
+
+}  // namespace zvec_rb
+
+using zvec_rb::CollectionBuilder;
+
+void init_zvec_builder(Rice::Module& m) {
+  Rice::define_class_under<CollectionBuilder>(m, "CollectionBuilder")
+    .define_singleton_function("create", [](const std::string& path,
+                                            const zvec::CollectionSchema& schema,
+                                            uint32_t concurrency,
+                                            Rice::Object opts_obj) -> CollectionBuilder* {
+      zvec::CollectionOptions opts;
+      if (!opts_obj.is_nil()) {
+        opts = Rice::detail::From_Ruby<zvec::CollectionOptions>().convert(opts_obj.value());
+      }
+      zvec::Status status;
+      CollectionBuilder* builder = nullptr;
+      zvec_rb::without_gvl([&] {
+        builder = CollectionBuilder::create(path, schema, opts, concurrency, status);
+      });
+      zvec_rb::throw_if_error(status);
+      return builder;
+    },
+      Rice::Return().takeOwnership(),
+      Rice::Arg("path"),
+      Rice::Arg("schema"),
+      Rice::Arg("concurrency") = (uint32_t)0,
+      Rice::Arg("options") = Rice::Object(Qnil))
+    .define_method("path", &CollectionBuilder::path)
+    .define_method("partial_path", &CollectionBuilder::partial_path)
+    .define_method("finished?", &CollectionBuilder::finished)
+    .define_method("docs_written", &CollectionBuilder::docs_written)
+    .define_method("docs_failed", &CollectionBuilder::docs_failed)
+    // "pk: message" of the first rejected row, or nil
+    .define_method("first_failure", [](const CollectionBuilder& b) -> Rice::Object {
+      std::string f = b.first_failure();
+      return f.empty() ? Rice::Object(Qnil) : Rice::Object(Rice::String(f));
+    })
+    .define_method("ingest_ms", &CollectionBuilder::ingest_ms)
+    .define_method("optimize_ms", &CollectionBuilder::optimize_ms)
+    // Array of Doc or a DocBatch
+    .define_method("add", [](CollectionBuilder& b, Rice::Object docs) {
+      std::vector<zvec::Doc> batch = zvec_rb::WriteDocs(docs).take();
+      size_t n = batch.size();
+      zvec::Status status;
+      zvec_rb::without_gvl([&] { status = b.add(std::move(batch)); });
+      zvec_rb::throw_if_error(status);
+      return n;
+    })
+    .define_method("finish", [](CollectionBuilder& b) {
+      zvec::Status status;
+      zvec_rb::without_gvl([&] { status = b.finish(); });
+      zvec_rb::throw_if_error(status);
+      return b.path();
+    })
+    .define_method("abort", [](CollectionBuilder& b) {
+      zvec::Status status;
+      zvec_rb::without_gvl([&] { status = b.abort(); });
+      zvec_rb::throw_if_error(status);
+    });
+}
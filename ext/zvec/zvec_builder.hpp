@@ -0,0 +1,76 @@
+#pragma once
+
+#include "zvec_common.hpp"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace zvec_rb {
+
+// Offline bulk load into a fresh directory. The collection is created at
+// <path>.partial and fed by a pool of writer threads. No reader touches it,
+// so there is no flush per batch and no scheduler gating. finish() flushes
+// once, optimizes (builds indexes) with every core, closes the collection
+// and renames it to <path> in one step. A crashed or aborted build leaves
+// only the .partial directory behind.
+class CollectionBuilder {
+ public:
+  // Engine failures are returned in status; argument errors throw
+  static CollectionBuilder* create(const std::string& path, const zvec::CollectionSchema& schema,
+                                   const zvec::CollectionOptions& options, uint32_t concurrency,
+                                   zvec::Status& status);
+  ~CollectionBuilder();
+
+  CollectionBuilder(const CollectionBuilder&) = delete;
+  CollectionBuilder& operator=(const CollectionBuilder&) = delete;
+
+  // Queue a batch for the writers, blocking while every writer is busy and
+  // one batch per writer is already waiting. Returns the first engine error
+  // seen so far. No Ruby calls, so it may run without the GVL.
+  zvec::Status add(std::vector<zvec::Doc> docs);
+  // Wait for the writers, then flush, optimize and rename
+  zvec::Status finish();
+  // Drop queued batches, stop the writers and remove the partial directory
+  zvec::Status abort();
+
+  const std::string& path() const { return path_; }
+  const std::string& partial_path() const { return partial_; }
+  bool finished() const { return finished_; }
+  uint64_t docs_written() const { return written_; }
+  uint64_t docs_failed() const { return failed_; }
+  std::string first_failure() const;
+  double ingest_ms() const { return ingest_ms_; }
+  double optimize_ms() const { return optimize_ms_; }
+
+ private:
+  CollectionBuilder(std::string path, zvec::Collection::Ptr collection, uint32_t concurrency);
+
+  void writer();
+  // Close the queue and join the writers; discard drops batches still queued
+  zvec::Status stop(bool discard);
+
+  std::string path_;
+  std::string partial_;
+  zvec::Collection::Ptr collection_;
+  uint32_t concurrency_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable ready_;  // queue gained a batch or closed
+  std::condition_variable room_;   // queue has space
+  std::deque<std::vector<zvec::Doc>> queue_;
+  bool closing_ = false;
+  bool finished_ = false;
+  zvec::Status error_;
+  std::string first_failure_;
+  std::vector<std::thread> writers_;
+
+  std::atomic<uint64_t> written_{0};
+  std::atomic<uint64_t> failed_{0};
+  std::chrono::steady_clock::time_point started_;
+  double ingest_ms_ = 0;
+  double optimize_ms_ = 0;
+};
+
+}  // namespace zvec_rb
@@ -1,18 +1,268 @@
 #include "zvec_common.hpp"
+#include "zvec_brute_force.hpp"
+#include "zvec_cursor.hpp"
+#include "zvec_dedup.hpp"
+#include "zvec_doc_builder.hpp"
+#include "zvec_group_results.hpp"
+#include "zvec_instrument.hpp"
+#include "zvec_ivf.hpp"
+#include "zvec_kernels.hpp"
+#include "zvec_maxsim.hpp"
+#include "zvec_open.hpp"
+#include "zvec_profile.hpp"
+#include "zvec_refine.hpp"
+#include "zvec_scheduler.hpp"
+#include "zvec_snapshot.hpp"
+#include "zvec_stats.hpp"
+#include "zvec_write_result.hpp"
+
+#include <cstring>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
 
 using namespace Rice;
 
+namespace zvec_rb {
+
+// Collections opened through the bindings, keyed by engine object. The state
+// holds a weak reference so the registry never extends a collection's lifetime.
+static std::mutex g_collections_mutex;
+static std::unordered_map<const zvec::Collection*, std::shared_ptr<CollectionState>> g_collections;
+
+zvec::Collection::Ptr register_collection(zvec::Collection::Ptr collection) {
+  std::lock_guard<std::mutex> lock(g_collections_mutex);
+  for (auto it = g_collections.begin(); it != g_collections.end();) {
+    it = it->second->collection.expired() ? g_collections.erase(it) : std::next(it);
+  }
+  auto state = std::make_shared<CollectionState>();
+  state->collection = collection;
+  state->filter_history = std::make_shared<FilterHistory>();
+  g_collections[collection.get()] = std::move(state);
+  return collection;
+}
+
+zvec::Collection::Ptr shared_collection(const zvec::Collection& collection) {
+  if (auto ptr = collection_state(collection)->collection.lock()) return ptr;
+  throw std::runtime_error("Collection is not open");
+}
+
+std::shared_ptr<CollectionState> collection_state(const zvec::Collection& collection) {
+  std::lock_guard<std::mutex> lock(g_collections_mutex);
+  auto it = g_collections.find(&collection);
+  if (it == g_collections.end()) throw std::runtime_error("Collection is not open");
+  return it->second;
+}
+
+// Collections shared by every Ractor in the process, keyed by path. Entries
+// are strong so a shared collection stays open until close_shared. The
+// generation counts reload_shared swaps so Ractor caches can spot stale
+// wrappers.
+static std::mutex g_shared_mutex;
+static std::unordered_map<std::string, zvec::Collection::Ptr> g_shared;
+static std::unordered_map<std::string, uint64_t> g_shared_generation;
+
+static zvec::Collection::Ptr find_shared_collection(const std::string& path) {
+  std::lock_guard<std::mutex> lock(g_shared_mutex);
+  auto it = g_shared.find(path);
+  return it == g_shared.end() ? nullptr : it->second;
+}
+
+static zvec::Collection::Ptr open_shared_collection(const std::string& path) {
+  if (auto shared = find_shared_collection(path)) return shared;
+
+  // Always a read-only instance of its own, even when a writer in this
+  // process has the path open, so no Ractor can write through the share.
+  // Opened without the GVL or the lock, so other Ractors and paths keep going.
+  zvec::CollectionOptions opts;
+  opts.read_only_ = true;
+  zvec::Collection::Ptr collection;
+  zvec::Status status;
+  without_gvl([&] {
+    auto result = zvec::Collection::Open(path, opts);
+    if (result.has_value()) collection = std::move(result.value());
+    else status = result.error();
+  });
+  throw_if_error(status);
+  register_collection(collection);
+
+  // A Ractor that raced us may have shared its instance first; keep that
+  // one so every caller gets the same collection, and drop ours
+  std::lock_guard<std::mutex> lock(g_shared_mutex);
+  return g_shared.emplace(path, collection).first->second;
+}
+
+static bool close_shared_collection(const std::string& path) {
+  std::lock_guard<std::mutex> lock(g_shared_mutex);
+  return g_shared.erase(path) > 0;
+}
+
+// Point the shared entry for path at the collection in dir. The new one is
+// opened read-only and lazily (mapped, indexes read on first query), so the
+// old and new indexes are never both resident in full. Queries that still
+// hold the old collection finish on it; it closes when the last one drops.
+static zvec::Collection::Ptr reload_shared_collection(const std::string& path, const std::string& dir) {
+  zvec::CollectionOptions opts;
+  opts.read_only_ = true;
+  opts.enable_mmap_ = true;
+  zvec::Collection::Ptr collection;
+  std::shared_ptr<OpenProfile> profile;
+  zvec::Status status;
+  without_gvl([&] { status = open_profiled(dir, nullptr, opts, true, collection, profile); });
+  throw_if_error(status);
+  register_collection(collection);
+  collection_state(*collection)->open_profile = std::move(profile);
+
+  zvec::Collection::Ptr old;
+  {
+    std::lock_guard<std::mutex> lock(g_shared_mutex);
+    auto& slot = g_shared[path];
+    old = std::move(slot);
+    slot = collection;
+    g_shared_generation[path]++;
+  }
+  // Release our reference outside the lock; the close may hit disk
+  without_gvl([&] { old.reset(); });
+  return collection;
+}
+
+static uint64_t shared_generation(const std::string& path) {
+  std::lock_guard<std::mutex> lock(g_shared_mutex);
+  auto it = g_shared_generation.find(path);
+  return it == g_shared_generation.end() ? 0 : it->second;
+}
+
+// Open or create without the GVL. CollectionOptions#lazy_load? (defined in
+// Ruby) maps the files and defers reading each index to its first query.
+static zvec::Collection::Ptr open_collection(const std::string& path,
+                                             const zvec::CollectionSchema* schema,
+                                             Rice::Object opts_obj) {
+  zvec::CollectionOptions opts;
+  bool lazy = false;
+  if (!opts_obj.is_nil()) {
+    opts = Rice::detail::From_Ruby<zvec::CollectionOptions>().convert(opts_obj.value());
+    ID lazy_load = rb_intern("lazy_load?");
+    lazy = rb_respond_to(opts_obj.value(), lazy_load) && RTEST(rb_funcall(opts_obj.value(), lazy_load, 0));
+  }
+  if (lazy) opts.enable_mmap_ = true;
+
+  zvec::Collection::Ptr collection;
+  std::shared_ptr<OpenProfile> profile;
+  zvec::Status status;
+  without_gvl([&] { status = open_profiled(path, schema, opts, lazy, collection, profile); });
+  throw_if_error(status);
+  register_collection(collection);
+  collection_state(*collection)->open_profile = std::move(profile);
+  return collection;
+}
+
+// Lazy-opened collections start readahead of a vector field's index files
+// on first use
+static void touch_field(const zvec::Collection& c, const std::string& field) {
+  auto profile = collection_state(c)->open_profile;
+  if (profile && profile->lazy()) profile->touch(field);
+}
+
+// Rewrite VECTOR_INT4 values stored one int8 per element (0.0.3 and
+// earlier) in the packed layout, a page at a time. Rows already packed hold
+// dim / 2 bytes and are left alone.
+static zvec::Status repack_int4(zvec::Collection& c, const std::string& field, uint32_t dim,
+                                uint32_t batch_size, uint64_t& repacked) {
+  zvec::VectorQuery q;
+  q.include_vector_ = true;
+  q.output_fields_ = std::vector<std::string>{};
+  ScanPager pager(std::move(q), batch_size);
+  std::vector<zvec::Doc::Ptr> page;
+  bool last = false;
+  while (!last) {
+    auto status = pager.next(c, page, last);
+    if (!status.ok()) return status;
+    std::vector<zvec::Doc> batch;
+    for (const auto& doc : page) {
+      auto v = doc->get<std::vector<int8_t>>(field);
+      if (!v || v->size() != dim) continue;
+      for (int8_t x : *v) {
+        if (x < -8 || x > 7)
+          return zvec::Status::InvalidArgument("pk " + doc->pk() + ": " + field +
+                                               " is neither packed nor in -8..7");
+      }
+      std::vector<int8_t> packed(kernels::int4_packed_size(dim));
+      kernels::pack_int4(v->data(), reinterpret_cast<uint8_t*>(packed.data()), dim);
+      zvec::Doc out;
+      out.set_pk(doc->pk());
+      out.set<std::vector<int8_t>>(field, std::move(packed));
+      batch.push_back(std::move(out));
+    }
+    if (batch.empty()) continue;
+    std::optional<decltype(c.Update(batch))> results;
+    {
+      WriteGate gate(c);
+      results.emplace(c.Update(batch));
+    }
+    if (!results->has_value()) return results->error();
+    for (const auto& s : results->value()) {
+      if (!s.ok()) return s;
+    }
+    repacked += batch.size();
+  }
+  return zvec::Status();
+}
+
+// Metric of a field's vector index, or UNDEFINED when it has none
+static zvec::MetricType field_metric(const zvec::FieldSchema& fs) {
+  auto params = std::dynamic_pointer_cast<zvec::VectorIndexParams>(fs.index_params());
+  return params ? params->metric_type() : zvec::MetricType::UNDEFINED;
+}
+
+// FP32 query for the refine stage, from an Array or a packed float32 String
+static std::vector<float> refine_vector(Rice::Object data, uint32_t dim) {
+  std::vector<float> out;
+  VALUE v = data.value();
+  if (RB_TYPE_P(v, T_STRING)) {
+    if (static_cast<size_t>(RSTRING_LEN(v)) != dim * sizeof(float))
+      throw std::invalid_argument("refine vector must be dimension * 4 bytes");
+    out.resize(dim);
+    std::memcpy(out.data(), RSTRING_PTR(v), dim * sizeof(float));
+    return out;
+  }
+  Rice::Array arr(data);
+  if (arr.size() != dim) throw std::invalid_argument("refine vector dimension does not match field");
+  out.resize(dim);
+  for (size_t i = 0; i < dim; i++) out[i] = Rice::detail::From_Ruby<float>().convert(arr[i].value());
+  return out;
+}
+
+// Copy of the query's params (or defaults for the field's index) with a
+// radius set, leaving the caller's QueryParams untouched
+static zvec::QueryParams::Ptr params_with_radius(const zvec::QueryParams::Ptr& params,
+                                                 zvec::IndexType index_type, float radius) {
+  zvec::QueryParams::Ptr out;
+  if (auto p = std::dynamic_pointer_cast<zvec::HnswQueryParams>(params)) {
+    out = std::make_shared<zvec::HnswQueryParams>(*p);
+  } else if (auto p = std::dynamic_pointer_cast<zvec::IVFQueryParams>(params)) {
+    out = std::make_shared<zvec::IVFQueryParams>(*p);
+  } else if (auto p = std::dynamic_pointer_cast<zvec::FlatQueryParams>(params)) {
+    out = std::make_shared<zvec::FlatQueryParams>(*p);
+  } else if (index_type == zvec::IndexType::HNSW) {
+    out = std::make_shared<zvec::HnswQueryParams>();
+  } else if (index_type == zvec::IndexType::IVF) {
+    out = std::make_shared<zvec::IVFQueryParams>();
+  } else {
+    out = std::make_shared<zvec::FlatQueryParams>();
+  }
+  out->set_radius(radius);
+  return out;
+}
+
+}  // namespace zvec_rb
+
 void init_zvec_collection(Rice::Module& m) {
   Rice::define_class_under<zvec::Collection>(m, "Collection")
     // Static factory: create_and_open
     .define_singleton_function("create_and_open", [](const std::string& path,
                                                       const zvec::CollectionSchema& schema,
                                                       Rice::Object opts_obj) -> zvec::Collection::Ptr {
-      zvec::CollectionOptions opts;
-      if (!opts_obj.is_nil()) {
-        opts = Rice::detail::From_Ruby<zvec::CollectionOptions>().convert(opts_obj.value());
-      }
-      return zvec_rb::unwrap_result(zvec::Collection::CreateAndOpen(path, schema, opts));
+      return zvec_rb::open_collection(path, &schema, opts_obj);
     },
       Rice::Arg("path"),
       Rice::Arg("schema"),
@@ -21,15 +271,39 @@ void init_zvec_collection(Rice::Module& m) {
     // Static factory: open
     .define_singleton_function("open", [](const std::string& path,
                                           Rice::Object opts_obj) -> zvec::Collection::Ptr {
-      zvec::CollectionOptions opts;
-      if (!opts_obj.is_nil()) {
-        opts = Rice::detail::From_Ruby<zvec::CollectionOptions>().convert(opts_obj.value());
-      }
-      return zvec_rb::unwrap_result(zvec::Collection::Open(path, opts));
+      return zvec_rb::open_collection(path, nullptr, opts_obj);
     },
       Rice::Arg("path"),
       Rice::Arg("options") = Rice::Object(Qnil))
 
+    // Process-wide read-only instance, usable from any Ractor
+    .define_singleton_function("open_shared", [](const std::string& path) {
+      return zvec_rb::open_shared_collection(path);
+    })
+    .define_singleton_function("close_shared", [](const std::string& path) {
+      return zvec_rb::close_shared_collection(path);
+    })
+    // Swap the shared instance for path to the collection built in dir
+    .define_singleton_function("reload_shared", [](const std::string& path, const std::string& dir) {
+      return zvec_rb::reload_shared_collection(path, dir);
+    })
+    .define_singleton_function("shared_generation", [](const std::string& path) {
+      return zvec_rb::shared_generation(path);
+    })
+    // Materialize a Collection#snapshot directory as a new collection at path
+    .define_singleton_function("restore_snapshot", [](const std::string& snapshot,
+                                                      const std::string& path,
+                                                      uint32_t concurrency) {
+      zvec_rb::SnapshotStats stats;
+      zvec::Status status;
+      zvec_rb::without_gvl([&] { status = zvec_rb::restore_snapshot(snapshot, path, concurrency, stats); });
+      zvec_rb::throw_if_error(status);
+      return zvec_rb::snapshot_stats_hash(stats);
+    },
+      Rice::Arg("snapshot"),
+      Rice::Arg("path"),
+      Rice::Arg("concurrency") = (uint32_t)0)
+
     // Metadata
     .define_method("path", [](zvec::Collection& c) {
       return zvec_rb::unwrap_result(c.Path());
@@ -43,13 +317,76 @@ void init_zvec_collection(Rice::Module& m) {
     .define_method("options", [](zvec::Collection& c) {
       return zvec_rb::unwrap_result(c.Options());
     })
+    .define_method("detailed_stats", [](zvec::Collection& c) {
+      auto stats = zvec_rb::read_detailed_stats(c, *zvec_rb::collection_state(c));
+      zvec_rb::without_gvl([&] { zvec_rb::collect_disk_usage(stats); });
+      return stats;
+    })
+    // Open-time phases in ms, plus indexes a lazy open has not loaded yet;
+    // nil for collections not opened through open/create_and_open
+    .define_method("open_stats", [](zvec::Collection& c) -> Rice::Object {
+      auto profile = zvec_rb::collection_state(c)->open_profile;
+      if (!profile) return Rice::Object(Qnil);
+      Rice::Hash phases;
+      double total = 0;
+      for (auto& [phase, ms] : profile->phases()) {
+        phases[Rice::String(phase)] = ms;
+        total += ms;
+      }
+      Rice::Array pending;
+      for (auto& field : profile->pending()) pending.push(field);
+      Rice::Array unmatched;
+      for (auto& field : profile->unmatched()) unmatched.push(field);
+      Rice::Hash h;
+      h[Rice::Symbol("lazy")] = profile->lazy();
+      h[Rice::Symbol("phases")] = phases;
+      h[Rice::Symbol("total_ms")] = total;
+      h[Rice::Symbol("pending")] = pending;
+      h[Rice::Symbol("unmatched")] = unmatched;
+      return h;
+    })
 
     // Lifecycle
     .define_method("flush", [](zvec::Collection& c) {
-      zvec_rb::throw_if_error(c.Flush());
+      zvec_rb::OpScope op("flush", c);
+      zvec::Status status;
+      op.engine([&] {
+        zvec_rb::WriteGate gate(c);
+        status = c.Flush();
+      });
+      op.check(status);
+      zvec_rb::collection_state(c)->unflushed_writes = 0;
+      op.finish(0);
     })
+    // Point-in-time copy of the collection directory; see zvec_snapshot.hpp
+    .define_method("snapshot", [](zvec::Collection& c,
+                                  const std::string& dest,
+                                  const std::string& base,
+                                  bool copy,
+                                  uint32_t concurrency) {
+      zvec_rb::OpScope op("snapshot", c);
+      auto state = zvec_rb::collection_state(c);
+      zvec_rb::SnapshotStats stats;
+      zvec::Status status;
+      op.engine([&] {
+        zvec_rb::without_gvl([&] {
+          status = zvec_rb::snapshot_collection(c, *state, dest, base, copy, concurrency, stats);
+        });
+      });
+      op.check(status);
+      op.finish(stats.files);
+      return zvec_rb::snapshot_stats_hash(stats);
+    },
+      Rice::Arg("dest"),
+      Rice::Arg("base") = std::string(""),
+      Rice::Arg("copy") = false,
+      Rice::Arg("concurrency") = (uint32_t)0)
     .define_method("destroy!", [](zvec::Collection& c) {
-      zvec_rb::throw_if_error(c.Destroy());
+      zvec_rb::OpScope op("destroy", c);
+      zvec::Status status;
+      op.engine([&] { status = c.Destroy(); });
+      op.check(status);
+      op.finish(0);
     })
 
     // DDL — index management
@@ -57,20 +394,44 @@ void init_zvec_collection(Rice::Module& m) {
                                       const std::string& column,
                                       zvec::IndexParams::Ptr params,
                                       int concurrency) {
-      zvec::CreateIndexOptions opts{concurrency};
-      zvec_rb::throw_if_error(c.CreateIndex(column, params, opts));
+      zvec_rb::OpScope op("create_index", c);
+      zvec::Status status;
+      op.engine([&] {
+        zvec_rb::WriteGate gate(c);
+        status = zvec_rb::scheduled_maintenance(concurrency, [&](int n) {
+          return c.CreateIndex(column, params, zvec::CreateIndexOptions{n});
+        });
+      });
+      op.check(status);
+      op.finish(0);
     },
       Rice::Arg("column"),
       Rice::Arg("params"),
       Rice::Arg("concurrency") = 0)
 
     .define_method("drop_index", [](zvec::Collection& c, const std::string& column) {
-      zvec_rb::throw_if_error(c.DropIndex(column));
+      zvec_rb::OpScope op("drop_index", c);
+      zvec::Status status;
+      op.engine([&] {
+        zvec_rb::WriteGate gate(c);
+        status = c.DropIndex(column);
+      });
+      op.check(status);
+      op.finish(0);
     })
 
     .define_method("optimize", [](zvec::Collection& c, int concurrency) {
-      zvec::OptimizeOptions opts{concurrency};
-      zvec_rb::throw_if_error(c.Optimize(opts));
+      zvec_rb::OpScope op("optimize", c);
+      zvec::Status status;
+      op.engine([&] {
+        zvec_rb::WriteGate gate(c);
+        status = zvec_rb::scheduled_maintenance(concurrency, [&](int n) {
+          return c.Optimize(zvec::OptimizeOptions{n});
+        });
+      });
+      op.check(status);
+      zvec_rb::collection_state(c)->deletes_since_optimize = 0;
+      op.finish(0);
     },
       Rice::Arg("concurrency") = 0)
 
@@ -79,15 +440,30 @@ void init_zvec_collection(Rice::Module& m) {
                                     zvec::FieldSchema::Ptr fs,
                                     const std::string& expression,
                                     int concurrency) {
-      zvec::AddColumnOptions opts{concurrency};
-      zvec_rb::throw_if_error(c.AddColumn(fs, expression, opts));
+      zvec_rb::OpScope op("add_column", c);
+      zvec::Status status;
+      op.engine([&] {
+        zvec_rb::WriteGate gate(c);
+        status = zvec_rb::scheduled_maintenance(concurrency, [&](int n) {
+          return c.AddColumn(fs, expression, zvec::AddColumnOptions{n});
+        });
+      });
+      op.check(status);
+      op.finish(0);
     },
       Rice::Arg("field_schema"),
       Rice::Arg("expression") = std::string(""),
       Rice::Arg("concurrency") = 0)
 
     .define_method("drop_column", [](zvec::Collection& c, const std::string& name) {
-      zvec_rb::throw_if_error(c.DropColumn(name));
+      zvec_rb::OpScope op("drop_column", c);
+      zvec::Status status;
+      op.engine([&] {
+        zvec_rb::WriteGate gate(c);
+        status = c.DropColumn(name);
+      });
+      op.check(status);
+      op.finish(0);
     })
 
     .define_method("alter_column", [](zvec::Collection& c,
@@ -95,12 +471,20 @@ void init_zvec_collection(Rice::Module& m) {
                                       const std::string& rename,
                                       Rice::Object new_schema_obj,
                                       int concurrency) {
+      zvec_rb::OpScope op("alter_column", c);
       zvec::FieldSchema::Ptr new_schema = nullptr;
       if (!new_schema_obj.is_nil()) {
         new_schema = Rice::detail::From_Ruby<zvec::FieldSchema::Ptr>().convert(new_schema_obj.value());
       }
-      zvec::AlterColumnOptions opts{concurrency};
-      zvec_rb::throw_if_error(c.AlterColumn(name, rename, new_schema, opts));
+      zvec::Status status;
+      op.engine([&] {
+        zvec_rb::WriteGate gate(c);
+        status = zvec_rb::scheduled_maintenance(concurrency, [&](int n) {
+          return c.AlterColumn(name, rename, new_schema, zvec::AlterColumnOptions{n});
+        });
+      });
+      op.check(status);
+      op.finish(0);
     },
       Rice::Arg("name"),
       Rice::Arg("rename") = std::string(""),
@@ -108,91 +492,238 @@ void init_zvec_collection(Rice::Module& m) {
       Rice::Arg("concurrency") = 0)
 
     // DML — write operations
-    .define_method("insert", [](zvec::Collection& c, Rice::Array ruby_docs) {
-      std::vector<zvec::Doc> docs;
-      docs.reserve(ruby_docs.size());
-      for (size_t i = 0; i < ruby_docs.size(); i++) {
-        docs.push_back(Rice::detail::From_Ruby<zvec::Doc>().convert(ruby_docs[i].value()));
-      }
-      auto results = zvec_rb::unwrap_result(c.Insert(docs));
-      Rice::Array arr;
-      for (const auto& s : results) {
-        arr.push(Rice::Object(Rice::detail::To_Ruby<zvec::Status>().convert(zvec::Status(s))));
-      }
-      return arr;
+    .define_method("insert", [](zvec::Collection& c, Rice::Object ruby_docs) {
+      zvec_rb::WriteDocs write(ruby_docs);
+      std::vector<zvec::Doc>& docs = write.get();
+      zvec_rb::OpScope op("insert", c, {docs.size()});
+      std::optional<decltype(c.Insert(docs))> results;
+      op.engine([&] {
+        zvec_rb::WriteGate gate(c);
+        results.emplace(c.Insert(docs));
+      });
+      auto statuses = op.unwrap(std::move(*results));
+      auto result = zvec_rb::WriteResult::from_statuses(statuses, [&](size_t i) { return docs[i].pk(); });
+      zvec_rb::collection_state(c)->unflushed_writes += result.ok_count();
+      op.finish(result.ok_count());
+      return result;
     })
 
-    .define_method("upsert", [](zvec::Collection& c, Rice::Array ruby_docs) {
-      std::vector<zvec::Doc> docs;
-      docs.reserve(ruby_docs.size());
-      for (size_t i = 0; i < ruby_docs.size(); i++) {
-        docs.push_back(Rice::detail::From_Ruby<zvec::Doc>().convert(ruby_docs[i].value()));
-      }
-      auto results = zvec_rb::unwrap_result(c.Upsert(docs));
-      Rice::Array arr;
-      for (const auto& s : results) {
-        arr.push(Rice::Object(Rice::detail::To_Ruby<zvec::Status>().convert(zvec::Status(s))));
-      }
-      return arr;
+    .define_method("upsert", [](zvec::Collection& c, Rice::Object ruby_docs) {
+      zvec_rb::WriteDocs write(ruby_docs);
+      std::vector<zvec::Doc>& docs = write.get();
+      zvec_rb::OpScope op("upsert", c, {docs.size()});
+      std::optional<decltype(c.Upsert(docs))> results;
+      op.engine([&] {
+        zvec_rb::WriteGate gate(c);
+        results.emplace(c.Upsert(docs));
+      });
+      auto statuses = op.unwrap(std::move(*results));
+      auto result = zvec_rb::WriteResult::from_statuses(statuses, [&](size_t i) { return docs[i].pk(); });
+      zvec_rb::collection_state(c)->unflushed_writes += result.ok_count();
+      op.finish(result.ok_count());
+      return result;
     })
 
-    .define_method("update", [](zvec::Collection& c, Rice::Array ruby_docs) {
-      std::vector<zvec::Doc> docs;
-      docs.reserve(ruby_docs.size());
-      for (size_t i = 0; i < ruby_docs.size(); i++) {
-        docs.push_back(Rice::detail::From_Ruby<zvec::Doc>().convert(ruby_docs[i].value()));
-      }
-      auto results = zvec_rb::unwrap_result(c.Update(docs));
-      Rice::Array arr;
-      for (const auto& s : results) {
-        arr.push(Rice::Object(Rice::detail::To_Ruby<zvec::Status>().convert(zvec::Status(s))));
-      }
-      return arr;
+    .define_method("update", [](zvec::Collection& c, Rice::Object ruby_docs) {
+      zvec_rb::WriteDocs write(ruby_docs);
+      std::vector<zvec::Doc>& docs = write.get();
+      zvec_rb::OpScope op("update", c, {docs.size()});
+      std::optional<decltype(c.Update(docs))> results;
+      op.engine([&] {
+        zvec_rb::WriteGate gate(c);
+        results.emplace(c.Update(docs));
+      });
+      auto statuses = op.unwrap(std::move(*results));
+      auto result = zvec_rb::WriteResult::from_statuses(statuses, [&](size_t i) { return docs[i].pk(); });
+      zvec_rb::collection_state(c)->unflushed_writes += result.ok_count();
+      op.finish(result.ok_count());
+      return result;
     })
 
     .define_method("delete", [](zvec::Collection& c, Rice::Array ruby_pks) {
+      zvec_rb::OpScope op("delete", c, {ruby_pks.size()});
       std::vector<std::string> pks;
       pks.reserve(ruby_pks.size());
       for (size_t i = 0; i < ruby_pks.size(); i++) {
         pks.push_back(Rice::detail::From_Ruby<std::string>().convert(ruby_pks[i].value()));
       }
-      auto results = zvec_rb::unwrap_result(c.Delete(pks));
-      Rice::Array arr;
-      for (const auto& s : results) {
-        arr.push(Rice::Object(Rice::detail::To_Ruby<zvec::Status>().convert(zvec::Status(s))));
-      }
-      return arr;
+      std::optional<decltype(c.Delete(pks))> results;
+      op.engine([&] {
+        zvec_rb::WriteGate gate(c);
+        results.emplace(c.Delete(pks));
+      });
+      auto statuses = op.unwrap(std::move(*results));
+      auto result = zvec_rb::WriteResult::from_statuses(statuses, [&](size_t i) { return pks[i]; });
+      auto state = zvec_rb::collection_state(c);
+      state->unflushed_writes += result.ok_count();
+      state->deletes_since_optimize += result.ok_count();
+      op.finish(result.ok_count());
+      return result;
     })
 
     .define_method("delete_by_filter", [](zvec::Collection& c, const std::string& filter) {
-      zvec_rb::throw_if_error(c.DeleteByFilter(filter));
+      zvec_rb::OpScope op("delete_by_filter", c, {0, -1, !filter.empty()});
+      zvec::Status status;
+      op.engine([&] {
+        zvec_rb::WriteGate gate(c);
+        status = c.DeleteByFilter(filter);
+      });
+      op.check(status);
+      op.finish(0);
     })
 
+    // Migrate a VECTOR_INT4 field written before values were packed two per
+    // byte; returns the number of docs rewritten
+    .define_method("repack_int4", [](zvec::Collection& c, const std::string& field,
+                                     uint32_t batch_size) -> uint64_t {
+      if (batch_size == 0) throw std::invalid_argument("batch_size must be positive");
+      auto schema = zvec_rb::unwrap_result(c.Schema());
+      const zvec::FieldSchema* fs = schema.get_field(field);
+      if (!fs) throw std::invalid_argument("Unknown field: " + field);
+      if (fs->data_type() != zvec::DataType::VECTOR_INT4)
+        throw std::invalid_argument("repack_int4 needs a VECTOR_INT4 field: " + field);
+      if (fs->dimension() % 2 != 0)
+        throw std::invalid_argument("VECTOR_INT4 needs an even dimension, got " +
+                                    std::to_string(fs->dimension()));
+      zvec_rb::OpScope op("repack_int4", c);
+      uint64_t repacked = 0;
+      zvec::Status status;
+      op.engine([&] { status = zvec_rb::repack_int4(c, field, fs->dimension(), batch_size, repacked); });
+      zvec_rb::collection_state(c)->unflushed_writes += repacked;
+      op.check(status);
+      op.finish(repacked);
+      return repacked;
+    },
+      Rice::Arg("field"),
+      Rice::Arg("batch_size") = (uint32_t)1000)
+
     // DQL — query operations
-    .define_method("query", [](zvec::Collection& c, const zvec::VectorQuery& vq) {
-      auto docs = zvec_rb::unwrap_result(c.Query(vq));
+    // With VectorQuery#profile = true the result is a QueryResult carrying
+    // the plan, measured selectivity and phase times
+    .define_method("query", [](zvec::Collection& c, Rice::Object vq_obj) -> Rice::Object {
+      const zvec::VectorQuery& vq = *Rice::detail::From_Ruby<zvec::VectorQuery*>().convert(vq_obj.value());
+      zvec_rb::OpScope op("query", c, {0, vq.topk_, !vq.filter_.empty()});
+      std::optional<zvec_rb::QueryProfile> profile;
+      if (zvec_rb::profile_requested(vq_obj.value())) {
+        auto state = zvec_rb::collection_state(c);
+        zvec_rb::without_gvl([&] {
+          profile.emplace(zvec_rb::explain_query(c, *state, vq, true, zvec_rb::kProfileCountLimit));
+        });
+        op.check(profile->status);
+      }
+
+      std::optional<decltype(c.Query(vq))> result;
+      auto searched = std::chrono::steady_clock::now();
+      op.engine([&] {
+        zvec_rb::timed_query([&] {
+          zvec_rb::touch_field(c, vq.field_name_);
+          result.emplace(c.Query(vq));
+        });
+      });
+      auto converted = std::chrono::steady_clock::now();
+      auto docs = op.unwrap(std::move(*result));
       Rice::Array arr;
       for (auto& d : docs) {
         zvec::Doc copy(*d);
         arr.push(Rice::Object(Rice::detail::To_Ruby<zvec::Doc>().convert(std::move(copy))));
       }
-      return arr;
+      op.finish(docs.size());
+      if (!profile) return arr;
+
+      profile->executed = true;
+      profile->search_ms = std::chrono::duration<double, std::milli>(converted - searched).count();
+      profile->convert_ms = zvec_rb::ms_since(converted);
+      return zvec_rb::query_result(arr, std::move(*profile));
     })
 
+    // Plan for a query without running its vector search. count: true also
+    // runs the filter alone to measure its selectivity.
+    .define_method("explain", [](zvec::Collection& c,
+                                 const zvec::VectorQuery& vq,
+                                 bool count,
+                                 uint64_t count_limit) {
+      auto state = zvec_rb::collection_state(c);
+      zvec_rb::QueryProfile plan;
+      zvec_rb::without_gvl([&] { plan = zvec_rb::explain_query(c, *state, vq, count, count_limit); });
+      zvec_rb::throw_if_error(plan.status);
+      return plan;
+    },
+      Rice::Arg("query"),
+      Rice::Arg("count") = false,
+      Rice::Arg("count_limit") = (uint64_t)zvec_rb::kProfileCountLimit)
+
     .define_method("group_by_query", [](zvec::Collection& c, const zvec::GroupByVectorQuery& gq) {
-      auto results = zvec_rb::unwrap_result(c.GroupByQuery(gq));
-      Rice::Array arr;
-      for (auto& gr : results) arr.push(gr);
-      return arr;
+      zvec_rb::OpScope op("group_by_query", c, {0, gq.group_topk_, !gq.filter_.empty()});
+      std::optional<decltype(c.GroupByQuery(gq))> result;
+      op.engine([&] {
+        zvec_rb::timed_query([&] {
+          zvec_rb::touch_field(c, gq.field_name_);
+          result.emplace(c.GroupByQuery(gq));
+        });
+      });
+      zvec_rb::GroupResults groups(op.unwrap(std::move(*result)));
+      op.finish(groups.size());
+      return groups;
     })
 
+    // Two-stage search: over-fetch from the query's (cheap) field, re-score
+    // exactly against the FP32 refine_field, return the top-k
+    .define_method("refine_query", [](zvec::Collection& c,
+                                      const zvec::VectorQuery& vq,
+                                      const std::string& refine_field,
+                                      Rice::Object vector,
+                                      uint32_t topk,
+                                      uint32_t overfetch,
+                                      Rice::Object metric_obj) {
+      zvec_rb::OpScope op("refine_query", c, {0, topk ? topk : vq.topk_, !vq.filter_.empty()});
+      if (overfetch == 0) throw std::invalid_argument("overfetch must be positive");
+      auto schema = zvec_rb::unwrap_result(c.Schema());
+      const zvec::FieldSchema* fs = schema.get_field(refine_field);
+      if (!fs) throw std::invalid_argument("Unknown field: " + refine_field);
+      if (fs->data_type() != zvec::DataType::VECTOR_FP32)
+        throw std::invalid_argument("refine_field must be a VECTOR_FP32 field");
+
+      zvec::MetricType metric = zvec::MetricType::UNDEFINED;
+      if (!metric_obj.is_nil()) {
+        metric = Rice::detail::From_Ruby<zvec::MetricType>().convert(metric_obj.value());
+      } else {
+        metric = zvec_rb::field_metric(*fs);
+        if (metric == zvec::MetricType::UNDEFINED) {
+          const zvec::FieldSchema* coarse = schema.get_field(vq.field_name_);
+          if (coarse) metric = zvec_rb::field_metric(*coarse);
+        }
+      }
+      std::vector<float> query = zvec_rb::refine_vector(vector, fs->dimension());
+      if (topk == 0) topk = static_cast<uint32_t>(vq.topk_);
+
+      zvec_rb::RefineResult result;
+      op.engine([&] {
+        zvec_rb::timed_query([&] {
+          zvec_rb::touch_field(c, vq.field_name_);
+          result = zvec_rb::refine_query(c, vq, refine_field, query, topk, overfetch, metric);
+        });
+      });
+      op.check(result.status);
+      op.finish(result.docs.size());
+      return result;
+    },
+      Rice::Arg("query"),
+      Rice::Arg("refine_field"),
+      Rice::Arg("vector"),
+      Rice::Arg("topk") = (uint32_t)0,
+      Rice::Arg("overfetch") = (uint32_t)4,
+      Rice::Arg("metric") = Rice::Object(Qnil))
+
     .define_method("fetch", [](zvec::Collection& c, Rice::Array ruby_pks) -> Rice::Object {
+      zvec_rb::OpScope op("fetch", c, {ruby_pks.size()});
       std::vector<std::string> pks;
       pks.reserve(ruby_pks.size());
       for (size_t i = 0; i < ruby_pks.size(); i++) {
         pks.push_back(Rice::detail::From_Ruby<std::string>().convert(ruby_pks[i].value()));
       }
-      auto doc_map = zvec_rb::unwrap_result(c.Fetch(pks));
+      std::optional<decltype(c.Fetch(pks))> result;
+      op.engine([&] { zvec_rb::timed_query([&] { result.emplace(c.Fetch(pks)); }); });
+      auto doc_map = op.unwrap(std::move(*result));
       VALUE rb_hash = rb_hash_new();
       for (auto& [k, v] : doc_map) {
         if (!v) continue;
@@ -201,6 +732,221 @@ void init_zvec_collection(Rice::Module& m) {
         VALUE rb_val = Rice::detail::To_Ruby<zvec::Doc>().convert(doc_copy);
         rb_hash_aset(rb_hash, rb_key, rb_val);
       }
+      op.finish(RHASH_SIZE(rb_hash));
       return Rice::Object(rb_hash);
-    });
+    })
+
+    // Stream every document (optionally filtered) through a read-ahead cursor
+    .define_method("scan", [](zvec::Collection& c,
+                              const std::string& filter,
+                              Rice::Object output_fields,
+                              uint32_t batch_size,
+                              bool include_vector) -> zvec_rb::ScanCursor* {
+      if (batch_size == 0) throw std::invalid_argument("batch_size must be positive");
+      zvec::VectorQuery q;
+      q.filter_ = filter;
+      q.include_vector_ = include_vector;
+      if (!output_fields.is_nil()) {
+        Rice::Array fields(output_fields);
+        std::vector<std::string> vec;
+        vec.reserve(fields.size());
+        for (size_t i = 0; i < fields.size(); i++) {
+          vec.push_back(Rice::detail::From_Ruby<std::string>().convert(fields[i].value()));
+        }
+        q.output_fields_ = std::move(vec);
+      }
+      return new zvec_rb::ScanCursor(zvec_rb::shared_collection(c), std::move(q), batch_size);
+    },
+      Rice::Return().takeOwnership(),
+      Rice::Arg("filter") = std::string(""),
+      Rice::Arg("output_fields") = Rice::Object(Qnil),
+      Rice::Arg("batch_size") = (uint32_t)1000,
+      Rice::Arg("include_vector") = false)
+
+    // Page through a vector query's ranked results (optionally bounded by a
+    // radius), resuming from a position token when after is given
+    .define_method("query_cursor", [](zvec::Collection& c,
+                                      const zvec::VectorQuery& vq,
+                                      uint32_t batch_size,
+                                      const std::string& after,
+                                      Rice::Object radius) -> zvec_rb::QueryCursor* {
+      if (batch_size == 0) throw std::invalid_argument("batch_size must be positive");
+      zvec::VectorQuery q = vq;
+      if (!radius.is_nil()) {
+        auto schema = zvec_rb::unwrap_result(c.Schema());
+        const zvec::FieldSchema* fs = schema.get_field(q.field_name_);
+        if (!fs) throw std::invalid_argument("Unknown field: " + q.field_name_);
+        q.query_params_ = zvec_rb::params_with_radius(q.query_params_, fs->index_type(),
+                                                      Rice::detail::From_Ruby<float>().convert(radius.value()));
+      }
+      zvec_rb::without_gvl([&] { zvec_rb::touch_field(c, q.field_name_); });
+      return new zvec_rb::QueryCursor(zvec_rb::shared_collection(c), std::move(q), batch_size, after);
+    },
+      Rice::Return().takeOwnership(),
+      Rice::Arg("query"),
+      Rice::Arg("batch_size") = (uint32_t)100,
+      Rice::Arg("after") = std::string(""),
+      Rice::Arg("radius") = Rice::Object(Qnil))
+
+    // Copy a dense field into memory for exact batch search with tiled kernels
+    .define_method("brute_force_index", [](zvec::Collection& c,
+                                           const std::string& field,
+                                           Rice::Object metric_obj,
+                                           const std::string& filter,
+                                           uint32_t batch_size) -> zvec_rb::BruteForceIndex* {
+      auto schema = zvec_rb::unwrap_result(c.Schema());
+      const zvec::FieldSchema* fs = schema.get_field(field);
+      if (!fs) throw std::invalid_argument("Unknown field: " + field);
+      zvec::MetricType metric = metric_obj.is_nil()
+        ? zvec_rb::field_metric(*fs)
+        : Rice::detail::From_Ruby<zvec::MetricType>().convert(metric_obj.value());
+      std::unique_ptr<zvec_rb::BruteForceIndex> index;
+      zvec::Status status;
+      zvec_rb::without_gvl([&] {
+        status = zvec_rb::BruteForceIndex::load(c, *fs, metric, filter, batch_size, index);
+      });
+      zvec_rb::throw_if_error(status);
+      return index.release();
+    },
+      Rice::Return().takeOwnership(),
+      Rice::Arg("field"),
+      Rice::Arg("metric") = Rice::Object(Qnil),
+      Rice::Arg("filter") = std::string(""),
+      Rice::Arg("batch_size") = (uint32_t)1000)
+
+    // Train IVF-style coarse lists over a dense field. n_list and n_iters
+    // default to the field's IVFIndexParams; 0 means "from the index".
+    .define_method("ivf_partitioner", [](zvec::Collection& c,
+                                         const std::string& field,
+                                         uint32_t n_list,
+                                         uint32_t n_iters,
+                                         Rice::Object metric_obj,
+                                         const std::string& filter,
+                                         uint32_t sample_per_list,
+                                         uint64_t seed,
+                                         uint32_t concurrency,
+                                         uint32_t batch_size) -> zvec_rb::IvfPartitioner* {
+      auto schema = zvec_rb::unwrap_result(c.Schema());
+      const zvec::FieldSchema* fs = schema.get_field(field);
+      if (!fs) throw std::invalid_argument("Unknown field: " + field);
+      zvec_rb::IvfPartitioner::Options opts;
+      opts.n_list = n_list;
+      opts.n_iters = n_iters;
+      if (auto ivf = std::dynamic_pointer_cast<zvec::IVFIndexParams>(fs->index_params())) {
+        if (opts.n_list == 0) opts.n_list = static_cast<uint32_t>(ivf->n_list());
+        if (opts.n_iters == 0) opts.n_iters = static_cast<uint32_t>(ivf->n_iters());
+      }
+      if (opts.n_list == 0) throw std::invalid_argument("n_list is required for a field without an IVF index");
+      if (opts.n_iters == 0) opts.n_iters = 10;
+      opts.sample_per_list = sample_per_list;
+      opts.seed = seed;
+      opts.concurrency = concurrency;
+      zvec::MetricType metric = metric_obj.is_nil()
+        ? zvec_rb::field_metric(*fs)
+        : Rice::detail::From_Ruby<zvec::MetricType>().convert(metric_obj.value());
+
+      std::unique_ptr<zvec_rb::IvfPartitioner> partitioner;
+      zvec::Status status;
+      zvec_rb::without_gvl([&] {
+        status = zvec_rb::IvfPartitioner::train(c, *fs, metric, filter, batch_size, opts, partitioner);
+      });
+      zvec_rb::throw_if_error(status);
+      return partitioner.release();
+    },
+      Rice::Return().takeOwnership(),
+      Rice::Arg("field"),
+      Rice::Arg("n_list") = (uint32_t)0,
+      Rice::Arg("n_iters") = (uint32_t)0,
+      Rice::Arg("metric") = Rice::Object(Qnil),
+      Rice::Arg("filter") = std::string(""),
+      Rice::Arg("sample_per_list") = (uint32_t)256,
+      Rice::Arg("seed") = (uint64_t)42,
+      Rice::Arg("concurrency") = (uint32_t)0,
+      Rice::Arg("batch_size") = (uint32_t)1000)
+
+    // Late-interaction search over a token field (see Zvec::MultiVector):
+    // candidates per query vector, then exact MaxSim over each doc's tokens
+    .define_method("maxsim_query", [](zvec::Collection& c,
+                                      const std::string& field,
+                                      Rice::Object queries,
+                                      uint32_t topk,
+                                      uint32_t candidates,
+                                      const std::string& filter,
+                                      Rice::Object query_params,
+                                      Rice::Object metric_obj,
+                                      uint32_t concurrency) {
+      auto schema = zvec_rb::unwrap_result(c.Schema());
+      const zvec::FieldSchema* fs = schema.get_field(field);
+      if (!fs) throw std::invalid_argument("Unknown field: " + field);
+      if (fs->data_type() != zvec::DataType::VECTOR_FP32 && fs->data_type() != zvec::DataType::VECTOR_FP16)
+        throw std::invalid_argument("maxsim_query needs a VECTOR_FP32 or VECTOR_FP16 field");
+      if (!schema.get_field(zvec_rb::kMultiVectorParent) || !schema.get_field(zvec_rb::kMultiVectorTokenCount))
+        throw std::invalid_argument("collection is not a multi-vector layout (see Zvec::MultiVector.schema)");
+      if (candidates == 0) throw std::invalid_argument("candidates must be positive");
+
+      zvec_rb::MaxSimOptions opts;
+      opts.field = field;
+      opts.topk = topk;
+      opts.candidates = candidates;
+      opts.filter = filter;
+      opts.concurrency = concurrency;
+      if (!query_params.is_nil()) {
+        opts.query_params = Rice::detail::From_Ruby<zvec::QueryParams::Ptr>().convert(query_params.value());
+      }
+      opts.metric = metric_obj.is_nil()
+        ? zvec_rb::field_metric(*fs)
+        : Rice::detail::From_Ruby<zvec::MetricType>().convert(metric_obj.value());
+      if (opts.metric == zvec::MetricType::UNDEFINED) opts.metric = zvec::MetricType::IP;
+      if (opts.metric != zvec::MetricType::IP && opts.metric != zvec::MetricType::COSINE)
+        throw std::invalid_argument("MaxSim scores by similarity; use an IP or COSINE metric");
+
+      size_t nq = 0;
+      std::vector<float> q = zvec_rb::float_matrix(queries, fs->dimension(), nq);
+      zvec_rb::OpScope op("maxsim_query", c, {0, topk, !filter.empty()});
+      zvec_rb::MaxSimResult result;
+      op.engine([&] {
+        zvec_rb::timed_query([&] { result = zvec_rb::maxsim_query(c, *fs, q, nq, opts); });
+      });
+      op.check(result.status);
+      op.finish(result.hits.size());
+      return result;
+    },
+      Rice::Arg("field"),
+      Rice::Arg("queries"),
+      Rice::Arg("topk") = (uint32_t)10,
+      Rice::Arg("candidates") = (uint32_t)64,
+      Rice::Arg("filter") = std::string(""),
+      Rice::Arg("query_params") = Rice::Object(Qnil),
+      Rice::Arg("metric") = Rice::Object(Qnil),
+      Rice::Arg("concurrency") = (uint32_t)0)
+
+    // Batched self-kNN over a vector field; pairs are produced one scan page
+    // at a time by native worker threads
+    .define_method("find_near_duplicates", [](zvec::Collection& c,
+                                              const std::string& field,
+                                              float threshold,
+                                              uint32_t topk_per_doc,
+                                              uint32_t concurrency,
+                                              const std::string& filter,
+                                              uint32_t batch_size,
+                                              Rice::Object query_params) -> zvec_rb::NearDuplicateScan* {
+      auto schema = zvec_rb::unwrap_result(c.Schema());
+      const zvec::FieldSchema* fs = schema.get_field(field);
+      if (!fs) throw std::invalid_argument("Unknown field: " + field);
+      zvec::QueryParams::Ptr params;
+      if (!query_params.is_nil()) {
+        params = Rice::detail::From_Ruby<zvec::QueryParams::Ptr>().convert(query_params.value());
+      }
+      zvec_rb::without_gvl([&] { zvec_rb::touch_field(c, field); });
+      return new zvec_rb::NearDuplicateScan(zvec_rb::shared_collection(c), *fs, threshold,
+                                            topk_per_doc, concurrency, filter, batch_size, params);
+    },
+      Rice::Return().takeOwnership(),
+      Rice::Arg("field"),
+      Rice::Arg("threshold"),
+      Rice::Arg("topk_per_doc") = (uint32_t)10,
+      Rice::Arg("concurrency") = (uint32_t)0,
+      Rice::Arg("filter") = std::string(""),
+      Rice::Arg("batch_size") = (uint32_t)1000,
+      Rice::Arg("query_params") = Rice::Object(Qnil));
 }
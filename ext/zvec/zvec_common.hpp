@@ -2,6 +2,7 @@
 
 #include <rice/rice.hpp>
 #include <rice/stl.hpp>
+#include <ruby/thread.h>
 #include <zvec/db/collection.h>
 #include <zvec/db/config.h>
 #include <zvec/db/doc.h>
@@ -14,6 +15,10 @@
 #include <zvec/db/type.h>
 #include <zvec/ailego/utility/float_helper.h>
 
+#include <atomic>
+#include <chrono>
+#include <shared_mutex>
+
 namespace zvec_rb {
 
 // Exception classes defined in zvec_status.cpp
@@ -40,13 +45,87 @@ T unwrap_result(const tl::expected<T, zvec::Status>& result) {
   throw std::runtime_error("unreachable: unwrap_result after throw_if_error");
 }
 
+// Move the value out of a temporary Result instead of copying it
+template <typename T>
+T unwrap_result(tl::expected<T, zvec::Status>&& result) {
+  if (result.has_value()) return std::move(result.value());
+  throw_if_error(result.error());
+  throw std::runtime_error("unreachable: unwrap_result after throw_if_error");
+}
+
+class OpenProfile;
+class FilterHistory;
+
+// Binding-side bookkeeping for a collection opened through the bindings
+struct CollectionState {
+  std::weak_ptr<zvec::Collection> collection;
+  std::atomic<uint64_t> unflushed_writes{0};
+  std::atomic<uint64_t> deletes_since_optimize{0};
+  // Set once by Collection.open/create_and_open before the handle is returned
+  std::shared_ptr<OpenProfile> open_profile;
+  // Writes hold it shared; Collection#snapshot holds it exclusively while it
+  // flushes and captures the directory
+  std::shared_mutex snapshot_gate;
+  // Filter selectivity seen by profiled queries (see zvec_profile.hpp)
+  std::shared_ptr<FilterHistory> filter_history;
+};
+
+// Track a Collection opened through the bindings so native helpers that only
+// receive a Collection& (cursors, background work) can share ownership of it
+zvec::Collection::Ptr register_collection(zvec::Collection::Ptr collection);
+zvec::Collection::Ptr shared_collection(const zvec::Collection& collection);
+std::shared_ptr<CollectionState> collection_state(const zvec::Collection& collection);
+
+// Run fn with the GVL released. fn must not touch Ruby objects; C++ exceptions
+// are captured and rethrown once the GVL is held again.
+template <typename F>
+void without_gvl(F&& fn) {
+  struct Call {
+    std::remove_reference_t<F>* fn;
+    std::exception_ptr error;
+  } call{&fn, nullptr};
+
+  rb_thread_call_without_gvl([](void* data) -> void* {
+    auto* c = static_cast<Call*>(data);
+    try {
+      (*c->fn)();
+    } catch (...) {
+      c->error = std::current_exception();
+    }
+    return nullptr;
+  }, &call, RUBY_UBF_IO, nullptr);
+
+  if (call.error) std::rethrow_exception(call.error);
+}
+
+// Milliseconds from start to now on the steady clock
+inline double ms_since(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
 }  // namespace zvec_rb
 
 // Init functions for each binding file
 void init_zvec_types(Rice::Module& m);
 void init_zvec_status(Rice::Module& m);
+void init_zvec_write_result(Rice::Module& m);
 void init_zvec_params(Rice::Module& m);
 void init_zvec_schema(Rice::Module& m);
 void init_zvec_doc(Rice::Module& m);
+void init_zvec_doc_builder(Rice::Module& m);
+void init_zvec_filter(Rice::Module& m);
+void init_zvec_quantize(Rice::Module& m);
+void init_zvec_cursor(Rice::Module& m);
+void init_zvec_dedup(Rice::Module& m);
+void init_zvec_brute_force(Rice::Module& m);
+void init_zvec_ivf(Rice::Module& m);
+void init_zvec_maxsim(Rice::Module& m);
+void init_zvec_group_results(Rice::Module& m);
+void init_zvec_refine(Rice::Module& m);
+void init_zvec_profile(Rice::Module& m);
+void init_zvec_stats(Rice::Module& m);
+void init_zvec_instrument(Rice::Module& m);
 void init_zvec_collection(Rice::Module& m);
+void init_zvec_partition(Rice::Module& m);
+void init_zvec_builder(Rice::Module& m);
 void init_zvec_config(Rice::Module& m);
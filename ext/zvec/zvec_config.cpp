@@ -1,4 +1,9 @@
 #include "zvec_common.hpp"
+#include "zvec_profile.hpp"
+#include "zvec_scheduler.hpp"
+
+#include <algorithm>
+#include <thread>
 
 using namespace Rice;
 
@@ -15,6 +20,64 @@ static VALUE hash_get(Rice::Hash& h, const char* key) {
   return rb_hash_aref(h.value(), sym);
 }
 
+// Keys handled only by the binding's scheduler. query_cpu_share and
+// maintenance_cpu_share are not among them: they set engine thread counts.
+static const char* kSchedulerKeys[] = {
+  "maintenance_pause_p99_ms", "maintenance_max_wait_s", "latency_window_s"};
+
+// Keys that change the engine configuration, so a call passing any of them
+// re-initializes it
+static const char* kEngineKeys[] = {
+  "memory_limit_mb", "query_thread_count", "optimize_thread_count", "query_cpu_share",
+  "maintenance_cpu_share", "invert_to_forward_scan_ratio", "brute_force_by_keys_ratio",
+  "log_level", "log_type", "log_dir", "log_basename", "log_file_size", "log_overdue_days"};
+
+template <size_t N>
+static bool key_in(VALUE key, const char* const (&keys)[N]) {
+  if (!SYMBOL_P(key)) return false;
+  ID id = SYM2ID(key);
+  return std::any_of(keys, keys + N, [&](const char* k) { return rb_intern(k) == id; });
+}
+
+// Whether opts sets any engine key. Raises for keys that are neither engine
+// nor scheduler keys, before anything has been applied.
+static bool partition_keys(Rice::Hash& opts) {
+  VALUE keys = rb_funcall(opts.value(), rb_intern("keys"), 0);
+  bool engine = false;
+  for (long i = 0; i < RARRAY_LEN(keys); i++) {
+    VALUE key = rb_ary_entry(keys, i);
+    if (key_in(key, kEngineKeys)) {
+      engine = engine || !NIL_P(rb_hash_aref(opts.value(), key));
+    } else if (!key_in(key, kSchedulerKeys)) {
+      VALUE name = rb_inspect(key);
+      throw std::invalid_argument("unknown Zvec.configure option: " +
+                                  std::string(RSTRING_PTR(name), RSTRING_LEN(name)));
+    }
+  }
+  return engine;
+}
+
+// Engine configuration last applied by Zvec.configure. Initialize takes a
+// whole ConfigData, so each call starts from this one rather than from the
+// defaults, and keys a call does not mention keep their values.
+static zvec::GlobalConfig::ConfigData& applied_config() {
+  static zvec::GlobalConfig::ConfigData config;
+  return config;
+}
+
+// CPU share option, a fraction of the machine's cores
+static double cpu_share(VALUE value) {
+  double share = Rice::detail::From_Ruby<double>().convert(value);
+  if (share <= 0 || share > 1) throw std::invalid_argument("CPU shares must be in (0, 1]");
+  return share;
+}
+
+// Thread count for a CPU share (at least one)
+static uint32_t share_to_threads(double share) {
+  uint32_t cores = std::max(1u, std::thread::hardware_concurrency());
+  return std::max<uint32_t>(1, static_cast<uint32_t>(share * cores));
+}
+
 void init_zvec_config(Rice::Module& m) {
   // LogLevel enum
   Rice::define_enum_under<zvec::GlobalConfig::LogLevel>("LogLevel", m)
@@ -26,7 +89,20 @@ void init_zvec_config(Rice::Module& m) {
 
   // Zvec.configure(options_hash) module function
   m.define_module_function("configure", [](Rice::Hash opts) {
-    zvec::GlobalConfig::ConfigData config;
+    bool engine_keys = partition_keys(opts);
+    zvec::GlobalConfig::ConfigData config = applied_config();
+
+    // Scheduler settings; keys not given keep their current values
+    auto s = zvec_rb::Scheduler::instance().settings();
+    if (hash_has(opts, "maintenance_cpu_share"))
+      s.maintenance_cpu_share = cpu_share(hash_get(opts, "maintenance_cpu_share"));
+    if (hash_has(opts, "maintenance_pause_p99_ms"))
+      s.pause_p99_ms = Rice::detail::From_Ruby<double>().convert(hash_get(opts, "maintenance_pause_p99_ms"));
+    if (hash_has(opts, "maintenance_max_wait_s"))
+      s.max_wait_s = Rice::detail::From_Ruby<double>().convert(hash_get(opts, "maintenance_max_wait_s"));
+    if (hash_has(opts, "latency_window_s"))
+      s.window_s = Rice::detail::From_Ruby<double>().convert(hash_get(opts, "latency_window_s"));
+    double query_share = hash_has(opts, "query_cpu_share") ? cpu_share(hash_get(opts, "query_cpu_share")) : 0;
 
     // memory_limit_mb — convert MB to bytes
     if (hash_has(opts, "memory_limit_mb")) {
@@ -34,16 +110,20 @@ void init_zvec_config(Rice::Module& m) {
       config.memory_limit_bytes = mb * 1024 * 1024;
     }
 
-    // query_thread_count
+    // query_thread_count (or derived from query_cpu_share)
     if (hash_has(opts, "query_thread_count")) {
       config.query_thread_count = Rice::detail::From_Ruby<uint32_t>().convert(
         hash_get(opts, "query_thread_count"));
+    } else if (query_share > 0) {
+      config.query_thread_count = share_to_threads(query_share);
     }
 
-    // optimize_thread_count
+    // optimize_thread_count (or derived from maintenance_cpu_share)
     if (hash_has(opts, "optimize_thread_count")) {
       config.optimize_thread_count = Rice::detail::From_Ruby<uint32_t>().convert(
         hash_get(opts, "optimize_thread_count"));
+    } else if (hash_has(opts, "maintenance_cpu_share")) {
+      config.optimize_thread_count = share_to_threads(s.maintenance_cpu_share);
     }
 
     // invert_to_forward_scan_ratio
@@ -94,7 +174,42 @@ void init_zvec_config(Rice::Module& m) {
       config.log_config = std::make_shared<zvec::GlobalConfig::ConsoleLogConfig>(level);
     }
 
-    auto& gc = zvec::GlobalConfig::Instance();
-    zvec_rb::throw_if_error(gc.Initialize(config));
+    // Scheduler-only calls leave the engine configuration alone
+    if (engine_keys) {
+      auto& gc = zvec::GlobalConfig::Instance();
+      zvec_rb::throw_if_error(gc.Initialize(config));
+      applied_config() = config;
+      zvec_rb::record_filter_ratios(config);
+    }
+    zvec_rb::Scheduler::instance().configure(s);
+  });
+
+  // Zvec.configuration — thread counts and scheduler settings in effect
+  m.define_module_function("configuration", []() {
+    const auto& config = applied_config();
+    auto s = zvec_rb::Scheduler::instance().settings();
+    Rice::Hash h;
+    h[Rice::Symbol("memory_limit_mb")] = config.memory_limit_bytes / (1024 * 1024);
+    h[Rice::Symbol("query_thread_count")] = config.query_thread_count;
+    h[Rice::Symbol("optimize_thread_count")] = config.optimize_thread_count;
+    h[Rice::Symbol("invert_to_forward_scan_ratio")] = config.invert_to_forward_scan_ratio;
+    h[Rice::Symbol("brute_force_by_keys_ratio")] = config.brute_force_by_keys_ratio;
+    h[Rice::Symbol("maintenance_cpu_share")] = s.maintenance_cpu_share;
+    h[Rice::Symbol("maintenance_pause_p99_ms")] = s.pause_p99_ms;
+    h[Rice::Symbol("maintenance_max_wait_s")] = s.max_wait_s;
+    h[Rice::Symbol("latency_window_s")] = s.window_s;
+    return h;
+  });
+
+  // Zvec.scheduler_stats — rolling query p99 and maintenance gate counters
+  m.define_module_function("scheduler_stats", []() {
+    auto s = zvec_rb::Scheduler::instance().stats();
+    Rice::Hash h;
+    h[Rice::Symbol("query_p99_ms")] = s.query_p99_ms;
+    h[Rice::Symbol("window_samples")] = s.window_samples;
+    h[Rice::Symbol("maintenance_runs")] = s.maintenance_runs;
+    h[Rice::Symbol("maintenance_waits")] = s.maintenance_waits;
+    h[Rice::Symbol("maintenance_wait_ms")] = s.maintenance_wait_ms;
+    return h;
   });
 }
@@ -0,0 +1,229 @@
+#include "zvec_cursor.hpp"
+
+using namespace Rice;
+
+namespace zvec_rb {
+
+// --- PagedCursor ---
+
+PagedCursor::~PagedCursor() {
+  close();
+}
+
+void PagedCursor::start() {
+  worker_ = std::thread(&PagedCursor::run, this);
+}
+
+void PagedCursor::run() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    cv_.wait(lock, [this] { return closed_ || (!ahead_ && !done_); });
+    if (closed_) return;
+
+    lock.unlock();
+    Page page = fetch_page();
+    lock.lock();
+
+    if (!page.status.ok() || page.last) done_ = true;
+    ahead_ = std::move(page);
+    cv_.notify_all();
+  }
+}
+
+std::vector<zvec::Doc::Ptr> PagedCursor::next_batch() {
+  std::optional<Page> page;
+  without_gvl([&] {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this] { return closed_ || ahead_ || done_; });
+    if (ahead_) {
+      page = std::move(ahead_);
+      ahead_.reset();
+      cv_.notify_all();
+    }
+  });
+
+  if (!page) return {};
+  throw_if_error(page->status);
+  page_served(*page);
+  return std::move(page->docs);
+}
+
+bool PagedCursor::exhausted() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return closed_ || (done_ && !ahead_);
+}
+
+bool PagedCursor::ready() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return closed_ || ahead_ || done_;
+}
+
+void PagedCursor::close() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    closed_ = true;
+    ahead_.reset();
+  }
+  cv_.notify_all();
+  if (worker_.joinable()) worker_.join();
+}
+
+// --- ScanPager ---
+
+// Engine column holding the global doc id. Filter-only queries return rows in
+// ascending doc id order across segments, so bounding on it gives a stable
+// keyset for paging. Neither the column nor the order is a documented engine
+// contract: test_scan_across_segments pins both, and next() fails the scan
+// rather than skip rows if a page ever comes back out of order.
+static const char* kDocIdColumn = "_zvec_g_doc_id_";
+
+ScanPager::ScanPager(zvec::VectorQuery query, uint32_t batch_size)
+    : query_(std::move(query)), filter_(query_.filter_), batch_size_(batch_size) {
+  query_.topk_ = static_cast<int>(batch_size_);
+  query_.include_doc_id_ = true;
+}
+
+zvec::Status ScanPager::next(const zvec::Collection& collection,
+                             std::vector<zvec::Doc::Ptr>& docs, bool& last) {
+  bool bounded = started_;
+  if (bounded) {
+    std::string bound = std::string(kDocIdColumn) + " > " + std::to_string(last_doc_id_);
+    query_.filter_ = filter_.empty() ? bound : "(" + filter_ + ") AND " + bound;
+  }
+  started_ = true;
+
+  auto result = collection.Query(query_);
+  if (!result.has_value()) return result.error();
+  docs.assign(result.value().begin(), result.value().end());
+  for (size_t i = 0; i < docs.size(); i++) {
+    bool ordered = i > 0 ? docs[i]->doc_id() > docs[i - 1]->doc_id()
+                         : !bounded || docs[i]->doc_id() > last_doc_id_;
+    if (!ordered)
+      return zvec::Status::InvalidArgument("scan: engine returned doc " + std::to_string(docs[i]->doc_id()) +
+                                           " out of doc id order; keyset paging would skip rows");
+  }
+  last = docs.size() < batch_size_;
+  if (!docs.empty()) last_doc_id_ = docs.back()->doc_id();
+  return zvec::Status();
+}
+
+// --- ScanCursor ---
+
+ScanCursor::ScanCursor(zvec::Collection::Ptr collection, zvec::VectorQuery query,
+                       uint32_t batch_size)
+    : PagedCursor(batch_size),
+      collection_(std::move(collection)),
+      pager_(std::move(query), batch_size) {
+  start();
+}
+
+ScanCursor::Page ScanCursor::fetch_page() {
+  Page page;
+  page.status = pager_.next(*collection_, page.docs, page.last);
+  return page;
+}
+
+// --- QueryCursor ---
+
+QueryCursor::QueryCursor(zvec::Collection::Ptr collection, zvec::VectorQuery query,
+                         uint32_t batch_size, const std::string& after)
+    : PagedCursor(batch_size),
+      collection_(std::move(collection)),
+      query_(std::move(query)) {
+  if (!after.empty()) {
+    size_t colon = after.find(':');
+    if (colon == std::string::npos || colon == 0)
+      throw std::invalid_argument("invalid query cursor position: " + after);
+    resume_count_ = std::stoull(after.substr(0, colon));
+    resume_pk_ = after.substr(colon + 1);
+    served_count_ = resume_count_;
+    last_pk_ = resume_pk_;
+  }
+  start();
+}
+
+std::string QueryCursor::position() const {
+  std::lock_guard<std::mutex> lock(position_mutex_);
+  if (served_count_ == 0) return "";
+  return std::to_string(served_count_) + ":" + last_pk_;
+}
+
+zvec::Status QueryCursor::refill(size_t need) {
+  size_t topk = std::max(need, fetched_topk_ * 2);
+  query_.topk_ = static_cast<int>(topk);
+  auto result = collection_->Query(query_);
+  if (!result.has_value()) return result.error();
+
+  fetched_topk_ = topk;
+  buffer_ = std::move(result.value());
+  complete_ = buffer_.size() < topk;
+  next_ = 0;
+
+  // Resuming from a position: everything up to the last served pk (or, if
+  // that doc is gone, the first served-count results) was already handed out
+  if (!resume_pk_.empty()) {
+    size_t skip = std::min(resume_count_, buffer_.size());
+    for (size_t i = 0; i < buffer_.size(); i++) {
+      if (buffer_[i]->pk() == resume_pk_) {
+        skip = i + 1;
+        break;
+      }
+    }
+    for (size_t i = 0; i < skip; i++) served_.insert(buffer_[i]->pk());
+    resume_pk_.clear();
+  }
+  return zvec::Status();
+}
+
+QueryCursor::Page QueryCursor::fetch_page() {
+  Page page;
+  if (fetched_topk_ == 0) page.status = refill(resume_count_ + batch_size_);
+  while (page.status.ok() && page.docs.size() < batch_size_) {
+    if (next_ >= buffer_.size()) {
+      if (complete_) break;
+      page.status = refill(served_.size() + batch_size_);
+      continue;
+    }
+    auto& doc = buffer_[next_++];
+    // Results shift when the collection changes between searches
+    if (served_.insert(doc->pk()).second) page.docs.push_back(doc);
+  }
+  if (!page.status.ok()) return page;
+  page.last = complete_ && next_ >= buffer_.size();
+  return page;
+}
+
+void QueryCursor::page_served(const Page& page) {
+  if (page.docs.empty()) return;
+  std::lock_guard<std::mutex> lock(position_mutex_);
+  served_count_ += page.docs.size();
+  last_pk_ = page.docs.back()->pk();
+}
+
+}  // namespace zvec_rb
+
+void init_zvec_cursor(Rice::Module& m) {
+  // Cursor — shared paging interface; read-ahead runs on a native thread
+  Rice::define_class_under<zvec_rb::PagedCursor>(m, "Cursor")
+    .define_method("next_batch", [](zvec_rb::PagedCursor& cursor) {
+      auto docs = cursor.next_batch();
+      Rice::Array arr;
+      for (auto& d : docs) {
+        zvec::Doc copy(*d);
+        arr.push(Rice::Object(Rice::detail::To_Ruby<zvec::Doc>().convert(std::move(copy))));
+      }
+      return arr;
+    })
+    .define_method("exhausted?", &zvec_rb::PagedCursor::exhausted)
+    .define_method("ready?", &zvec_rb::PagedCursor::ready)
+    .define_method("batch_size", &zvec_rb::PagedCursor::batch_size)
+    .define_method("close", [](zvec_rb::PagedCursor& cursor) {
+      // Joining the worker may wait on an in-flight page
+      zvec_rb::without_gvl([&] { cursor.close(); });
+    });
+
+  Rice::define_class_under<zvec_rb::ScanCursor, zvec_rb::PagedCursor>(m, "ScanCursor");
+
+  Rice::define_class_under<zvec_rb::QueryCursor, zvec_rb::PagedCursor>(m, "QueryCursor")
+    .define_method("position", &zvec_rb::QueryCursor::position);
+}
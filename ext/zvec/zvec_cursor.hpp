@@ -0,0 +1,138 @@
+#pragma once
+
+#include "zvec_common.hpp"
+
+#include <condition_variable>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <unordered_set>
+
+namespace zvec_rb {
+
+// Base for cursors that stream query results in pages. A background thread
+// fetches one page ahead of the Ruby caller, so at most two pages are alive
+// at any time. Subclasses implement fetch_page(), call start() at the end of
+// their constructor and close() in their destructor.
+class PagedCursor {
+ public:
+  explicit PagedCursor(uint32_t batch_size) : batch_size_(batch_size) {}
+  virtual ~PagedCursor();
+
+  PagedCursor(const PagedCursor&) = delete;
+  PagedCursor& operator=(const PagedCursor&) = delete;
+
+  // Block (without the GVL) until the next page is ready. Returns an empty
+  // list once the cursor is exhausted or closed.
+  std::vector<zvec::Doc::Ptr> next_batch();
+
+  bool exhausted() const;
+  // next_batch would return without waiting: the page ahead is buffered, or
+  // the cursor is exhausted or closed
+  bool ready() const;
+  uint32_t batch_size() const { return batch_size_; }
+  void close();
+
+ protected:
+  struct Page {
+    zvec::Status status;
+    std::vector<zvec::Doc::Ptr> docs;
+    bool last = false;
+  };
+
+  // Runs on the worker thread only
+  virtual Page fetch_page() = 0;
+  // Runs on the caller's thread when a page is handed out, in page order.
+  // The worker may already be fetching the page after it.
+  virtual void page_served(const Page& page) {}
+  void start();
+
+  uint32_t batch_size_;
+
+ private:
+  void run();
+
+  mutable std::mutex mutex_;
+  std::condition_variable cv_;
+  std::optional<Page> ahead_;
+  bool done_ = false;
+  bool closed_ = false;
+  std::thread worker_;
+};
+
+// Pages through every document matching a filter in ascending doc id
+// (segment) order. Pages are filter-only queries keyed on the last doc id
+// seen. No Ruby calls, so it can run on any thread.
+class ScanPager {
+ public:
+  ScanPager(zvec::VectorQuery query, uint32_t batch_size);
+
+  // Next page into docs; last is set once no further page remains
+  zvec::Status next(const zvec::Collection& collection, std::vector<zvec::Doc::Ptr>& docs,
+                    bool& last);
+
+ private:
+  zvec::VectorQuery query_;
+  std::string filter_;
+  uint32_t batch_size_;
+
+  // Keyset position
+  bool started_ = false;
+  uint64_t last_doc_id_ = 0;
+};
+
+// Streams every document matching a filter through a ScanPager
+class ScanCursor : public PagedCursor {
+ public:
+  ScanCursor(zvec::Collection::Ptr collection, zvec::VectorQuery query,
+             uint32_t batch_size);
+  ~ScanCursor() override { close(); }
+
+ protected:
+  Page fetch_page() override;
+
+ private:
+  zvec::Collection::Ptr collection_;
+  ScanPager pager_;
+};
+
+// Pages through the ranked results of a vector query (optionally bounded by
+// a radius). The engine keeps no search state between calls, so each refill
+// re-runs the search with a geometrically larger topk and the surplus is kept
+// as a buffer: n pages cost O(log n) searches instead of n.
+class QueryCursor : public PagedCursor {
+ public:
+  QueryCursor(zvec::Collection::Ptr collection, zvec::VectorQuery query,
+              uint32_t batch_size, const std::string& after);
+  ~QueryCursor() override { close(); }
+
+  // Resume token for the position after the last page handed out:
+  // "<served count>:<last pk>"
+  std::string position() const;
+
+ protected:
+  Page fetch_page() override;
+  void page_served(const Page& page) override;
+
+ private:
+  zvec::Status refill(size_t need);
+
+  zvec::Collection::Ptr collection_;
+  zvec::VectorQuery query_;
+
+  std::vector<zvec::Doc::Ptr> buffer_;
+  size_t next_ = 0;  // index into buffer_ of the next unserved doc
+  size_t fetched_topk_ = 0;
+  bool complete_ = false;  // buffer_ holds every result the engine will return
+  std::unordered_set<std::string> served_;
+  std::string resume_pk_;
+  size_t resume_count_ = 0;
+
+  // Advanced by page_served, so a prefetched page is not counted until
+  // Ruby has it
+  mutable std::mutex position_mutex_;
+  size_t served_count_ = 0;
+  std::string last_pk_;
+};
+
+}  // namespace zvec_rb
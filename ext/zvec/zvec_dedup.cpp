@@ -0,0 +1,193 @@
+#include "zvec_dedup.hpp"
+#include "zvec_pool.hpp"
+
+#include <algorithm>
+
+using namespace Rice;
+
+namespace zvec_rb {
+
+template <typename T>
+static bool append_vector(const zvec::Doc& doc, const std::string& field, std::string& out) {
+  auto v = doc.get<std::vector<T>>(field);
+  if (!v) return false;
+  out.assign(reinterpret_cast<const char*>(v->data()), v->size() * sizeof(T));
+  return true;
+}
+
+// A stored dense vector as query bytes in the field's own encoding, the same
+// layout VectorQuery#set_packed_vector takes
+static bool stored_query_vector(const zvec::Doc& doc, const std::string& field,
+                                zvec::DataType dt, std::string& out) {
+  if (!doc.has(field) || doc.is_null(field)) return false;
+  switch (dt) {
+    case zvec::DataType::VECTOR_FP32: return append_vector<float>(doc, field, out);
+    case zvec::DataType::VECTOR_FP64: return append_vector<double>(doc, field, out);
+    case zvec::DataType::VECTOR_FP16: return append_vector<zvec::ailego::Float16>(doc, field, out);
+    case zvec::DataType::VECTOR_INT8:
+    case zvec::DataType::VECTOR_INT4: return append_vector<int8_t>(doc, field, out);
+    case zvec::DataType::VECTOR_BINARY32: return append_vector<uint32_t>(doc, field, out);
+    case zvec::DataType::VECTOR_BINARY64: return append_vector<uint64_t>(doc, field, out);
+    default: return false;
+  }
+}
+
+static zvec::VectorQuery scan_query(const std::string& field, const std::string& filter) {
+  zvec::VectorQuery q;
+  q.filter_ = filter;
+  q.include_vector_ = true;
+  q.output_fields_ = std::vector<std::string>{field};
+  return q;
+}
+
+NearDuplicateScan::NearDuplicateScan(zvec::Collection::Ptr collection,
+                                     const zvec::FieldSchema& field, float threshold,
+                                     uint32_t topk_per_doc, uint32_t concurrency,
+                                     const std::string& filter, uint32_t batch_size,
+                                     zvec::QueryParams::Ptr query_params)
+    : collection_(std::move(collection)),
+      field_(field.name()),
+      data_type_(field.data_type()),
+      higher_is_closer_(false),
+      threshold_(threshold),
+      topk_(topk_per_doc),
+      concurrency_(static_cast<uint32_t>(thread_count(concurrency))),
+      filter_(filter),
+      query_params_(std::move(query_params)),
+      pager_(scan_query(field.name(), filter), batch_size) {
+  if (!field.is_dense_vector())
+    throw std::invalid_argument("find_near_duplicates needs a dense vector field: " + field_);
+  if (topk_ == 0) throw std::invalid_argument("topk_per_doc must be positive");
+  if (batch_size == 0) throw std::invalid_argument("batch_size must be positive");
+  auto params = std::dynamic_pointer_cast<zvec::VectorIndexParams>(field.index_params());
+  higher_is_closer_ = params && params->metric_type() == zvec::MetricType::IP;
+}
+
+zvec::Status NearDuplicateScan::next_page(std::vector<Pair>& pairs) {
+  pairs.clear();
+  if (exhausted_) return zvec::Status();
+
+  std::vector<zvec::Doc::Ptr> docs;
+  bool last = false;
+  zvec::Status status = pager_.next(*collection_, docs, last);
+  if (!status.ok()) return status;
+  exhausted_ = last;
+  scanned_ += docs.size();
+
+  // Self-queries for the page, split across the pool. Each worker keeps its
+  // own matches and the first error it hits.
+  std::vector<std::vector<Pair>> found(concurrency_);
+  std::vector<zvec::Status> errors(concurrency_);
+  zvec::VectorQuery base;
+  base.field_name_ = field_;
+  base.topk_ = static_cast<int>(topk_ + 1);  // the document finds itself
+  base.filter_ = filter_;
+  base.query_params_ = query_params_;
+  base.output_fields_ = std::vector<std::string>{};
+  std::vector<zvec::VectorQuery> queries(concurrency_, base);
+  parallel_for(docs.size(), concurrency_, [&](size_t w, size_t i) {
+    if (!errors[w].ok()) return;  // this worker already failed
+    zvec::VectorQuery& q = queries[w];
+    const zvec::Doc& doc = *docs[i];
+    if (!stored_query_vector(doc, field_, data_type_, q.query_vector_)) return;
+    auto result = collection_->Query(q);
+    if (!result.has_value()) {
+      errors[w] = result.error();
+      return;
+    }
+    for (auto& hit : result.value()) {
+      if (hit->pk() == doc.pk() || !within(hit->score())) continue;
+      bool first = doc.pk() < hit->pk();
+      found[w].push_back(Pair{first ? doc.pk() : hit->pk(), first ? hit->pk() : doc.pk(), hit->score()});
+    }
+  });
+
+  for (auto& e : errors) {
+    if (!e.ok()) return e;
+  }
+  for (auto& list : found) {
+    for (auto& p : list) {
+      uint32_t a = node(p.a), b = node(p.b);
+      if (!seen_.insert((static_cast<uint64_t>(a) << 32) | b).second) continue;
+      unite(a, b);
+      pairs.push_back(std::move(p));
+    }
+  }
+  pair_count_ += pairs.size();
+  return zvec::Status();
+}
+
+uint32_t NearDuplicateScan::node(const std::string& pk) {
+  auto [it, inserted] = ids_.emplace(pk, static_cast<uint32_t>(pks_.size()));
+  if (inserted) {
+    pks_.push_back(pk);
+    parent_.push_back(it->second);
+  }
+  return it->second;
+}
+
+uint32_t NearDuplicateScan::find(uint32_t x) const {
+  while (parent_[x] != x) {
+    parent_[x] = parent_[parent_[x]];
+    x = parent_[x];
+  }
+  return x;
+}
+
+void NearDuplicateScan::unite(uint32_t x, uint32_t y) {
+  x = find(x);
+  y = find(y);
+  if (x != y) parent_[std::max(x, y)] = std::min(x, y);
+}
+
+std::vector<std::vector<std::string>> NearDuplicateScan::components() const {
+  std::unordered_map<uint32_t, size_t> index;
+  std::vector<std::vector<std::string>> groups;
+  for (uint32_t i = 0; i < pks_.size(); i++) {
+    auto [it, inserted] = index.emplace(find(i), groups.size());
+    if (inserted) groups.emplace_back();
+    groups[it->second].push_back(pks_[i]);
+  }
+  return groups;
+}
+
+}  // namespace zvec_rb
+
+using NearDuplicateScan = zvec_rb::NearDuplicateScan;
+
+void init_zvec_dedup(Rice::Module& m) {
+  Rice::define_class_under<NearDuplicateScan>(m, "NearDuplicateScan")
+    // Next page of pairs as [pk_a, pk_b, score]; empty once exhausted
+    .define_method("next_batch", [](NearDuplicateScan& scan) {
+      std::vector<NearDuplicateScan::Pair> pairs;
+      zvec::Status status;
+      zvec_rb::without_gvl([&] {
+        // Pages without a match are skipped so an empty batch means done
+        do {
+          status = scan.next_page(pairs);
+        } while (status.ok() && pairs.empty() && !scan.exhausted());
+      });
+      zvec_rb::throw_if_error(status);
+      Rice::Array arr;
+      for (auto& p : pairs) {
+        Rice::Array pair;
+        pair.push(p.a);
+        pair.push(p.b);
+        pair.push(p.score);
+        arr.push(pair);
+      }
+      return arr;
+    })
+    .define_method("exhausted?", &NearDuplicateScan::exhausted)
+    .define_method("scanned", &NearDuplicateScan::scanned)
+    .define_method("pair_count", &NearDuplicateScan::pair_count)
+    .define_method("components_so_far", [](const NearDuplicateScan& scan) {
+      Rice::Array arr;
+      for (auto& group : scan.components()) {
+        Rice::Array g;
+        for (auto& pk : group) g.push(pk);
+        arr.push(g);
+      }
+      return arr;
+    });
+}
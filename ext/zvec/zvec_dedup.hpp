@@ -0,0 +1,71 @@
+#pragma once
+
+#include "zvec_common.hpp"
+#include "zvec_cursor.hpp"
+
+#include <unordered_map>
+#include <unordered_set>
+
+namespace zvec_rb {
+
+// Batched self-join over a vector field: every document matching the filter
+// is used as a query against the field's own index, and neighbours within
+// threshold are reported once per unordered pair. Documents are read one scan
+// page at a time and each page's queries run on a pool of native threads, so
+// memory stays bounded to a page plus the pairs found.
+class NearDuplicateScan {
+ public:
+  struct Pair {
+    std::string a;  // a < b
+    std::string b;
+    float score;
+  };
+
+  NearDuplicateScan(zvec::Collection::Ptr collection, const zvec::FieldSchema& field,
+                    float threshold, uint32_t topk_per_doc, uint32_t concurrency,
+                    const std::string& filter, uint32_t batch_size,
+                    zvec::QueryParams::Ptr query_params);
+
+  // Process the next scan page. Runs without the GVL; engine errors are
+  // returned rather than raised.
+  zvec::Status next_page(std::vector<Pair>& pairs);
+
+  bool exhausted() const { return exhausted_; }
+  uint64_t scanned() const { return scanned_; }
+  uint64_t pair_count() const { return pair_count_; }
+
+  // Groups (size >= 2) of the pairs found so far, linked transitively
+  std::vector<std::vector<std::string>> components() const;
+
+ private:
+  // Whether score is within threshold for the field's metric
+  bool within(float score) const { return higher_is_closer_ ? score >= threshold_ : score <= threshold_; }
+  uint32_t node(const std::string& pk);
+  uint32_t find(uint32_t x) const;
+  void unite(uint32_t x, uint32_t y);
+
+  zvec::Collection::Ptr collection_;
+  std::string field_;
+  zvec::DataType data_type_;
+  bool higher_is_closer_;
+  float threshold_;
+  uint32_t topk_;
+  uint32_t concurrency_;
+  std::string filter_;
+  zvec::QueryParams::Ptr query_params_;
+  ScanPager pager_;
+
+  bool exhausted_ = false;
+  uint64_t scanned_ = 0;
+  uint64_t pair_count_ = 0;
+  // Pairs already reported, as (node(a), node(b)) with a < b; a pair is
+  // usually found from both ends. Node ids are one per pk, so this is exact.
+  std::unordered_set<uint64_t> seen_;
+
+  // Union-find over pks that appear in a pair
+  std::unordered_map<std::string, uint32_t> ids_;
+  std::vector<std::string> pks_;
+  mutable std::vector<uint32_t> parent_;
+};
+
+}  // namespace zvec_rb
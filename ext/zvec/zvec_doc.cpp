@@ -1,13 +1,41 @@
-#include "zvec_common.hpp"
+#include "zvec_doc.hpp"
+#include "zvec_kernels.hpp"
+
+#include <cstring>
 
 using namespace Rice;
+using zvec_rb::doc_set_field;
+using zvec_rb::doc_set_packed_vector;
 using float16_t = zvec::ailego::Float16;
 
+// The conversion kernels write IEEE half floats as raw uint16_t
+static_assert(sizeof(float16_t) == sizeof(uint16_t), "Float16 must be 2 bytes");
+
 static inline Rice::Object rb_nil() { return Rice::Object(Qnil); }
 
-// Set a field on a Doc using a DataType discriminator
-static void doc_set_field(zvec::Doc& doc, const std::string& name,
-                          zvec::DataType dt, Rice::Object value) {
+// Convert floats to a Float16 vector with the SIMD kernel
+static std::vector<float16_t> to_fp16(const float* src, size_t n) {
+  std::vector<float16_t> vec(n);
+  zvec_rb::kernels::f32_to_f16(src, reinterpret_cast<uint16_t*>(vec.data()), n);
+  return vec;
+}
+
+// Pack signed 4-bit values (one per int8_t) two per byte. Odd lengths are
+// rejected: the stored bytes do not record the dimension, so a padding
+// nibble would read back as a trailing 0.
+static std::vector<int8_t> to_int4(const int8_t* src, size_t n) {
+  if (n % 2 != 0) throw std::invalid_argument("VECTOR_INT4 needs an even dimension, got " + std::to_string(n));
+  for (size_t i = 0; i < n; i++) {
+    if (src[i] < -8 || src[i] > 7) throw std::range_error("VECTOR_INT4 values must be in -8..7");
+  }
+  std::vector<int8_t> vec(zvec_rb::kernels::int4_packed_size(n));
+  zvec_rb::kernels::pack_int4(src, reinterpret_cast<uint8_t*>(vec.data()), n);
+  return vec;
+}
+
+void zvec_rb::doc_set_field(zvec::Doc& doc, const std::string& name,
+                           zvec::DataType dt, Rice::Object value,
+                           std::pmr::memory_resource* scratch) {
   if (value.is_nil()) {
     doc.set_null(name);
     return;
@@ -59,10 +87,10 @@ static void doc_set_field(zvec::Doc& doc, const std::string& name,
     }
     case zvec::DataType::VECTOR_FP16: {
       Rice::Array arr(value);
-      std::vector<float16_t> vec(arr.size());
+      std::pmr::vector<float> staging(arr.size(), scratch);
       for (size_t i = 0; i < arr.size(); i++)
-        vec[i] = float16_t(Rice::detail::From_Ruby<float>().convert(arr[i].value()));
-      doc.set<std::vector<float16_t>>(name, std::move(vec));
+        staging[i] = Rice::detail::From_Ruby<float>().convert(arr[i].value());
+      doc.set<std::vector<float16_t>>(name, to_fp16(staging.data(), staging.size()));
       break;
     }
     case zvec::DataType::VECTOR_INT8: {
@@ -99,10 +127,10 @@ static void doc_set_field(zvec::Doc& doc, const std::string& name,
     }
     case zvec::DataType::VECTOR_INT4: {
       Rice::Array arr(value);
-      std::vector<int8_t> vec(arr.size());
+      std::pmr::vector<int8_t> staging(arr.size(), scratch);
       for (size_t i = 0; i < arr.size(); i++)
-        vec[i] = static_cast<int8_t>(Rice::detail::From_Ruby<int>().convert(arr[i].value()));
-      doc.set<std::vector<int8_t>>(name, std::move(vec));
+        staging[i] = static_cast<int8_t>(Rice::detail::From_Ruby<int>().convert(arr[i].value()));
+      doc.set<std::vector<int8_t>>(name, to_int4(staging.data(), staging.size()));
       break;
     }
 
@@ -111,6 +139,8 @@ static void doc_set_field(zvec::Doc& doc, const std::string& name,
       Rice::Hash h(value);
       std::vector<uint32_t> indices;
       std::vector<float> values;
+      indices.reserve(h.size());
+      values.reserve(h.size());
       for (auto it = h.begin(); it != h.end(); ++it) {
         indices.push_back(Rice::detail::From_Ruby<uint32_t>().convert((*it).first.value()));
         values.push_back(Rice::detail::From_Ruby<float>().convert((*it).second.value()));
@@ -123,6 +153,8 @@ static void doc_set_field(zvec::Doc& doc, const std::string& name,
       Rice::Hash h(value);
       std::vector<uint32_t> indices;
       std::vector<float16_t> values;
+      indices.reserve(h.size());
+      values.reserve(h.size());
       for (auto it = h.begin(); it != h.end(); ++it) {
         indices.push_back(Rice::detail::From_Ruby<uint32_t>().convert((*it).first.value()));
         values.push_back(float16_t(Rice::detail::From_Ruby<float>().convert((*it).second.value())));
@@ -277,8 +309,11 @@ static Rice::Object doc_get_field(const zvec::Doc& doc, const std::string& name,
     case zvec::DataType::VECTOR_FP16: {
       auto r = doc.get<std::vector<float16_t>>(name);
       if (!r) return rb_nil();
+      std::vector<float> decoded(r->size());
+      zvec_rb::kernels::f16_to_f32(reinterpret_cast<const uint16_t*>(r->data()),
+                                   decoded.data(), decoded.size());
       Rice::Array arr;
-      for (auto v : *r) arr.push(static_cast<float>(v));
+      for (auto v : decoded) arr.push(v);
       return arr;
     }
     case zvec::DataType::VECTOR_INT8: {
@@ -312,8 +347,11 @@ static Rice::Object doc_get_field(const zvec::Doc& doc, const std::string& name,
     case zvec::DataType::VECTOR_INT4: {
       auto r = doc.get<std::vector<int8_t>>(name);
       if (!r) return rb_nil();
+      std::vector<int8_t> decoded(r->size() * 2);
+      zvec_rb::kernels::unpack_int4(reinterpret_cast<const uint8_t*>(r->data()),
+                                    decoded.data(), decoded.size());
       Rice::Array arr;
-      for (auto v : *r) arr.push(static_cast<int>(v));
+      for (auto v : decoded) arr.push(static_cast<int>(v));
       return arr;
     }
 
@@ -401,6 +439,123 @@ static Rice::Object doc_get_field(const zvec::Doc& doc, const std::string& name,
   }
 }
 
+// Set a dense vector field from a packed binary String, skipping per-element
+// Ruby conversion. FP32/FP16 take native float32 ("f*"), FP64 takes float64
+// ("d*"), INT8/INT4 take one int8 per element ("c*"), BINARY32/64 take
+// uint32/uint64 words ("L*"/"Q*").
+void zvec_rb::doc_set_packed_vector(zvec::Doc& doc, const std::string& name,
+                                   zvec::DataType dt, Rice::Object value,
+                                   std::pmr::memory_resource* scratch) {
+  VALUE str = value.value();
+  Check_Type(str, T_STRING);
+  const char* data = RSTRING_PTR(str);
+  size_t len = static_cast<size_t>(RSTRING_LEN(str));
+
+  auto check_width = [&](size_t width) {
+    if (len % width != 0)
+      throw std::invalid_argument("packed vector length is not a multiple of the element size");
+    return len / width;
+  };
+
+  switch (dt) {
+    case zvec::DataType::VECTOR_FP32: {
+      std::vector<float> vec(check_width(sizeof(float)));
+      std::memcpy(vec.data(), data, len);
+      doc.set<std::vector<float>>(name, std::move(vec));
+      break;
+    }
+    case zvec::DataType::VECTOR_FP64: {
+      std::vector<double> vec(check_width(sizeof(double)));
+      std::memcpy(vec.data(), data, len);
+      doc.set<std::vector<double>>(name, std::move(vec));
+      break;
+    }
+    case zvec::DataType::VECTOR_FP16: {
+      // The String's bytes may not be float-aligned
+      std::pmr::vector<float> staging(check_width(sizeof(float)), scratch);
+      std::memcpy(staging.data(), data, len);
+      doc.set<std::vector<float16_t>>(name, to_fp16(staging.data(), staging.size()));
+      break;
+    }
+    case zvec::DataType::VECTOR_INT8: {
+      std::vector<int8_t> vec(len);
+      std::memcpy(vec.data(), data, len);
+      doc.set<std::vector<int8_t>>(name, std::move(vec));
+      break;
+    }
+    case zvec::DataType::VECTOR_INT4:
+      doc.set<std::vector<int8_t>>(name, to_int4(reinterpret_cast<const int8_t*>(data), len));
+      break;
+    case zvec::DataType::VECTOR_BINARY32: {
+      std::vector<uint32_t> vec(check_width(sizeof(uint32_t)));
+      std::memcpy(vec.data(), data, len);
+      doc.set<std::vector<uint32_t>>(name, std::move(vec));
+      break;
+    }
+    case zvec::DataType::VECTOR_BINARY64: {
+      std::vector<uint64_t> vec(check_width(sizeof(uint64_t)));
+      std::memcpy(vec.data(), data, len);
+      doc.set<std::vector<uint64_t>>(name, std::move(vec));
+      break;
+    }
+    default:
+      throw std::invalid_argument("set_packed_vector does not support this DataType");
+  }
+}
+
+// Inverse of doc_set_packed_vector: FP16 decodes to float32, INT4 unpacks to
+// one int8 per element
+static Rice::Object doc_get_packed_vector(const zvec::Doc& doc, const std::string& name,
+                                          zvec::DataType dt) {
+  if (!doc.has(name) || doc.is_null(name)) return rb_nil();
+
+  switch (dt) {
+    case zvec::DataType::VECTOR_FP32: {
+      auto r = doc.get<std::vector<float>>(name);
+      if (!r) return rb_nil();
+      return Rice::Object(rb_str_new(reinterpret_cast<const char*>(r->data()), r->size() * sizeof(float)));
+    }
+    case zvec::DataType::VECTOR_FP64: {
+      auto r = doc.get<std::vector<double>>(name);
+      if (!r) return rb_nil();
+      return Rice::Object(rb_str_new(reinterpret_cast<const char*>(r->data()), r->size() * sizeof(double)));
+    }
+    case zvec::DataType::VECTOR_FP16: {
+      auto r = doc.get<std::vector<float16_t>>(name);
+      if (!r) return rb_nil();
+      VALUE str = rb_str_new(nullptr, static_cast<long>(r->size() * sizeof(float)));
+      zvec_rb::kernels::f16_to_f32(reinterpret_cast<const uint16_t*>(r->data()),
+                                   reinterpret_cast<float*>(RSTRING_PTR(str)), r->size());
+      return Rice::Object(str);
+    }
+    case zvec::DataType::VECTOR_INT8: {
+      auto r = doc.get<std::vector<int8_t>>(name);
+      if (!r) return rb_nil();
+      return Rice::Object(rb_str_new(reinterpret_cast<const char*>(r->data()), r->size()));
+    }
+    case zvec::DataType::VECTOR_INT4: {
+      auto r = doc.get<std::vector<int8_t>>(name);
+      if (!r) return rb_nil();
+      VALUE str = rb_str_new(nullptr, static_cast<long>(r->size() * 2));
+      zvec_rb::kernels::unpack_int4(reinterpret_cast<const uint8_t*>(r->data()),
+                                    reinterpret_cast<int8_t*>(RSTRING_PTR(str)), r->size() * 2);
+      return Rice::Object(str);
+    }
+    case zvec::DataType::VECTOR_BINARY32: {
+      auto r = doc.get<std::vector<uint32_t>>(name);
+      if (!r) return rb_nil();
+      return Rice::Object(rb_str_new(reinterpret_cast<const char*>(r->data()), r->size() * sizeof(uint32_t)));
+    }
+    case zvec::DataType::VECTOR_BINARY64: {
+      auto r = doc.get<std::vector<uint64_t>>(name);
+      if (!r) return rb_nil();
+      return Rice::Object(rb_str_new(reinterpret_cast<const char*>(r->data()), r->size() * sizeof(uint64_t)));
+    }
+    default:
+      throw std::invalid_argument("packed_vector does not support this DataType");
+  }
+}
+
 void init_zvec_doc(Rice::Module& m) {
   Rice::define_class_under<zvec::Doc>(m, "Doc")
     .define_constructor(Rice::Constructor<zvec::Doc>())
@@ -436,5 +591,14 @@ void init_zvec_doc(Rice::Module& m) {
                                              const zvec::FieldSchema& fs,
                                              Rice::Object value) {
       doc_set_field(doc, name, fs.data_type(), value);
+    })
+    // Bulk vector I/O through packed binary Strings
+    .define_method("set_packed_vector", [](zvec::Doc& doc, const std::string& name,
+                                           zvec::DataType dt, Rice::Object value) {
+      doc_set_packed_vector(doc, name, dt, value);
+    })
+    .define_method("packed_vector", [](const zvec::Doc& doc, const std::string& name,
+                                       zvec::DataType dt) -> Rice::Object {
+      return doc_get_packed_vector(doc, name, dt);
     });
 }
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "zvec_common.hpp"
+
+#include <memory_resource>
+
+namespace zvec_rb {
+
+// Set a field on a Doc from a Ruby value using a DataType discriminator.
+// Staging buffers that do not end up in the Doc come from scratch.
+void doc_set_field(zvec::Doc& doc, const std::string& name, zvec::DataType dt, Rice::Object value,
+                   std::pmr::memory_resource* scratch = std::pmr::get_default_resource());
+
+// Set a dense vector field from a packed binary String (see Doc#set_packed_vector)
+void doc_set_packed_vector(zvec::Doc& doc, const std::string& name, zvec::DataType dt,
+                           Rice::Object value,
+                           std::pmr::memory_resource* scratch = std::pmr::get_default_resource());
+
+}  // namespace zvec_rb
@@ -0,0 +1,214 @@
+#include "zvec_doc_builder.hpp"
+#include "zvec_arena.hpp"
+#include "zvec_doc.hpp"
+
+using namespace Rice;
+
+namespace zvec_rb {
+
+static bool is_dense(zvec::DataType t) {
+  switch (t) {
+    case zvec::DataType::VECTOR_FP16:
+    case zvec::DataType::VECTOR_FP32:
+    case zvec::DataType::VECTOR_FP64:
+    case zvec::DataType::VECTOR_INT4:
+    case zvec::DataType::VECTOR_INT8:
+    case zvec::DataType::VECTOR_INT16:
+    case zvec::DataType::VECTOR_BINARY32:
+    case zvec::DataType::VECTOR_BINARY64:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Array of Floats/Integers straight into float32, without a Rice conversion
+// per element. Returns false for anything else so the caller can fall back.
+static bool fp32_from_array(VALUE arr, std::vector<float>& out) {
+  long n = RARRAY_LEN(arr);
+  const VALUE* p = RARRAY_CONST_PTR(arr);
+  out.resize(static_cast<size_t>(n));
+  for (long i = 0; i < n; i++) {
+    VALUE v = p[i];
+    if (RB_FLOAT_TYPE_P(v)) out[i] = static_cast<float>(RFLOAT_VALUE(v));
+    else if (RB_FIXNUM_P(v)) out[i] = static_cast<float>(FIX2LONG(v));
+    else return false;
+  }
+  return true;
+}
+
+static VALUE lookup(VALUE row, VALUE str_key, ID id) {
+  VALUE v = rb_hash_lookup2(row, str_key, Qundef);
+  return v == Qundef ? rb_hash_lookup2(row, ID2SYM(id), Qundef) : v;
+}
+
+DocBuilder::DocBuilder(const zvec::CollectionSchema& schema) {
+  for (const auto& name : schema.all_field_names()) {
+    const zvec::FieldSchema* fs = schema.get_field(name);
+    if (!fs) continue;
+    slots_.push_back(Slot{name, rb_intern(name.c_str()), fs->data_type(),
+                          is_dense(fs->data_type()) ? fs->dimension() : 0});
+  }
+}
+
+std::vector<std::string> DocBuilder::field_names() const {
+  std::vector<std::string> out;
+  for (const auto& s : slots_) out.push_back(s.name);
+  return out;
+}
+
+VALUE DocBuilder::string_keys() const {
+  VALUE keys = rb_ary_new_capa(static_cast<long>(slots_.size() + 2));
+  for (const auto& s : slots_) {
+    rb_ary_push(keys, rb_obj_freeze(rb_utf8_str_new(s.name.data(), static_cast<long>(s.name.size()))));
+  }
+  rb_ary_push(keys, rb_obj_freeze(rb_utf8_str_new_cstr("pk")));
+  rb_ary_push(keys, rb_obj_freeze(rb_utf8_str_new_cstr("score")));
+  return keys;
+}
+
+void DocBuilder::convert(VALUE row, VALUE keys, zvec::Doc& doc,
+                         std::pmr::memory_resource* scratch) const {
+  if (!RB_TYPE_P(row, T_HASH)) throw std::invalid_argument("row is not a Hash");
+
+  // Every key must be matched, so a typo'd field is an error, not a dropped value
+  size_t matched = 0;
+  bool pk_is_field = false;
+  bool score_is_field = false;
+  for (size_t i = 0; i < slots_.size(); i++) {
+    const Slot& s = slots_[i];
+    pk_is_field |= s.name == "pk";
+    score_is_field |= s.name == "score";
+    VALUE v = lookup(row, RARRAY_AREF(keys, i), s.id);
+    if (v == Qundef) continue;
+    matched++;
+    try {
+      if (s.dimension && RB_TYPE_P(v, T_ARRAY)) {
+        if (static_cast<uint32_t>(RARRAY_LEN(v)) != s.dimension)
+          throw std::invalid_argument("expected " + std::to_string(s.dimension) + " values, got " +
+                                      std::to_string(RARRAY_LEN(v)));
+        std::vector<float> vec;
+        if (s.type == zvec::DataType::VECTOR_FP32 && fp32_from_array(v, vec)) {
+          doc.set<std::vector<float>>(s.name, std::move(vec));
+          continue;
+        }
+      }
+      if (s.dimension && RB_TYPE_P(v, T_STRING)) {
+        doc_set_packed_vector(doc, s.name, s.type, Rice::Object(v), scratch);
+      } else {
+        doc_set_field(doc, s.name, s.type, Rice::Object(v), scratch);
+      }
+    } catch (const std::exception& e) {
+      throw std::invalid_argument(s.name + ": " + e.what());
+    }
+  }
+
+  // "pk" and "score" as in Doc#to_h, unless the schema has fields by those names
+  VALUE pk = lookup(row, RARRAY_AREF(keys, slots_.size()), rb_intern("pk"));
+  if (pk != Qundef) {
+    if (!RB_TYPE_P(pk, T_STRING)) throw std::invalid_argument("pk must be a String");
+    doc.set_pk(std::string(RSTRING_PTR(pk), RSTRING_LEN(pk)));
+    if (!pk_is_field) matched++;
+  }
+  VALUE score = lookup(row, RARRAY_AREF(keys, slots_.size() + 1), rb_intern("score"));
+  if (score != Qundef && !score_is_field) {
+    if (RB_FLOAT_TYPE_P(score)) doc.set_score(static_cast<float>(RFLOAT_VALUE(score)));
+    matched++;
+  }
+  if (matched < RHASH_SIZE(row)) throw std::invalid_argument("row has keys that are not schema fields");
+}
+
+zvec::Doc DocBuilder::build(VALUE row) const {
+  VALUE keys = string_keys();
+  zvec::Doc doc;
+  convert(row, keys, doc, std::pmr::get_default_resource());
+  RB_GC_GUARD(keys);
+  return doc;
+}
+
+DocBatch DocBuilder::build_many(VALUE rows) const {
+  if (!RB_TYPE_P(rows, T_ARRAY)) throw std::invalid_argument("rows must be an Array of Hashes");
+  VALUE keys = string_keys();
+  ScratchArena arena;
+  DocBatch batch;
+  long n = RARRAY_LEN(rows);
+  batch.docs.reserve(static_cast<size_t>(n));
+  batch.rows.reserve(static_cast<size_t>(n));
+  for (long i = 0; i < n; i++) {
+    zvec::Doc doc;
+    try {
+      convert(RARRAY_AREF(rows, i), keys, doc, arena.resource());
+    } catch (const std::exception& e) {
+      batch.errors.emplace_back(static_cast<size_t>(i), e.what());
+      continue;
+    }
+    batch.docs.push_back(std::move(doc));
+    batch.rows.push_back(static_cast<size_t>(i));
+  }
+  RB_GC_GUARD(keys);
+  return batch;
+}
+
+
+WriteDocs::WriteDocs(Rice::Object obj) {
+  if (!RB_TYPE_P(obj.value(), T_ARRAY)) {
+    DocBatch* batch = Rice::detail::From_Ruby<DocBatch*>().convert(obj.value());
+    lock_ = std::unique_lock<std::mutex>(*batch->writing, std::try_to_lock);
+    if (lock_.owns_lock()) in_place_ = &batch->docs;
+    else owned_ = batch->docs;
+    return;
+  }
+  long n = RARRAY_LEN(obj.value());
+  owned_.reserve(static_cast<size_t>(n));
+  for (long i = 0; i < n; i++) {
+    owned_.emplace_back(*Rice::detail::From_Ruby<zvec::Doc*>().convert(RARRAY_AREF(obj.value(), i)));
+  }
+}
+
+}  // namespace zvec_rb
+
+using zvec_rb::DocBatch;
+using zvec_rb::DocBuilder;
+
+void init_zvec_doc_builder(Rice::Module& m) {
+  Rice::define_class_under<DocBuilder>(m, "DocBuilder")
+    .define_constructor(Rice::Constructor<DocBuilder, const zvec::CollectionSchema&>())
+    .define_method("field_names", &DocBuilder::field_names)
+    .define_method("build", [](const DocBuilder& b, Rice::Object row) {
+      return b.build(row.value());
+    })
+    .define_method("build_many", [](const DocBuilder& b, Rice::Object rows) {
+      return b.build_many(rows.value());
+    });
+
+  Rice::define_class_under<DocBatch>(m, "DocBatch")
+    .define_method("size", [](const DocBatch& b) { return b.docs.size(); })
+    .define_method("error_count", [](const DocBatch& b) { return b.errors.size(); })
+    .define_method("ok?", [](const DocBatch& b) { return b.errors.empty(); })
+    // Input index of each converted doc
+    .define_method("rows", [](const DocBatch& b) {
+      Rice::Array arr;
+      for (size_t r : b.rows) arr.push(r);
+      return arr;
+    })
+    // [input_index, message] for each row that failed to convert
+    .define_method("errors", [](const DocBatch& b) {
+      Rice::Array arr;
+      for (const auto& [row, message] : b.errors) {
+        Rice::Array e;
+        e.push(row);
+        e.push(message);
+        arr.push(e);
+      }
+      return arr;
+    })
+    // Copies, so the batch stays usable for writes
+    .define_method("docs", [](const DocBatch& b) {
+      Rice::Array arr;
+      for (const auto& d : b.docs) {
+        zvec::Doc copy(d);
+        arr.push(Rice::Object(Rice::detail::To_Ruby<zvec::Doc>().convert(std::move(copy))));
+      }
+      return arr;
+    });
+}
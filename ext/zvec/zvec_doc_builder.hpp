@@ -0,0 +1,70 @@
+#pragma once
+
+#include "zvec_common.hpp"
+
+#include <memory_resource>
+#include <mutex>
+
+namespace zvec_rb {
+
+// Docs converted from Hash rows in one native call. Rows that failed to
+// convert are left out of docs and reported in errors by input index.
+struct DocBatch {
+  std::vector<zvec::Doc> docs;
+  std::vector<size_t> rows;  // input index of each doc
+  std::vector<std::pair<size_t, std::string>> errors;
+  // Held while a write hands docs to the engine in place (see WriteDocs)
+  std::shared_ptr<std::mutex> writing = std::make_shared<std::mutex>();
+};
+
+// Converts Hash rows to Docs for one schema. The field -> type/dimension
+// table is built once, so a row costs one Hash lookup per field and a
+// conversion chosen without any Ruby-level dispatch.
+class DocBuilder {
+ public:
+  explicit DocBuilder(const zvec::CollectionSchema& schema);
+
+  // Convert one row; throws on the first bad field
+  zvec::Doc build(VALUE row) const;
+  DocBatch build_many(VALUE rows) const;
+
+  std::vector<std::string> field_names() const;
+
+ private:
+  struct Slot {
+    std::string name;
+    ID id;
+    zvec::DataType type;
+    uint32_t dimension;  // 0 unless a dense vector
+  };
+
+  // A frozen String key per slot, then "pk" and "score". Built once per call
+  // and kept on the Ruby stack for the whole conversion.
+  VALUE string_keys() const;
+  void convert(VALUE row, VALUE keys, zvec::Doc& doc, std::pmr::memory_resource* scratch) const;
+
+  std::vector<Slot> slots_;
+};
+
+// Docs for Collection/PartitionedCollection writes from an Array of Doc or
+// a DocBatch. A batch is handed to the engine in place, without copying a
+// Doc, and is left intact so it can be written again. If another write is
+// using the same batch, this one falls back to a copy rather than waiting
+// (the waiter would hold the GVL the other write needs to finish). Array
+// elements are copied once, since the Ruby Docs stay usable.
+class WriteDocs {
+ public:
+  explicit WriteDocs(Rice::Object obj);
+
+  std::vector<zvec::Doc>& get() { return in_place_ ? *in_place_ : owned_; }
+  size_t size() const { return in_place_ ? in_place_->size() : owned_.size(); }
+  // Owned docs for a caller that keeps them past this call
+  std::vector<zvec::Doc> take() { return in_place_ ? *in_place_ : std::move(owned_); }
+
+ private:
+  std::unique_lock<std::mutex> lock_;
+  std::vector<zvec::Doc>* in_place_ = nullptr;
+  std::vector<zvec::Doc> owned_;
+};
+
+}  // namespace zvec_rb
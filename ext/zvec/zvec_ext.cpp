@@ -2,6 +2,11 @@
 #include "zvec_ext.hpp"
 
 void Init_zvec_ext() {
+  // Every method defined below may be called from non-main Ractors. Binding
+  // state shared across Ractors (collection registries, filter plan cache) is
+  // mutex-guarded, and the exception classes are only assigned here.
+  rb_ext_ractor_safe(true);
+
   Rice::Module rb_mZvec = Rice::define_module("Zvec");
 
   rb_mZvec.define_module_function("zvec_available?", []() -> bool {
@@ -11,9 +16,25 @@ void Init_zvec_ext() {
   // Initialize all binding modules in dependency order
   init_zvec_types(rb_mZvec);
   init_zvec_status(rb_mZvec);
+  init_zvec_write_result(rb_mZvec);
   init_zvec_params(rb_mZvec);
   init_zvec_schema(rb_mZvec);
   init_zvec_doc(rb_mZvec);
+  init_zvec_doc_builder(rb_mZvec);
+  init_zvec_filter(rb_mZvec);
+  init_zvec_quantize(rb_mZvec);
+  init_zvec_cursor(rb_mZvec);
+  init_zvec_dedup(rb_mZvec);
+  init_zvec_brute_force(rb_mZvec);
+  init_zvec_ivf(rb_mZvec);
+  init_zvec_maxsim(rb_mZvec);
+  init_zvec_group_results(rb_mZvec);
+  init_zvec_refine(rb_mZvec);
+  init_zvec_profile(rb_mZvec);
+  init_zvec_stats(rb_mZvec);
+  init_zvec_instrument(rb_mZvec);
   init_zvec_collection(rb_mZvec);
+  init_zvec_partition(rb_mZvec);
+  init_zvec_builder(rb_mZvec);
   init_zvec_config(rb_mZvec);
 }
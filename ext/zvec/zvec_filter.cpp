@@ -0,0 +1,308 @@
+#include "zvec_filter.hpp"
+
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+
+using namespace Rice;
+
+namespace zvec_rb {
+
+std::vector<FilterToken> tokenize_filter(const std::string& text) {
+  static const std::unordered_set<std::string> keywords = {
+    "AND", "OR", "NOT", "LIKE", "IN", "IS", "NULL", "TRUE", "FALSE"};
+
+  std::vector<FilterToken> tokens;
+  int depth = 0;
+  size_t i = 0;
+  while (i < text.size()) {
+    char c = text[i];
+    size_t start = i;
+    if (std::isspace(static_cast<unsigned char>(c))) {
+      i++;
+      continue;
+    }
+    if (std::isalpha(static_cast<unsigned char>(c)) || c == '_') {
+      while (i < text.size() && (std::isalnum(static_cast<unsigned char>(text[i])) || text[i] == '_' || text[i] == '.')) i++;
+      std::string word = text.substr(start, i - start);
+      std::string upper = word;
+      for (auto& ch : upper) ch = static_cast<char>(std::toupper(static_cast<unsigned char>(ch)));
+      if (keywords.count(upper)) {
+        tokens.push_back({FilterToken::Kind::KEYWORD, upper, start, i - start});
+      } else {
+        tokens.push_back({FilterToken::Kind::IDENT, word, start, i - start});
+      }
+    } else if (std::isdigit(static_cast<unsigned char>(c)) ||
+               ((c == '-' || c == '.') && i + 1 < text.size() && std::isdigit(static_cast<unsigned char>(text[i + 1])))) {
+      i++;
+      while (i < text.size() && (std::isalnum(static_cast<unsigned char>(text[i])) || text[i] == '.' ||
+                                 ((text[i] == '-' || text[i] == '+') && (text[i - 1] == 'e' || text[i - 1] == 'E')))) i++;
+      tokens.push_back({FilterToken::Kind::NUMBER, text.substr(start, i - start), start, i - start});
+    } else if (c == '\'' || c == '"') {
+      i++;
+      while (i < text.size() && text[i] != c) i += text[i] == '\\' ? 2 : 1;
+      if (i >= text.size()) throw std::invalid_argument("unterminated string in filter at offset " + std::to_string(start));
+      i++;
+      tokens.push_back({FilterToken::Kind::STRING, text.substr(start, i - start), start, i - start});
+    } else if (c == '=' || c == '<' || c == '>' || c == '!') {
+      i++;
+      if (i < text.size() && (text[i] == '=' || (c == '<' && text[i] == '>'))) i++;
+      std::string op = text.substr(start, i - start);
+      if (op == "!") throw std::invalid_argument("unexpected '!' in filter at offset " + std::to_string(start));
+      tokens.push_back({FilterToken::Kind::OP, op, start, i - start});
+    } else if (c == '(' || c == ')' || c == ',' || c == '?') {
+      i++;
+      auto kind = c == '(' ? FilterToken::Kind::LPAREN
+                : c == ')' ? FilterToken::Kind::RPAREN
+                : c == ',' ? FilterToken::Kind::COMMA
+                           : FilterToken::Kind::PLACEHOLDER;
+      if (c == '(') depth++;
+      if (c == ')' && --depth < 0) throw std::invalid_argument("unbalanced ')' in filter at offset " + std::to_string(start));
+      tokens.push_back({kind, std::string(1, c), start, 1});
+    } else {
+      throw std::invalid_argument(std::string("unexpected '") + c + "' in filter at offset " + std::to_string(start));
+    }
+  }
+  if (depth != 0) throw std::invalid_argument("unbalanced '(' in filter");
+  return tokens;
+}
+
+// Field a placeholder is compared against: `f op ?`, `? op f`, `f LIKE ?`
+// or a member of `f [NOT] IN (?, ...)`
+static std::string placeholder_field(const std::vector<FilterToken>& t, size_t i) {
+  using K = FilterToken::Kind;
+  if (i >= 2 && (t[i - 1].kind == K::OP || (t[i - 1].kind == K::KEYWORD && t[i - 1].text == "LIKE")) &&
+      t[i - 2].kind == K::IDENT) {
+    return t[i - 2].text;
+  }
+  if (i + 2 < t.size() && t[i + 1].kind == K::OP && t[i + 2].kind == K::IDENT) {
+    return t[i + 2].text;
+  }
+  if (i >= 1 && (t[i - 1].kind == K::LPAREN || t[i - 1].kind == K::COMMA)) {
+    size_t j = i - 1;
+    while (j > 0 && t[j].kind != K::LPAREN) j--;
+    if (t[j].kind == K::LPAREN && j >= 2 && t[j - 1].kind == K::KEYWORD && t[j - 1].text == "IN") {
+      size_t f = j - 2;
+      if (t[f].kind == K::KEYWORD && t[f].text == "NOT" && f >= 1) f--;
+      if (t[f].kind == K::IDENT) return t[f].text;
+    }
+  }
+  return "";
+}
+
+static std::shared_ptr<const FilterPlan> parse_plan(const std::string& source) {
+  auto plan = std::make_shared<FilterPlan>();
+  plan->source = source;
+  plan->tokens = tokenize_filter(source);
+
+  std::unordered_set<std::string> seen;
+  const auto& t = plan->tokens;
+  for (size_t i = 0; i < t.size(); i++) {
+    if (t[i].kind == FilterToken::Kind::PLACEHOLDER) {
+      plan->placeholder_offsets.push_back(t[i].offset);
+      plan->placeholder_fields.push_back(placeholder_field(t, i));
+    } else if (t[i].kind == FilterToken::Kind::IDENT) {
+      // Identifiers followed by '(' are engine functions, not fields
+      bool is_call = i + 1 < t.size() && t[i + 1].kind == FilterToken::Kind::LPAREN;
+      if (!is_call && seen.insert(t[i].text).second) plan->fields.push_back(t[i].text);
+    }
+  }
+  return plan;
+}
+
+// Least recently used plans are evicted past kFilterPlanCacheLimit, so
+// templates built per request cannot grow the cache without bound
+static std::mutex g_plan_mutex;
+static std::list<std::string> g_plan_order;  // most recently used first
+struct CachedPlan {
+  std::shared_ptr<const FilterPlan> plan;
+  std::list<std::string>::iterator order;
+};
+static std::unordered_map<std::string, CachedPlan> g_plans;
+
+std::shared_ptr<const FilterPlan> filter_plan(const std::string& source) {
+  {
+    std::lock_guard<std::mutex> lock(g_plan_mutex);
+    auto it = g_plans.find(source);
+    if (it != g_plans.end()) {
+      g_plan_order.splice(g_plan_order.begin(), g_plan_order, it->second.order);
+      return it->second.plan;
+    }
+  }
+  auto plan = parse_plan(source);
+  std::lock_guard<std::mutex> lock(g_plan_mutex);
+  auto [it, inserted] = g_plans.emplace(source, CachedPlan{std::move(plan), {}});
+  if (!inserted) return it->second.plan;  // parsed by another thread meanwhile
+  g_plan_order.push_front(source);
+  it->second.order = g_plan_order.begin();
+  if (g_plans.size() > kFilterPlanCacheLimit) {
+    g_plans.erase(g_plan_order.back());
+    g_plan_order.pop_back();
+  }
+  return it->second.plan;
+}
+
+size_t filter_plan_cache_size() {
+  std::lock_guard<std::mutex> lock(g_plan_mutex);
+  return g_plans.size();
+}
+
+void clear_filter_plan_cache() {
+  std::lock_guard<std::mutex> lock(g_plan_mutex);
+  g_plans.clear();
+  g_plan_order.clear();
+}
+
+// Scalar type a placeholder on this field must bind to
+static zvec::DataType slot_type(const zvec::FieldSchema& fs) {
+  switch (fs.data_type()) {
+    case zvec::DataType::ARRAY_STRING: return zvec::DataType::STRING;
+    case zvec::DataType::ARRAY_BOOL: return zvec::DataType::BOOL;
+    case zvec::DataType::ARRAY_INT32: return zvec::DataType::INT32;
+    case zvec::DataType::ARRAY_INT64: return zvec::DataType::INT64;
+    case zvec::DataType::ARRAY_UINT32: return zvec::DataType::UINT32;
+    case zvec::DataType::ARRAY_UINT64: return zvec::DataType::UINT64;
+    case zvec::DataType::ARRAY_FLOAT: return zvec::DataType::FLOAT;
+    case zvec::DataType::ARRAY_DOUBLE: return zvec::DataType::DOUBLE;
+    default: return fs.data_type();
+  }
+}
+
+Filter::Filter(std::shared_ptr<const FilterPlan> plan, const zvec::CollectionSchema* schema)
+    : plan_(std::move(plan)),
+      slot_types_(plan_->placeholder_offsets.size(), zvec::DataType::UNDEFINED) {
+  if (!schema) return;
+  for (const auto& name : plan_->fields) {
+    const zvec::FieldSchema* fs = schema->get_field(name);
+    if (!fs) throw std::invalid_argument("Unknown field in filter: " + name);
+    if (fs->is_vector_field()) throw std::invalid_argument("Cannot filter on vector field: " + name);
+  }
+  for (size_t s = 0; s < slot_types_.size(); s++) {
+    const std::string& name = plan_->placeholder_fields[s];
+    if (name.empty()) continue;
+    // Not a schema field when it names a function, as in `? = lower(x)`
+    const zvec::FieldSchema* fs = schema->get_field(name);
+    if (!fs) {
+      throw std::invalid_argument("filter value " + std::to_string(s + 1) +
+                                  " is compared against unknown field " + name);
+    }
+    slot_types_[s] = slot_type(*fs);
+  }
+}
+
+std::string Filter::render(const std::vector<std::string>& literals) const {
+  if (literals.size() != placeholder_count()) {
+    throw std::invalid_argument("filter expects " + std::to_string(placeholder_count()) +
+                                " values, got " + std::to_string(literals.size()));
+  }
+  std::string out;
+  size_t pos = 0;
+  for (size_t s = 0; s < literals.size(); s++) {
+    size_t at = plan_->placeholder_offsets[s];
+    out.append(plan_->source, pos, at - pos);
+    out.append(literals[s]);
+    pos = at + 1;
+  }
+  out.append(plan_->source, pos, std::string::npos);
+  return out;
+}
+
+}  // namespace zvec_rb
+
+using zvec_rb::Filter;
+
+// Format one bound value as a filter literal of the slot's type. Strings are
+// quoted and may not contain quotes or backslashes, so a bound value can never
+// change the structure of the expression. (The engine's escape handling is
+// not documented, so escaping them is not relied on.)
+static std::string filter_literal(VALUE v, zvec::DataType type, size_t slot) {
+  auto fail = [&](const char* expected) -> std::string {
+    VALUE s = rb_inspect(v);
+    throw std::invalid_argument("filter value " + std::to_string(slot + 1) + " must be " + expected +
+                                ", got " + std::string(RSTRING_PTR(s), RSTRING_LEN(s)));
+  };
+
+  switch (type) {
+    case zvec::DataType::INT32:
+    case zvec::DataType::INT64:
+    case zvec::DataType::UINT32:
+    case zvec::DataType::UINT64: {
+      if (!RB_INTEGER_TYPE_P(v)) return fail("an Integer");
+      if (type == zvec::DataType::UINT32 || type == zvec::DataType::UINT64) {
+        if (RTEST(rb_funcall(v, rb_intern("negative?"), 0))) return fail("a non-negative Integer");
+        uint64_t n = Rice::detail::From_Ruby<uint64_t>().convert(v);
+        if (type == zvec::DataType::UINT32 && n > UINT32_MAX) throw std::range_error("filter value out of range for UINT32");
+        return std::to_string(n);
+      }
+      int64_t n = Rice::detail::From_Ruby<int64_t>().convert(v);
+      if (type == zvec::DataType::INT32 && (n < INT32_MIN || n > INT32_MAX))
+        throw std::range_error("filter value out of range for INT32");
+      return std::to_string(n);
+    }
+    case zvec::DataType::FLOAT:
+    case zvec::DataType::DOUBLE: {
+      if (!RB_INTEGER_TYPE_P(v) && !RB_FLOAT_TYPE_P(v)) return fail("Numeric");
+      double d = NUM2DBL(v);
+      if (!std::isfinite(d)) return fail("a finite number");
+      char buf[32];
+      std::snprintf(buf, sizeof(buf), type == zvec::DataType::FLOAT ? "%.9g" : "%.17g", d);
+      return buf;
+    }
+    case zvec::DataType::BOOL:
+      if (v == Qtrue) return "true";
+      if (v == Qfalse) return "false";
+      return fail("true or false");
+    case zvec::DataType::STRING: {
+      if (!RB_TYPE_P(v, T_STRING)) return fail("a String");
+      std::string s(RSTRING_PTR(v), RSTRING_LEN(v));
+      if (s.find_first_of("'\\") != std::string::npos)
+        throw std::invalid_argument("filter string values may not contain quotes or backslashes");
+      return "'" + s + "'";
+    }
+    default:
+      // Field type unknown: let the Ruby value pick the literal
+      if (RB_INTEGER_TYPE_P(v)) return filter_literal(v, zvec::DataType::INT64, slot);
+      if (RB_FLOAT_TYPE_P(v)) return filter_literal(v, zvec::DataType::DOUBLE, slot);
+      if (v == Qtrue || v == Qfalse) return filter_literal(v, zvec::DataType::BOOL, slot);
+      if (RB_TYPE_P(v, T_STRING)) return filter_literal(v, zvec::DataType::STRING, slot);
+      return fail("an Integer, Float, String, true or false");
+  }
+}
+
+void init_zvec_filter(Rice::Module& m) {
+  Rice::define_class_under<Filter>(m, "Filter")
+    // Compile (or fetch from the plan cache) and validate against schema
+    .define_singleton_function("compile", [](const std::string& source, Rice::Object schema_obj) {
+      const zvec::CollectionSchema* schema = nullptr;
+      if (!schema_obj.is_nil()) {
+        schema = Rice::detail::From_Ruby<zvec::CollectionSchema*>().convert(schema_obj.value());
+      }
+      return Filter(zvec_rb::filter_plan(source), schema);
+    },
+      Rice::Arg("source"),
+      Rice::Arg("schema") = Rice::Object(Qnil))
+    .define_singleton_function("cache_limit", [] { return zvec_rb::kFilterPlanCacheLimit; })
+    .define_singleton_function("cache_size", &zvec_rb::filter_plan_cache_size)
+    .define_singleton_function("clear_cache", &zvec_rb::clear_filter_plan_cache)
+    .define_method("source", &Filter::source)
+    .define_method("placeholder_count", &Filter::placeholder_count)
+    .define_method("fields", [](const Filter& f) {
+      Rice::Array arr;
+      for (const auto& name : f.fields()) arr.push(name);
+      return arr;
+    })
+    .define_method("bind_values", [](const Filter& f, Rice::Array values) {
+      std::vector<std::string> literals;
+      literals.reserve(values.size());
+      for (size_t i = 0; i < values.size(); i++) {
+        zvec::DataType type = i < f.slot_types().size() ? f.slot_types()[i] : zvec::DataType::UNDEFINED;
+        literals.push_back(filter_literal(values[i].value(), type, i));
+      }
+      return f.render(literals);
+    })
+    .define_method("to_s", &Filter::source);
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "zvec_common.hpp"
+
+namespace zvec_rb {
+
+// Lexical token of a filter expression. Offsets index into the source text so
+// compiled templates can be re-assembled without reformatting.
+struct FilterToken {
+  enum class Kind { IDENT, NUMBER, STRING, OP, LPAREN, RPAREN, COMMA, PLACEHOLDER, KEYWORD };
+  Kind kind;
+  std::string text;  // keywords are upper-cased, strings keep their quotes
+  size_t offset;
+  size_t length;
+};
+
+// Split a filter expression into tokens; raises std::invalid_argument on
+// unterminated strings, unknown characters and unbalanced parentheses
+std::vector<FilterToken> tokenize_filter(const std::string& text);
+
+// Schema-independent parse of a template: its tokens and, for each `?`, the
+// field it is compared against (empty when it cannot be determined)
+struct FilterPlan {
+  std::string source;
+  std::vector<FilterToken> tokens;
+  std::vector<size_t> placeholder_offsets;
+  std::vector<std::string> placeholder_fields;
+  std::vector<std::string> fields;
+};
+
+// Parsed plans are cached per template, keeping the most recently used
+constexpr size_t kFilterPlanCacheLimit = 1024;
+std::shared_ptr<const FilterPlan> filter_plan(const std::string& source);
+size_t filter_plan_cache_size();
+void clear_filter_plan_cache();
+
+// A template validated against a schema, with one typed slot per `?`
+class Filter {
+ public:
+  Filter(std::shared_ptr<const FilterPlan> plan, const zvec::CollectionSchema* schema);
+
+  const std::string& source() const { return plan_->source; }
+  size_t placeholder_count() const { return plan_->placeholder_offsets.size(); }
+  const std::vector<std::string>& fields() const { return plan_->fields; }
+  const std::vector<zvec::DataType>& slot_types() const { return slot_types_; }
+
+  // Render the expression with values substituted; values must already be
+  // formatted literals (see bind in zvec_filter.cpp)
+  std::string render(const std::vector<std::string>& literals) const;
+
+ private:
+  std::shared_ptr<const FilterPlan> plan_;
+  // UNDEFINED when the slot's field is unknown; the Ruby value decides
+  std::vector<zvec::DataType> slot_types_;
+};
+
+}  // namespace zvec_rb
@@ -0,0 +1,83 @@
+#include "zvec_group_results.hpp"
+
+using namespace Rice;
+
+namespace zvec_rb {
+
+size_t GroupResults::doc_count() const {
+  size_t n = 0;
+  for (const auto& g : *results_) n += g.docs_.size();
+  return n;
+}
+
+const zvec::Doc& GroupView::doc_at(size_t i) const {
+  if (i >= size()) throw std::out_of_range("doc index out of range");
+  return group().docs_[i];
+}
+
+zvec::Doc::Ptr GroupView::doc(size_t i) const {
+  if (i >= size()) throw std::out_of_range("doc index out of range");
+  return zvec::Doc::Ptr(results_, &group().docs_[i]);
+}
+
+}  // namespace zvec_rb
+
+using zvec_rb::GroupResults;
+using zvec_rb::GroupView;
+
+void init_zvec_group_results(Rice::Module& m) {
+  // GroupResult — a view of one group; pk/score reads never copy a Doc
+  Rice::define_class_under<GroupView>(m, "GroupResult")
+    .define_method("group_by_value", [](const GroupView& g) { return g.group_by_value(); })
+    .define_method("size", &GroupView::size)
+    .define_method("pk", [](const GroupView& g, size_t i) { return g.doc_at(i).pk(); })
+    .define_method("score", [](const GroupView& g, size_t i) { return g.doc_at(i).score(); })
+    .define_method("pks", [](const GroupView& g) {
+      Rice::Array arr;
+      for (size_t i = 0; i < g.size(); i++) arr.push(g.doc_at(i).pk());
+      return arr;
+    })
+    .define_method("scores", [](const GroupView& g) {
+      Rice::Array arr;
+      for (size_t i = 0; i < g.size(); i++) arr.push(g.doc_at(i).score());
+      return arr;
+    })
+    .define_method("doc", &GroupView::doc)
+    .define_method("docs", [](const GroupView& g) {
+      Rice::Array arr;
+      for (size_t i = 0; i < g.size(); i++) arr.push(g.doc(i));
+      return arr;
+    });
+
+  // GroupResults — the whole group-by result, shared by every view into it
+  Rice::define_class_under<GroupResults>(m, "GroupResults")
+    .define_method("size", &GroupResults::size)
+    .define_method("doc_count", &GroupResults::doc_count)
+    .define_method("[]", [](const GroupResults& r, size_t i) {
+      if (i >= r.size()) throw std::out_of_range("group index out of range");
+      return GroupView(r.storage(), i);
+    })
+    // Flat columns for every doc in group order:
+    // [group indices (packed uint32), pks (Array), scores (packed float32)]
+    .define_method("packed", [](const GroupResults& r) {
+      size_t n = r.doc_count();
+      std::vector<uint32_t> groups;
+      std::vector<float> scores;
+      groups.reserve(n);
+      scores.reserve(n);
+      Rice::Array pks;
+      const auto& results = *r.storage();
+      for (size_t g = 0; g < results.size(); g++) {
+        for (const auto& doc : results[g].docs_) {
+          groups.push_back(static_cast<uint32_t>(g));
+          scores.push_back(doc.score());
+          pks.push(doc.pk());
+        }
+      }
+      Rice::Array out;
+      out.push(Rice::Object(rb_str_new(reinterpret_cast<const char*>(groups.data()), n * sizeof(uint32_t))));
+      out.push(pks);
+      out.push(Rice::Object(rb_str_new(reinterpret_cast<const char*>(scores.data()), n * sizeof(float))));
+      return out;
+    });
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "zvec_common.hpp"
+
+namespace zvec_rb {
+
+// Owns the engine's group-by result so groups and docs can be handed to Ruby
+// as views instead of copies. Docs are exposed through aliasing shared_ptrs
+// that keep the whole result alive; fields decode only when read.
+class GroupResults {
+ public:
+  using Storage = std::shared_ptr<zvec::GroupResults>;
+
+  explicit GroupResults(zvec::GroupResults&& results)
+      : results_(std::make_shared<zvec::GroupResults>(std::move(results))) {}
+
+  size_t size() const { return results_->size(); }
+  size_t doc_count() const;
+  const Storage& storage() const { return results_; }
+
+ private:
+  Storage results_;
+};
+
+// One group within a GroupResults (bound as Zvec::GroupResult)
+class GroupView {
+ public:
+  GroupView(GroupResults::Storage results, size_t index)
+      : results_(std::move(results)), index_(index) {}
+
+  const std::string& group_by_value() const { return group().group_by_value_; }
+  size_t size() const { return group().docs_.size(); }
+  const zvec::Doc& doc_at(size_t i) const;
+  zvec::Doc::Ptr doc(size_t i) const;
+
+ private:
+  zvec::GroupResult& group() const { return (*results_)[index_]; }
+
+  GroupResults::Storage results_;
+  size_t index_;
+};
+
+}  // namespace zvec_rb
@@ -0,0 +1,93 @@
+#include "zvec_instrument.hpp"
+
+#include <algorithm>
+
+using namespace Rice;
+
+namespace zvec_rb {
+
+std::atomic<bool> g_instrumentation_enabled{false};
+
+// Subscribers attached across all Ractors
+static std::atomic<int64_t> g_subscribers{0};
+static std::atomic<uint64_t> g_next_event_id{1};
+static VALUE g_instrumentation_module = Qnil;
+
+static VALUE sym(const char* name) { return rb_id2sym(rb_intern(name)); }
+
+// A subscriber's exception is thrown as Rice::JumpException, so it unwinds
+// C++ frames normally and is re-raised once it leaves the method
+static void dispatch(const char* phase, VALUE name, uint64_t id, VALUE payload) {
+  VALUE args[] = {sym(phase), name, ULL2NUM(id), payload};
+  Rice::detail::protect(rb_funcallv, g_instrumentation_module, rb_intern("dispatch"), 4, args);
+}
+
+void OpScope::start(const char* operation, const zvec::Collection& collection, const OpInfo& info) {
+  start_ = Clock::now();
+  id_ = g_next_event_id.fetch_add(1, std::memory_order_relaxed);
+  name_ = rb_sprintf("%s.zvec", operation);
+
+  auto path = collection.Path();
+  payload_ = rb_hash_new();
+  rb_hash_aset(payload_, sym("operation"), sym(operation));
+  rb_hash_aset(payload_, sym("path"), path.has_value()
+    ? rb_utf8_str_new(path.value().data(), static_cast<long>(path.value().size())) : Qnil);
+  rb_hash_aset(payload_, sym("doc_count"), SIZET2NUM(info.doc_count));
+  rb_hash_aset(payload_, sym("topk"), info.topk < 0 ? Qnil : LL2NUM(info.topk));
+  rb_hash_aset(payload_, sym("filter"), info.filter ? Qtrue : Qfalse);
+
+  dispatch("start", name_, id_, payload_);
+}
+
+void OpScope::dispatch_finish(const std::string& error) {
+  finished_ = true;
+  double total_ms = ms_since(start_);
+  rb_hash_aset(payload_, sym("engine_ms"), DBL2NUM(engine_ms_));
+  rb_hash_aset(payload_, sym("conversion_ms"), DBL2NUM(std::max(0.0, total_ms - engine_ms_)));
+  if (!error.empty()) {
+    rb_hash_aset(payload_, sym("error"), rb_utf8_str_new(error.data(), static_cast<long>(error.size())));
+  }
+  dispatch("finish", name_, id_, payload_);
+}
+
+void OpScope::fail(const char* message) {
+  if (finished_) return;
+  try {
+    dispatch_finish(message && *message ? message : "exception");
+  } catch (const Rice::JumpException&) {
+    rb_set_errinfo(Qnil);
+  }
+}
+
+void OpScope::finish(size_t result_size) {
+  if (!active_ || finished_) return;
+  rb_hash_aset(payload_, sym("result_size"), SIZET2NUM(result_size));
+  dispatch_finish("");
+}
+
+void OpScope::check(const zvec::Status& status) {
+  if (active_ && !finished_ && !status.ok()) {
+    std::string message = status.message();
+    dispatch_finish(message.empty() ? "error" : message);
+  }
+  throw_if_error(status);
+}
+
+}  // namespace zvec_rb
+
+void init_zvec_instrument(Rice::Module& m) {
+  Rice::Module rb_mInstrumentation = Rice::define_module_under(m, "Instrumentation");
+  zvec_rb::g_instrumentation_module = rb_mInstrumentation.value();
+
+  rb_mInstrumentation
+    // Called by Ruby subscribe/unsubscribe from any Ractor
+    .define_module_function("attach", []() {
+      zvec_rb::g_instrumentation_enabled = ++zvec_rb::g_subscribers > 0;
+    })
+    .define_module_function("detach", []() {
+      zvec_rb::g_instrumentation_enabled = --zvec_rb::g_subscribers > 0;
+    })
+    .define_module_function("enabled?", []() {
+      return zvec_rb::g_instrumentation_enabled.load();
+    });
+}
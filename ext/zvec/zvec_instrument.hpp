@@ -0,0 +1,88 @@
+#pragma once
+
+#include "zvec_common.hpp"
+
+#include <chrono>
+
+namespace zvec_rb {
+
+// Set while any Ruby subscriber is attached (Zvec::Instrumentation.attach)
+extern std::atomic<bool> g_instrumentation_enabled;
+
+// What an operation is asked to do, reported in its start event
+struct OpInfo {
+  size_t doc_count = 0;
+  int64_t topk = -1;  // -1 when the operation has no topk
+  bool filter = false;
+};
+
+// Instrumentation for one Collection method call. Construction costs a single
+// atomic load when nothing is subscribed; otherwise it dispatches a start
+// event to Zvec::Instrumentation, and finish/check dispatch the finish event
+// with engine vs conversion time. Events are only dispatched with the GVL
+// held, and a subscriber's exception surfaces as Rice::JumpException. The
+// destructor never calls into Ruby, so an exception thrown outside engine()
+// and check() leaves the start event without a finish.
+class OpScope {
+ public:
+  OpScope(const char* operation, const zvec::Collection& collection, const OpInfo& info = {})
+    : active_(g_instrumentation_enabled.load(std::memory_order_relaxed)) {
+    if (active_) start(operation, collection, info);
+  }
+  ~OpScope() = default;
+
+  OpScope(const OpScope&) = delete;
+  OpScope& operator=(const OpScope&) = delete;
+
+  // Time an engine call (which may release the GVL itself)
+  template <typename F>
+  void engine(F&& fn) {
+    if (!active_) {
+      fn();
+      return;
+    }
+    auto t0 = Clock::now();
+    try {
+      fn();
+    } catch (const std::exception& e) {
+      engine_ms_ += ms_since(t0);
+      fail(e.what());
+      throw;
+    } catch (...) {
+      engine_ms_ += ms_since(t0);
+      fail("exception");
+      throw;
+    }
+    engine_ms_ += ms_since(t0);
+  }
+
+  // Raise for a non-OK status, finishing the event with the error first
+  void check(const zvec::Status& status);
+
+  template <typename T>
+  T unwrap(tl::expected<T, zvec::Status>&& result) {
+    if (!result.has_value()) check(result.error());
+    return std::move(result.value());
+  }
+
+  void finish(size_t result_size);
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  void start(const char* operation, const zvec::Collection& collection, const OpInfo& info);
+  void dispatch_finish(const std::string& error);
+  // Finish event for an exception about to be rethrown; subscriber errors
+  // are dropped so they cannot replace it
+  void fail(const char* message);
+
+  bool active_;
+  bool finished_ = false;
+  VALUE name_ = Qnil;
+  VALUE payload_ = Qnil;
+  uint64_t id_ = 0;
+  Clock::time_point start_;
+  double engine_ms_ = 0;
+};
+
+}  // namespace zvec_rb
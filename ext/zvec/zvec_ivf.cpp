@@ -0,0 +1,257 @@
+#include "zvec_ivf.hpp"
+#include "zvec_brute_force.hpp"
+#include "zvec_kernels.hpp"
+#include "zvec_pool.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <random>
+
+using namespace Rice;
+
+namespace zvec_rb {
+
+// Vectors per work item and centroids per dot_tile call
+static const size_t kBlockVectors = 32;
+static const size_t kTileCentroids = 128;
+
+static zvec::MetricType assign_metric(zvec::MetricType metric) {
+  if (metric == zvec::MetricType::UNDEFINED) return zvec::MetricType::L2;
+  if (metric == zvec::MetricType::MIPSL2) return zvec::MetricType::IP;
+  return metric;
+}
+
+void IvfPartitioner::set_centroids(std::vector<float> centroids) {
+  centroids_ = std::move(centroids);
+  n_list_ = static_cast<uint32_t>(centroids_.size() / dim_);
+  norms_.assign(n_list_, 0.0f);
+  for (uint32_t c = 0; c < n_list_; c++) {
+    float* row = centroids_.data() + static_cast<size_t>(c) * dim_;
+    if (metric_ == zvec::MetricType::COSINE) kernels::normalize(row, dim_);
+    norms_[c] = kernels::dot(row, row, dim_);
+  }
+}
+
+IvfPartitioner* IvfPartitioner::from_centroids(std::vector<float> centroids, uint32_t dim,
+                                               zvec::MetricType metric) {
+  if (dim == 0 || centroids.empty() || centroids.size() % dim != 0)
+    throw std::invalid_argument("centroids must be a non-empty multiple of dimension floats");
+  auto* p = new IvfPartitioner(dim, assign_metric(metric));
+  p->set_centroids(std::move(centroids));
+  return p;
+}
+
+std::vector<uint32_t> IvfPartitioner::assign(const float* vectors, size_t n, size_t nprobe,
+                                             size_t concurrency) const {
+  nprobe = std::min<size_t>(std::max<size_t>(nprobe, 1), n_list_);
+  std::vector<uint32_t> out(n * nprobe);
+  if (n == 0) return out;
+
+  size_t blocks = (n + kBlockVectors - 1) / kBlockVectors;
+  size_t threads = std::min(thread_count(concurrency), blocks);
+
+  // Per vector, the nprobe smallest keys kept sorted by insertion; nprobe is
+  // small, so this beats a heap. Keys: squared L2 minus the vector's own
+  // norm, or the negated inner product.
+  struct Scratch {
+    std::vector<float> block, scores, best_key;
+    std::vector<uint32_t> best;
+  };
+  std::vector<Scratch> scratch(threads);
+  parallel_for(blocks, threads, [&](size_t w, size_t b) {
+    Scratch& sc = scratch[w];
+    if (sc.block.empty()) {
+      sc.block.resize(kBlockVectors * dim_);
+      sc.scores.resize(kBlockVectors * kTileCentroids);
+      sc.best_key.resize(kBlockVectors * nprobe);
+      sc.best.resize(kBlockVectors * nprobe);
+    }
+    size_t v0 = b * kBlockVectors;
+    size_t bn = std::min(kBlockVectors, n - v0);
+    std::memcpy(sc.block.data(), vectors + v0 * dim_, bn * dim_ * sizeof(float));
+    if (metric_ == zvec::MetricType::COSINE) {
+      for (size_t i = 0; i < bn; i++) kernels::normalize(sc.block.data() + i * dim_, dim_);
+    }
+    std::fill(sc.best_key.begin(), sc.best_key.end(), INFINITY);
+    std::fill(sc.best.begin(), sc.best.end(), 0);
+
+    for (size_t c0 = 0; c0 < n_list_; c0 += kTileCentroids) {
+      size_t nc = std::min<size_t>(kTileCentroids, n_list_ - c0);
+      kernels::dot_tile(sc.block.data(), bn, centroids_.data() + c0 * dim_, nc, dim_, sc.scores.data());
+      for (size_t i = 0; i < bn; i++) {
+        const float* s = sc.scores.data() + i * nc;
+        float* keys = sc.best_key.data() + i * nprobe;
+        uint32_t* ids = sc.best.data() + i * nprobe;
+        for (size_t j = 0; j < nc; j++) {
+          float key = metric_ == zvec::MetricType::L2 ? norms_[c0 + j] - 2.0f * s[j] : -s[j];
+          if (key >= keys[nprobe - 1]) continue;
+          size_t r = nprobe - 1;
+          while (r > 0 && keys[r - 1] > key) {
+            keys[r] = keys[r - 1];
+            ids[r] = ids[r - 1];
+            r--;
+          }
+          keys[r] = key;
+          ids[r] = static_cast<uint32_t>(c0 + j);
+        }
+      }
+    }
+    std::memcpy(out.data() + v0 * nprobe, sc.best.data(), bn * nprobe * sizeof(uint32_t));
+  });
+  return out;
+}
+
+zvec::Status IvfPartitioner::train(const zvec::Collection& collection, const zvec::FieldSchema& field,
+                                   zvec::MetricType metric, const std::string& filter, uint32_t batch_size,
+                                   const Options& options, std::unique_ptr<IvfPartitioner>& out) {
+  if (options.n_list == 0) throw std::invalid_argument("n_list must be positive");
+  const uint32_t dim = field.dimension();
+  std::unique_ptr<IvfPartitioner> p(new IvfPartitioner(dim, assign_metric(metric)));
+
+  std::vector<float> data;
+  zvec::Status status = load_field_vectors(collection, field, filter, batch_size, data, p->pks_);
+  if (!status.ok()) return status;
+  size_t n = p->pks_.size();
+  if (n < options.n_list) {
+    return zvec::Status::InvalidArgument("need at least n_list (" + std::to_string(options.n_list) +
+                                         ") vectors, found " + std::to_string(n));
+  }
+  if (p->metric_ == zvec::MetricType::COSINE) {
+    for (size_t r = 0; r < n; r++) kernels::normalize(data.data() + r * dim, dim);
+  }
+
+  // Training sample: a random subset once the field is larger than the cap
+  std::mt19937_64 rng(options.seed);
+  std::vector<size_t> order(n);
+  std::iota(order.begin(), order.end(), 0);
+  size_t cap = static_cast<size_t>(std::max(options.sample_per_list, 1u)) * options.n_list;
+  size_t ns = std::min(n, std::max<size_t>(cap, options.n_list));
+  for (size_t i = 0; i < ns; i++) std::swap(order[i], order[i + rng() % (n - i)]);
+  std::vector<float> sample(ns * dim);
+  for (size_t i = 0; i < ns; i++) std::memcpy(sample.data() + i * dim, data.data() + order[i] * dim, dim * sizeof(float));
+
+  // Start from the first n_list sampled vectors (already a random pick)
+  p->set_centroids(std::vector<float>(sample.begin(), sample.begin() + static_cast<size_t>(options.n_list) * dim));
+
+  std::vector<double> sums(static_cast<size_t>(options.n_list) * dim);
+  std::vector<uint64_t> counts(options.n_list);
+  for (uint32_t iter = 0; iter < options.n_iters; iter++) {
+    std::vector<uint32_t> labels = p->assign(sample.data(), ns, 1, options.concurrency);
+    std::fill(sums.begin(), sums.end(), 0.0);
+    std::fill(counts.begin(), counts.end(), 0);
+    for (size_t i = 0; i < ns; i++) {
+      double* sum = sums.data() + static_cast<size_t>(labels[i]) * dim;
+      const float* v = sample.data() + i * dim;
+      for (uint32_t k = 0; k < dim; k++) sum[k] += v[k];
+      counts[labels[i]]++;
+    }
+
+    std::vector<float> next(sums.size());
+    for (uint32_t c = 0; c < options.n_list; c++) {
+      if (counts[c] == 0) continue;
+      for (uint32_t k = 0; k < dim; k++) next[c * dim + k] = static_cast<float>(sums[c * dim + k] / counts[c]);
+    }
+    // An empty list takes half of the largest one: copy its centroid and
+    // nudge the two apart so the next assignment splits the members
+    for (uint32_t c = 0; c < options.n_list; c++) {
+      if (counts[c] != 0) continue;
+      uint32_t big = static_cast<uint32_t>(std::max_element(counts.begin(), counts.end()) - counts.begin());
+      for (uint32_t k = 0; k < dim; k++) {
+        float v = next[big * dim + k];
+        float eps = (k % 2 ? 1.0f : -1.0f) * 1e-4f * (std::fabs(v) + 1e-6f);
+        next[c * dim + k] = v + eps;
+        next[big * dim + k] = v - eps;
+      }
+      counts[c] = counts[big] / 2;
+      counts[big] -= counts[c];
+    }
+    p->set_centroids(std::move(next));
+    p->iterations_ = iter + 1;
+  }
+
+  p->lists_ = p->assign(data.data(), n, 1, options.concurrency);
+  p->list_sizes_.assign(p->n_list_, 0);
+  for (uint32_t l : p->lists_) p->list_sizes_[l]++;
+  out = std::move(p);
+  return zvec::Status();
+}
+
+double IvfPartitioner::imbalance() const {
+  if (list_sizes_.empty() || pks_.empty()) return 0.0;
+  uint64_t largest = *std::max_element(list_sizes_.begin(), list_sizes_.end());
+  return static_cast<double>(largest) * n_list_ / static_cast<double>(pks_.size());
+}
+
+}  // namespace zvec_rb
+
+using zvec_rb::IvfPartitioner;
+
+void init_zvec_ivf(Rice::Module& m) {
+  Rice::define_class_under<IvfPartitioner>(m, "IvfPartitioner")
+    // Saved centroids (packed float32 String or Array of Arrays); the
+    // result assigns and routes but has no loaded docs
+    .define_singleton_function("from_centroids", [](Rice::Object centroids, uint32_t dim,
+                                                    zvec::MetricType metric) {
+      size_t rows = 0;
+      return IvfPartitioner::from_centroids(zvec_rb::float_matrix(centroids, dim, rows), dim, metric);
+    },
+      Rice::Return().takeOwnership(),
+      Rice::Arg("centroids"),
+      Rice::Arg("dimension"),
+      Rice::Arg("metric") = zvec::MetricType::L2)
+    .define_method("n_list", &IvfPartitioner::n_list)
+    .define_method("dimension", &IvfPartitioner::dimension)
+    .define_method("metric", &IvfPartitioner::metric)
+    .define_method("iterations", &IvfPartitioner::iterations)
+    .define_method("size", [](const IvfPartitioner& p) { return p.pks().size(); })
+    .define_method("imbalance", &IvfPartitioner::imbalance)
+    // n_list x dimension float32, row-major
+    .define_method("centroids", [](const IvfPartitioner& p) {
+      const auto& c = p.centroids();
+      return Rice::String(std::string(reinterpret_cast<const char*>(c.data()), c.size() * sizeof(float)));
+    })
+    .define_method("list_sizes", [](const IvfPartitioner& p) {
+      Rice::Array arr;
+      for (uint64_t s : p.list_sizes()) arr.push(s);
+      return arr;
+    })
+    // pk => list for every loaded doc
+    .define_method("assignments", [](const IvfPartitioner& p) {
+      Rice::Hash h;
+      for (size_t i = 0; i < p.pks().size(); i++) h[p.pks()[i]] = p.lists()[i];
+      return h;
+    })
+    // Nearest list of each vector
+    .define_method("assign", [](const IvfPartitioner& p, Rice::Object vectors, uint32_t concurrency) {
+      size_t n = 0;
+      std::vector<float> v = zvec_rb::float_matrix(vectors, p.dimension(), n);
+      std::vector<uint32_t> lists;
+      zvec_rb::without_gvl([&] { lists = p.assign(v.data(), n, 1, concurrency); });
+      Rice::Array out;
+      for (uint32_t l : lists) out.push(l);
+      return out;
+    },
+      Rice::Arg("vectors"),
+      Rice::Arg("concurrency") = (uint32_t)0)
+    // The nprobe nearest lists of each query, nearest first
+    .define_method("route", [](const IvfPartitioner& p, Rice::Object queries, uint32_t nprobe,
+                               uint32_t concurrency) {
+      size_t n = 0;
+      std::vector<float> v = zvec_rb::float_matrix(queries, p.dimension(), n);
+      std::vector<uint32_t> lists;
+      zvec_rb::without_gvl([&] { lists = p.assign(v.data(), n, nprobe, concurrency); });
+      size_t width = n ? lists.size() / n : 0;
+      Rice::Array out;
+      for (size_t i = 0; i < n; i++) {
+        Rice::Array row;
+        for (size_t r = 0; r < width; r++) row.push(lists[i * width + r]);
+        out.push(row);
+      }
+      return out;
+    },
+      Rice::Arg("queries"),
+      Rice::Arg("nprobe") = (uint32_t)1,
+      Rice::Arg("concurrency") = (uint32_t)0);
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "zvec_common.hpp"
+
+namespace zvec_rb {
+
+// Coarse IVF lists for one dense vector field: n_list centroids trained by
+// k-means, plus the list each loaded vector falls in. The engine keeps its
+// trained IVF centroids private. This trains on the same field with the
+// same parameters (n_list, n_iters, metric), so the lists follow the same
+// data but are not the engine's own lists. Assignment scores vector blocks
+// against centroid tiles with the dot_tile kernel on native threads.
+class IvfPartitioner {
+ public:
+  struct Options {
+    uint32_t n_list = 0;
+    uint32_t n_iters = 10;
+    uint32_t sample_per_list = 256;  // training sample cap, per list
+    uint64_t seed = 42;
+    uint32_t concurrency = 0;        // 0 = all cores
+  };
+
+  // Load the field (as brute_force_index does), train and assign every
+  // loaded vector. No Ruby calls, so it may run without the GVL.
+  static zvec::Status train(const zvec::Collection& collection, const zvec::FieldSchema& field,
+                            zvec::MetricType metric, const std::string& filter, uint32_t batch_size,
+                            const Options& options, std::unique_ptr<IvfPartitioner>& out);
+  // Rebuild from saved centroids (n_list x dim float32, see centroids())
+  static IvfPartitioner* from_centroids(std::vector<float> centroids, uint32_t dim, zvec::MetricType metric);
+
+  // The nprobe nearest lists of each vector, nearest first (n x nprobe)
+  std::vector<uint32_t> assign(const float* vectors, size_t n, size_t nprobe, size_t concurrency) const;
+
+  uint32_t n_list() const { return n_list_; }
+  uint32_t dimension() const { return dim_; }
+  zvec::MetricType metric() const { return metric_; }
+  uint32_t iterations() const { return iterations_; }
+  // Unit length for COSINE
+  const std::vector<float>& centroids() const { return centroids_; }
+
+  // Loaded vectors: pk and list of each, and docs per list
+  const std::vector<std::string>& pks() const { return pks_; }
+  const std::vector<uint32_t>& lists() const { return lists_; }
+  const std::vector<uint64_t>& list_sizes() const { return list_sizes_; }
+  // Largest list over the mean list size (1.0 = perfectly balanced)
+  double imbalance() const;
+
+ private:
+  IvfPartitioner(uint32_t dim, zvec::MetricType metric) : dim_(dim), metric_(metric) {}
+
+  void set_centroids(std::vector<float> centroids);
+
+  uint32_t n_list_ = 0;
+  uint32_t dim_;
+  zvec::MetricType metric_;
+  uint32_t iterations_ = 0;
+  std::vector<float> centroids_;
+  std::vector<float> norms_;  // squared centroid norms, for L2
+  std::vector<std::string> pks_;
+  std::vector<uint32_t> lists_;
+  std::vector<uint64_t> list_sizes_;
+};
+
+}  // namespace zvec_rb
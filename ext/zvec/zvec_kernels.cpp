@@ -0,0 +1,509 @@
+#include "zvec_kernels.hpp"
+
+#include <cmath>
+#include <cstring>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define ZVEC_KERNELS_X86 1
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#define ZVEC_KERNELS_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace zvec_rb {
+namespace kernels {
+
+static inline uint32_t f32_bits(float f) {
+  uint32_t u;
+  std::memcpy(&u, &f, sizeof(u));
+  return u;
+}
+
+static inline float f32_from_bits(uint32_t u) {
+  float f;
+  std::memcpy(&f, &u, sizeof(f));
+  return f;
+}
+
+// --- Scalar reference ---
+// Branch-light conversions that match the hardware instructions bit for bit
+// on finite values and infinities; NaNs become the canonical quiet NaN.
+
+static inline uint16_t f32_to_f16_one(float f) {
+  const float scale_to_inf = 0x1.0p+112f;
+  const float scale_to_zero = 0x1.0p-110f;
+  float base = (std::abs(f) * scale_to_inf) * scale_to_zero;
+
+  const uint32_t w = f32_bits(f);
+  const uint32_t shl1_w = w + w;
+  const uint32_t sign = w & 0x80000000u;
+  uint32_t bias = shl1_w & 0xFF000000u;
+  if (bias < 0x71000000u) bias = 0x71000000u;
+
+  base = f32_from_bits((bias >> 1) + 0x07800000u) + base;
+  const uint32_t bits = f32_bits(base);
+  const uint32_t exp_bits = (bits >> 13) & 0x00007C00u;
+  const uint32_t mantissa_bits = bits & 0x00000FFFu;
+  const uint32_t nonsign = exp_bits + mantissa_bits;
+  return static_cast<uint16_t>((sign >> 16) | (shl1_w > 0xFF000000u ? 0x7E00u : nonsign));
+}
+
+static inline float f16_to_f32_one(uint16_t h) {
+  const uint32_t w = static_cast<uint32_t>(h) << 16;
+  const uint32_t sign = w & 0x80000000u;
+  const uint32_t two_w = w + w;
+
+  const float normalized = f32_from_bits((two_w >> 4) + (0xE0u << 23)) * 0x1.0p-112f;
+  const float denormalized = f32_from_bits((two_w >> 17) | (126u << 23)) - 0.5f;
+
+  const uint32_t result =
+    sign | (two_w < (1u << 27) ? f32_bits(denormalized) : f32_bits(normalized));
+  return f32_from_bits(result);
+}
+
+namespace scalar {
+
+void f32_to_f16(const float* src, uint16_t* dst, size_t n) {
+  for (size_t i = 0; i < n; i++) dst[i] = f32_to_f16_one(src[i]);
+}
+
+void f16_to_f32(const uint16_t* src, float* dst, size_t n) {
+  for (size_t i = 0; i < n; i++) dst[i] = f16_to_f32_one(src[i]);
+}
+
+void pack_int4(const int8_t* src, uint8_t* dst, size_t n) {
+  size_t i = 0;
+  for (; i + 1 < n; i += 2) {
+    dst[i / 2] = static_cast<uint8_t>((src[i] & 0x0F) | ((src[i + 1] & 0x0F) << 4));
+  }
+  if (i < n) dst[i / 2] = static_cast<uint8_t>(src[i] & 0x0F);
+}
+
+void unpack_int4(const uint8_t* src, int8_t* dst, size_t n) {
+  size_t i = 0;
+  for (; i + 1 < n; i += 2) {
+    int8_t b = static_cast<int8_t>(src[i / 2]);
+    dst[i] = static_cast<int8_t>(static_cast<int8_t>(b << 4) >> 4);
+    dst[i + 1] = static_cast<int8_t>(b >> 4);
+  }
+  if (i < n) {
+    int8_t b = static_cast<int8_t>(src[i / 2]);
+    dst[i] = static_cast<int8_t>(static_cast<int8_t>(b << 4) >> 4);
+  }
+}
+
+float dot(const float* a, const float* b, size_t n) {
+  float sum = 0.0f;
+  for (size_t i = 0; i < n; i++) sum += a[i] * b[i];
+  return sum;
+}
+
+float l2_sqr(const float* a, const float* b, size_t n) {
+  float sum = 0.0f;
+  for (size_t i = 0; i < n; i++) {
+    float d = a[i] - b[i];
+    sum += d * d;
+  }
+  return sum;
+}
+
+void dot_tile(const float* q, size_t nq, const float* x, size_t nx, size_t dim, float* out) {
+  for (size_t i = 0; i < nq; i++) {
+    for (size_t j = 0; j < nx; j++) out[i * nx + j] = dot(q + i * dim, x + j * dim, dim);
+  }
+}
+
+}  // namespace scalar
+
+// --- x86: F16C/AVX2 and AVX-512 ---
+
+#if defined(ZVEC_KERNELS_X86)
+
+__attribute__((target("avx,f16c")))
+static void f32_to_f16_f16c(const float* src, uint16_t* dst, size_t n) {
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m128i h = _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), h);
+  }
+  scalar::f32_to_f16(src + i, dst + i, n - i);
+}
+
+__attribute__((target("avx,f16c")))
+static void f16_to_f32_f16c(const uint16_t* src, float* dst, size_t n) {
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(h));
+  }
+  scalar::f16_to_f32(src + i, dst + i, n - i);
+}
+
+__attribute__((target("avx512f")))
+static void f32_to_f16_avx512(const float* src, uint16_t* dst, size_t n) {
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m256i h = _mm512_cvtps_ph(_mm512_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), h);
+  }
+  f32_to_f16_f16c(src + i, dst + i, n - i);
+}
+
+__attribute__((target("avx512f")))
+static void f16_to_f32_avx512(const uint16_t* src, float* dst, size_t n) {
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m256i h = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+    _mm512_storeu_ps(dst + i, _mm512_cvtph_ps(h));
+  }
+  f16_to_f32_f16c(src + i, dst + i, n - i);
+}
+
+// Each 16-bit lane holds two source bytes (b0 | b1 << 8); fold them into one
+// byte (b0 & 0xF) | (b1 << 4), then narrow and undo packus' lane interleave.
+__attribute__((target("avx2")))
+static void pack_int4_avx2(const int8_t* src, uint8_t* dst, size_t n) {
+  const __m256i lo_mask = _mm256_set1_epi16(0x000F);
+  const __m256i hi_mask = _mm256_set1_epi16(0x00F0);
+  size_t i = 0;
+  for (; i + 64 <= n; i += 64) {
+    __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+    __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i + 32));
+    __m256i fa = _mm256_or_si256(_mm256_and_si256(a, lo_mask),
+                                 _mm256_and_si256(_mm256_srli_epi16(a, 4), hi_mask));
+    __m256i fb = _mm256_or_si256(_mm256_and_si256(b, lo_mask),
+                                 _mm256_and_si256(_mm256_srli_epi16(b, 4), hi_mask));
+    __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(fa, fb), 0xD8);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i / 2), packed);
+  }
+  scalar::pack_int4(src + i, dst + i / 2, n - i);
+}
+
+// Sign-extend each packed byte to 16 bits, extract both signed nibbles with
+// arithmetic shifts, and re-interleave them as (lo, hi) byte pairs.
+__attribute__((target("avx2")))
+static void unpack_int4_avx2(const uint8_t* src, int8_t* dst, size_t n) {
+  const __m256i byte_mask = _mm256_set1_epi16(0x00FF);
+  size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i / 2));
+    __m256i x = _mm256_cvtepi8_epi16(p);
+    __m256i lo = _mm256_srai_epi16(_mm256_slli_epi16(x, 12), 12);
+    __m256i hi = _mm256_srai_epi16(_mm256_slli_epi16(x, 8), 12);
+    __m256i out = _mm256_or_si256(_mm256_and_si256(lo, byte_mask), _mm256_slli_epi16(hi, 8));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), out);
+  }
+  scalar::unpack_int4(src + i / 2, dst + i, n - i);
+}
+
+// Two independent accumulators hide FMA latency on the reduction
+__attribute__((target("avx2,fma")))
+static float dot_avx2(const float* a, const float* b, size_t n) {
+  __m256 acc0 = _mm256_setzero_ps();
+  __m256 acc1 = _mm256_setzero_ps();
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc0);
+    acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8), acc1);
+  }
+  __m256 acc = _mm256_add_ps(acc0, acc1);
+  __m128 s = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+  s = _mm_hadd_ps(s, s);
+  s = _mm_hadd_ps(s, s);
+  return _mm_cvtss_f32(s) + scalar::dot(a + i, b + i, n - i);
+}
+
+__attribute__((target("avx2,fma")))
+static float l2_sqr_avx2(const float* a, const float* b, size_t n) {
+  __m256 acc0 = _mm256_setzero_ps();
+  __m256 acc1 = _mm256_setzero_ps();
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m256 d0 = _mm256_sub_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i));
+    __m256 d1 = _mm256_sub_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8));
+    acc0 = _mm256_fmadd_ps(d0, d0, acc0);
+    acc1 = _mm256_fmadd_ps(d1, d1, acc1);
+  }
+  __m256 acc = _mm256_add_ps(acc0, acc1);
+  __m128 s = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+  s = _mm_hadd_ps(s, s);
+  s = _mm_hadd_ps(s, s);
+  return _mm_cvtss_f32(s) + scalar::l2_sqr(a + i, b + i, n - i);
+}
+
+__attribute__((target("avx2,fma")))
+static inline float hsum_avx2(__m256 v) {
+  __m128 s = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+  s = _mm_hadd_ps(s, s);
+  s = _mm_hadd_ps(s, s);
+  return _mm_cvtss_f32(s);
+}
+
+// 4 queries x 2 vectors per step: 8 accumulators, and 6 loads feed 8 FMAs
+// instead of the 16 loads of eight separate dot products
+__attribute__((target("avx2,fma")))
+static void dot_tile_avx2(const float* q, size_t nq, const float* x, size_t nx, size_t dim, float* out) {
+  size_t body = dim & ~static_cast<size_t>(7);
+  size_t i = 0;
+  for (; i + 4 <= nq; i += 4) {
+    const float* q0 = q + i * dim;
+    const float* q1 = q0 + dim;
+    const float* q2 = q1 + dim;
+    const float* q3 = q2 + dim;
+    size_t j = 0;
+    for (; j + 2 <= nx; j += 2) {
+      const float* x0 = x + j * dim;
+      const float* x1 = x0 + dim;
+      __m256 a00 = _mm256_setzero_ps(), a01 = _mm256_setzero_ps();
+      __m256 a10 = _mm256_setzero_ps(), a11 = _mm256_setzero_ps();
+      __m256 a20 = _mm256_setzero_ps(), a21 = _mm256_setzero_ps();
+      __m256 a30 = _mm256_setzero_ps(), a31 = _mm256_setzero_ps();
+      for (size_t k = 0; k < body; k += 8) {
+        __m256 v0 = _mm256_loadu_ps(x0 + k);
+        __m256 v1 = _mm256_loadu_ps(x1 + k);
+        __m256 u = _mm256_loadu_ps(q0 + k);
+        a00 = _mm256_fmadd_ps(u, v0, a00);
+        a01 = _mm256_fmadd_ps(u, v1, a01);
+        u = _mm256_loadu_ps(q1 + k);
+        a10 = _mm256_fmadd_ps(u, v0, a10);
+        a11 = _mm256_fmadd_ps(u, v1, a11);
+        u = _mm256_loadu_ps(q2 + k);
+        a20 = _mm256_fmadd_ps(u, v0, a20);
+        a21 = _mm256_fmadd_ps(u, v1, a21);
+        u = _mm256_loadu_ps(q3 + k);
+        a30 = _mm256_fmadd_ps(u, v0, a30);
+        a31 = _mm256_fmadd_ps(u, v1, a31);
+      }
+      size_t tail = dim - body;
+      float* o = out + i * nx + j;
+      o[0] = hsum_avx2(a00) + scalar::dot(q0 + body, x0 + body, tail);
+      o[1] = hsum_avx2(a01) + scalar::dot(q0 + body, x1 + body, tail);
+      o[nx] = hsum_avx2(a10) + scalar::dot(q1 + body, x0 + body, tail);
+      o[nx + 1] = hsum_avx2(a11) + scalar::dot(q1 + body, x1 + body, tail);
+      o[2 * nx] = hsum_avx2(a20) + scalar::dot(q2 + body, x0 + body, tail);
+      o[2 * nx + 1] = hsum_avx2(a21) + scalar::dot(q2 + body, x1 + body, tail);
+      o[3 * nx] = hsum_avx2(a30) + scalar::dot(q3 + body, x0 + body, tail);
+      o[3 * nx + 1] = hsum_avx2(a31) + scalar::dot(q3 + body, x1 + body, tail);
+    }
+    for (; j < nx; j++) {
+      for (size_t r = 0; r < 4; r++) out[(i + r) * nx + j] = dot_avx2(q + (i + r) * dim, x + j * dim, dim);
+    }
+  }
+  for (; i < nq; i++) {
+    for (size_t j = 0; j < nx; j++) out[i * nx + j] = dot_avx2(q + i * dim, x + j * dim, dim);
+  }
+}
+
+__attribute__((target("avx512f")))
+static float dot_avx512(const float* a, const float* b, size_t n) {
+  __m512 acc = _mm512_setzero_ps();
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    acc = _mm512_fmadd_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i), acc);
+  }
+  if (i < n) {
+    __mmask16 m = static_cast<__mmask16>((1u << (n - i)) - 1);
+    acc = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(m, a + i), _mm512_maskz_loadu_ps(m, b + i), acc);
+  }
+  return _mm512_reduce_add_ps(acc);
+}
+
+__attribute__((target("avx512f")))
+static float l2_sqr_avx512(const float* a, const float* b, size_t n) {
+  __m512 acc = _mm512_setzero_ps();
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m512 d = _mm512_sub_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i));
+    acc = _mm512_fmadd_ps(d, d, acc);
+  }
+  if (i < n) {
+    __mmask16 m = static_cast<__mmask16>((1u << (n - i)) - 1);
+    __m512 d = _mm512_sub_ps(_mm512_maskz_loadu_ps(m, a + i), _mm512_maskz_loadu_ps(m, b + i));
+    acc = _mm512_fmadd_ps(d, d, acc);
+  }
+  return _mm512_reduce_add_ps(acc);
+}
+
+#endif  // ZVEC_KERNELS_X86
+
+// --- AArch64: NEON ---
+
+#if defined(ZVEC_KERNELS_NEON)
+
+static void f32_to_f16_neon(const float* src, uint16_t* dst, size_t n) {
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    float16x4_t h = vcvt_f16_f32(vld1q_f32(src + i));
+    vst1_u16(dst + i, vreinterpret_u16_f16(h));
+  }
+  scalar::f32_to_f16(src + i, dst + i, n - i);
+}
+
+static void f16_to_f32_neon(const uint16_t* src, float* dst, size_t n) {
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    float16x4_t h = vreinterpret_f16_u16(vld1_u16(src + i));
+    vst1q_f32(dst + i, vcvt_f32_f16(h));
+  }
+  scalar::f16_to_f32(src + i, dst + i, n - i);
+}
+
+static void pack_int4_neon(const int8_t* src, uint8_t* dst, size_t n) {
+  size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    int8x16x2_t pairs = vld2q_s8(src + i);
+    uint8x16_t lo = vandq_u8(vreinterpretq_u8_s8(pairs.val[0]), vdupq_n_u8(0x0F));
+    uint8x16_t hi = vshlq_n_u8(vreinterpretq_u8_s8(pairs.val[1]), 4);
+    vst1q_u8(dst + i / 2, vorrq_u8(lo, hi));
+  }
+  scalar::pack_int4(src + i, dst + i / 2, n - i);
+}
+
+static void unpack_int4_neon(const uint8_t* src, int8_t* dst, size_t n) {
+  size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    int8x16_t p = vreinterpretq_s8_u8(vld1q_u8(src + i / 2));
+    int8x16x2_t pairs;
+    pairs.val[0] = vshrq_n_s8(vshlq_n_s8(p, 4), 4);
+    pairs.val[1] = vshrq_n_s8(p, 4);
+    vst2q_s8(dst + i, pairs);
+  }
+  scalar::unpack_int4(src + i / 2, dst + i, n - i);
+}
+
+static float dot_neon(const float* a, const float* b, size_t n) {
+  float32x4_t acc = vdupq_n_f32(0.0f);
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) acc = vfmaq_f32(acc, vld1q_f32(a + i), vld1q_f32(b + i));
+  return vaddvq_f32(acc) + scalar::dot(a + i, b + i, n - i);
+}
+
+static float l2_sqr_neon(const float* a, const float* b, size_t n) {
+  float32x4_t acc = vdupq_n_f32(0.0f);
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    float32x4_t d = vsubq_f32(vld1q_f32(a + i), vld1q_f32(b + i));
+    acc = vfmaq_f32(acc, d, d);
+  }
+  return vaddvq_f32(acc) + scalar::l2_sqr(a + i, b + i, n - i);
+}
+
+// Same 4 x 2 blocking as dot_tile_avx2
+static void dot_tile_neon(const float* q, size_t nq, const float* x, size_t nx, size_t dim, float* out) {
+  size_t body = dim & ~static_cast<size_t>(3);
+  size_t i = 0;
+  for (; i + 4 <= nq; i += 4) {
+    const float* qs[4] = {q + i * dim, q + (i + 1) * dim, q + (i + 2) * dim, q + (i + 3) * dim};
+    size_t j = 0;
+    for (; j + 2 <= nx; j += 2) {
+      const float* x0 = x + j * dim;
+      const float* x1 = x0 + dim;
+      float32x4_t acc[4][2];
+      for (auto& row : acc) row[0] = row[1] = vdupq_n_f32(0.0f);
+      for (size_t k = 0; k < body; k += 4) {
+        float32x4_t v0 = vld1q_f32(x0 + k);
+        float32x4_t v1 = vld1q_f32(x1 + k);
+        for (size_t r = 0; r < 4; r++) {
+          float32x4_t u = vld1q_f32(qs[r] + k);
+          acc[r][0] = vfmaq_f32(acc[r][0], u, v0);
+          acc[r][1] = vfmaq_f32(acc[r][1], u, v1);
+        }
+      }
+      size_t tail = dim - body;
+      for (size_t r = 0; r < 4; r++) {
+        out[(i + r) * nx + j] = vaddvq_f32(acc[r][0]) + scalar::dot(qs[r] + body, x0 + body, tail);
+        out[(i + r) * nx + j + 1] = vaddvq_f32(acc[r][1]) + scalar::dot(qs[r] + body, x1 + body, tail);
+      }
+    }
+    for (; j < nx; j++) {
+      for (size_t r = 0; r < 4; r++) out[(i + r) * nx + j] = dot_neon(qs[r], x + j * dim, dim);
+    }
+  }
+  for (; i < nq; i++) {
+    for (size_t j = 0; j < nx; j++) out[i * nx + j] = dot_neon(q + i * dim, x + j * dim, dim);
+  }
+}
+
+#endif  // ZVEC_KERNELS_NEON
+
+// --- Runtime dispatch ---
+
+namespace {
+
+struct Dispatch {
+  const char* isa = "scalar";
+  void (*f32_to_f16)(const float*, uint16_t*, size_t) = scalar::f32_to_f16;
+  void (*f16_to_f32)(const uint16_t*, float*, size_t) = scalar::f16_to_f32;
+  void (*pack_int4)(const int8_t*, uint8_t*, size_t) = scalar::pack_int4;
+  void (*unpack_int4)(const uint8_t*, int8_t*, size_t) = scalar::unpack_int4;
+  float (*dot)(const float*, const float*, size_t) = scalar::dot;
+  float (*l2_sqr)(const float*, const float*, size_t) = scalar::l2_sqr;
+  void (*dot_tile)(const float*, size_t, const float*, size_t, size_t, float*) = scalar::dot_tile;
+
+  Dispatch() {
+#if defined(ZVEC_KERNELS_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+      isa = "avx2";
+      pack_int4 = pack_int4_avx2;
+      unpack_int4 = unpack_int4_avx2;
+      if (__builtin_cpu_supports("fma")) {
+        dot = dot_avx2;
+        l2_sqr = l2_sqr_avx2;
+        dot_tile = dot_tile_avx2;
+      }
+    }
+    if (__builtin_cpu_supports("avx") && __builtin_cpu_supports("f16c")) {
+      if (isa[0] == 's') isa = "f16c";
+      f32_to_f16 = f32_to_f16_f16c;
+      f16_to_f32 = f16_to_f32_f16c;
+    }
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("f16c")) {
+      isa = "avx512";
+      f32_to_f16 = f32_to_f16_avx512;
+      f16_to_f32 = f16_to_f32_avx512;
+    }
+    if (__builtin_cpu_supports("avx512f")) {
+      dot = dot_avx512;
+      l2_sqr = l2_sqr_avx512;
+    }
+#elif defined(ZVEC_KERNELS_NEON)
+    isa = "neon";
+    f32_to_f16 = f32_to_f16_neon;
+    f16_to_f32 = f16_to_f32_neon;
+    pack_int4 = pack_int4_neon;
+    unpack_int4 = unpack_int4_neon;
+    dot = dot_neon;
+    l2_sqr = l2_sqr_neon;
+    dot_tile = dot_tile_neon;
+#endif
+  }
+};
+
+const Dispatch& dispatch() {
+  static const Dispatch d;
+  return d;
+}
+
+}  // namespace
+
+void f32_to_f16(const float* src, uint16_t* dst, size_t n) { dispatch().f32_to_f16(src, dst, n); }
+void f16_to_f32(const uint16_t* src, float* dst, size_t n) { dispatch().f16_to_f32(src, dst, n); }
+void pack_int4(const int8_t* src, uint8_t* dst, size_t n) { dispatch().pack_int4(src, dst, n); }
+void unpack_int4(const uint8_t* src, int8_t* dst, size_t n) { dispatch().unpack_int4(src, dst, n); }
+float dot(const float* a, const float* b, size_t n) { return dispatch().dot(a, b, n); }
+float l2_sqr(const float* a, const float* b, size_t n) { return dispatch().l2_sqr(a, b, n); }
+void dot_tile(const float* q, size_t nq, const float* x, size_t nx, size_t dim, float* out) {
+  dispatch().dot_tile(q, nq, x, nx, dim, out);
+}
+const char* isa() { return dispatch().isa; }
+
+void normalize(float* v, size_t dim) {
+  float n = std::sqrt(dot(v, v, dim));
+  if (n == 0.0f) return;
+  for (size_t k = 0; k < dim; k++) v[k] /= n;
+}
+
+}  // namespace kernels
+}  // namespace zvec_rb
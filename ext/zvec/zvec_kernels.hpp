@@ -0,0 +1,53 @@
+#pragma once
+
+// Bulk vector encoding kernels. Plain C++ with no Ruby or zvec dependency so
+// the benchmark target can link them directly. Each entry point dispatches at
+// runtime to the widest instruction set the CPU supports (AVX-512, AVX2/F16C,
+// NEON) and falls back to portable scalar code.
+
+#include <cstddef>
+#include <cstdint>
+
+namespace zvec_rb {
+namespace kernels {
+
+// IEEE half precision <-> single precision, round to nearest even
+void f32_to_f16(const float* src, uint16_t* dst, size_t n);
+void f16_to_f32(const uint16_t* src, float* dst, size_t n);
+
+// Signed 4-bit values (-8..7), two per byte: element 2i in the low nibble,
+// element 2i+1 in the high nibble. dst for pack_int4 holds (n + 1) / 2 bytes.
+void pack_int4(const int8_t* src, uint8_t* dst, size_t n);
+void unpack_int4(const uint8_t* src, int8_t* dst, size_t n);
+
+inline size_t int4_packed_size(size_t n) { return (n + 1) / 2; }
+
+// Float32 distance primitives used for exact re-scoring
+float dot(const float* a, const float* b, size_t n);
+float l2_sqr(const float* a, const float* b, size_t n);
+
+// Scale v to unit length in place (left as is when all zero)
+void normalize(float* v, size_t dim);
+
+// Inner products of nq row-major queries with nx row-major vectors of the
+// same dimension: out[i * nx + j] = dot(q_i, x_j). Register-blocked so each
+// loaded chunk of a query or vector feeds several FMAs.
+void dot_tile(const float* q, size_t nq, const float* x, size_t nx, size_t dim, float* out);
+
+// Name of the instruction set selected by the dispatcher (e.g. "avx512")
+const char* isa();
+
+// Portable reference implementations, used as the fallback and by the
+// benchmark to verify the vector paths
+namespace scalar {
+void f32_to_f16(const float* src, uint16_t* dst, size_t n);
+void f16_to_f32(const uint16_t* src, float* dst, size_t n);
+void pack_int4(const int8_t* src, uint8_t* dst, size_t n);
+void unpack_int4(const uint8_t* src, int8_t* dst, size_t n);
+float dot(const float* a, const float* b, size_t n);
+float l2_sqr(const float* a, const float* b, size_t n);
+void dot_tile(const float* q, size_t nq, const float* x, size_t nx, size_t dim, float* out);
+}  // namespace scalar
+
+}  // namespace kernels
+}  // namespace zvec_rb
@@ -0,0 +1,213 @@
+#include "zvec_maxsim.hpp"
+#include "zvec_kernels.hpp"
+#include "zvec_pool.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <unordered_map>
+
+using namespace Rice;
+
+namespace zvec_rb {
+
+const char* const kMultiVectorParent = "parent";
+const char* const kMultiVectorTokenCount = "token_count";
+
+using Clock = std::chrono::steady_clock;
+using float16_t = zvec::ailego::Float16;
+
+// Token pks per Fetch call
+static const size_t kFetchChunk = 1024;
+
+// Token vector as float32, from an FP32 or FP16 field
+static bool token_vector(const zvec::Doc& doc, const std::string& field, zvec::DataType dt, uint32_t dim,
+                         float* out) {
+  if (dt == zvec::DataType::VECTOR_FP32) {
+    auto v = doc.get<std::vector<float>>(field);
+    if (!v || v->size() != dim) return false;
+    std::memcpy(out, v->data(), dim * sizeof(float));
+    return true;
+  }
+  auto v = doc.get<std::vector<float16_t>>(field);
+  if (!v || v->size() != dim) return false;
+  kernels::f16_to_f32(reinterpret_cast<const uint16_t*>(v->data()), out, dim);
+  return true;
+}
+
+MaxSimResult maxsim_query(const zvec::Collection& collection, const zvec::FieldSchema& field,
+                          const std::vector<float>& queries, size_t nq, const MaxSimOptions& options) {
+  MaxSimResult result;
+  const uint32_t dim = field.dimension();
+  const zvec::DataType dt = field.data_type();
+  size_t threads = thread_count(options.concurrency);
+  if (nq == 0 || options.topk == 0) return result;
+
+  // Stage 1: nearest token rows for each query vector, keyed by their doc
+  auto start = Clock::now();
+  std::vector<std::unordered_map<std::string, int32_t>> found(threads);
+  std::vector<zvec::Status> errors(threads);
+  parallel_for(nq, threads, [&](size_t w, size_t i) {
+    if (!errors[w].ok()) return;
+    zvec::VectorQuery q;
+    q.field_name_ = field.name();
+    q.topk_ = static_cast<int>(options.candidates);
+    q.filter_ = options.filter;
+    q.query_params_ = options.query_params;
+    q.output_fields_ = std::vector<std::string>{kMultiVectorParent, kMultiVectorTokenCount};
+    const float* v = queries.data() + i * dim;
+    if (dt == zvec::DataType::VECTOR_FP16) {
+      std::vector<uint16_t> h(dim);
+      kernels::f32_to_f16(v, h.data(), dim);
+      q.query_vector_.assign(reinterpret_cast<const char*>(h.data()), dim * sizeof(uint16_t));
+    } else {
+      q.query_vector_.assign(reinterpret_cast<const char*>(v), dim * sizeof(float));
+    }
+    auto hits = collection.Query(q);
+    if (!hits.has_value()) {
+      errors[w] = hits.error();
+      return;
+    }
+    for (auto& hit : hits.value()) {
+      auto parent = hit->get<std::string>(kMultiVectorParent);
+      auto count = hit->get<int32_t>(kMultiVectorTokenCount);
+      if (parent && count && *count > 0) found[w].emplace(*parent, *count);
+    }
+  });
+  for (auto& e : errors) {
+    if (!e.ok()) {
+      result.status = e;
+      return result;
+    }
+  }
+  std::unordered_map<std::string, int32_t> merged;
+  for (auto& f : found) merged.insert(f.begin(), f.end());
+  std::vector<std::pair<std::string, int32_t>> docs(merged.begin(), merged.end());
+  result.candidate_count = docs.size();
+  result.candidate_ms = ms_since(start);
+
+  // Stage 2: every token of every candidate, fetched by pk in chunks
+  start = Clock::now();
+  std::vector<size_t> offsets(docs.size() + 1, 0);
+  for (size_t d = 0; d < docs.size(); d++) offsets[d + 1] = offsets[d] + static_cast<size_t>(docs[d].second);
+  size_t total = offsets.back();
+  std::vector<float> tokens(total * dim, 0.0f);
+  std::vector<uint8_t> present(total, 0);
+  std::vector<std::pair<size_t, std::string>> slots;  // token slot, pk
+  slots.reserve(total);
+  for (size_t d = 0; d < docs.size(); d++) {
+    for (int32_t t = 0; t < docs[d].second; t++) {
+      slots.emplace_back(offsets[d] + t, docs[d].first + "#" + std::to_string(t));
+    }
+  }
+  size_t chunks = (slots.size() + kFetchChunk - 1) / kFetchChunk;
+  errors.assign(threads, zvec::Status());
+  parallel_for(chunks, threads, [&](size_t w, size_t c) {
+    if (!errors[w].ok()) return;
+    size_t begin = c * kFetchChunk;
+    size_t end = std::min(slots.size(), begin + kFetchChunk);
+    std::vector<std::string> pks;
+    pks.reserve(end - begin);
+    for (size_t s = begin; s < end; s++) pks.push_back(slots[s].second);
+    auto fetched = collection.Fetch(pks);
+    if (!fetched.has_value()) {
+      errors[w] = fetched.error();
+      return;
+    }
+    auto& map = fetched.value();
+    for (size_t s = begin; s < end; s++) {
+      auto it = map.find(slots[s].second);
+      // Rewritten with fewer tokens between the two stages
+      if (it == map.end() || !it->second) continue;
+      size_t slot = slots[s].first;
+      present[slot] = token_vector(*it->second, field.name(), dt, dim, tokens.data() + slot * dim);
+    }
+  });
+  for (auto& e : errors) {
+    if (!e.ok()) {
+      result.status = e;
+      return result;
+    }
+  }
+  result.token_count = total;
+  result.fetch_ms = ms_since(start);
+
+  // Stage 3: exact MaxSim per doc on the dot_tile kernel
+  start = Clock::now();
+  bool cosine = options.metric == zvec::MetricType::COSINE;
+  std::vector<float> q(queries.begin(), queries.begin() + nq * dim);
+  if (cosine) {
+    for (size_t i = 0; i < nq; i++) kernels::normalize(q.data() + i * dim, dim);
+    for (size_t s = 0; s < total; s++) kernels::normalize(tokens.data() + s * dim, dim);
+  }
+  std::vector<float> scores(docs.size(), 0.0f);
+  std::vector<uint8_t> scored(docs.size(), 0);
+  parallel_for(docs.size(), threads, [&](size_t, size_t d) {
+    // Pack this doc's tokens that were actually fetched
+    std::vector<float> mine;
+    mine.reserve((offsets[d + 1] - offsets[d]) * dim);
+    for (size_t s = offsets[d]; s < offsets[d + 1]; s++) {
+      if (present[s]) mine.insert(mine.end(), tokens.begin() + s * dim, tokens.begin() + (s + 1) * dim);
+    }
+    size_t nt = mine.size() / dim;
+    if (nt == 0) return;
+    std::vector<float> sims(nq * nt);
+    kernels::dot_tile(q.data(), nq, mine.data(), nt, dim, sims.data());
+    float total_score = 0.0f;
+    for (size_t i = 0; i < nq; i++) {
+      const float* row = sims.data() + i * nt;
+      total_score += *std::max_element(row, row + nt);
+    }
+    scores[d] = total_score;
+    scored[d] = 1;
+  });
+
+  std::vector<size_t> order;
+  for (size_t d = 0; d < docs.size(); d++) {
+    if (scored[d]) order.push_back(d);
+  }
+  size_t keep = std::min<size_t>(options.topk, order.size());
+  std::partial_sort(order.begin(), order.begin() + keep, order.end(), [&](size_t a, size_t b) {
+    return scores[a] > scores[b] || (scores[a] == scores[b] && docs[a].first < docs[b].first);
+  });
+  result.hits.reserve(keep);
+  for (size_t r = 0; r < keep; r++) result.hits.emplace_back(docs[order[r]].first, scores[order[r]]);
+  result.score_ms = ms_since(start);
+  return result;
+}
+
+}  // namespace zvec_rb
+
+void init_zvec_maxsim(Rice::Module& m) {
+  Rice::define_class_under<zvec_rb::MaxSimResult>(m, "MaxSimResult")
+    // [pk, score] per doc, best first
+    .define_method("hits", [](const zvec_rb::MaxSimResult& r) {
+      Rice::Array arr;
+      for (const auto& [pk, score] : r.hits) {
+        Rice::Array pair;
+        pair.push(pk);
+        pair.push(score);
+        arr.push(pair);
+      }
+      return arr;
+    })
+    .define_method("pks", [](const zvec_rb::MaxSimResult& r) {
+      Rice::Array arr;
+      for (const auto& hit : r.hits) arr.push(hit.first);
+      return arr;
+    })
+    .define_method("size", [](const zvec_rb::MaxSimResult& r) { return r.hits.size(); })
+    .define_method("candidate_count", [](const zvec_rb::MaxSimResult& r) { return r.candidate_count; })
+    .define_method("token_count", [](const zvec_rb::MaxSimResult& r) { return r.token_count; })
+    .define_method("candidate_ms", [](const zvec_rb::MaxSimResult& r) { return r.candidate_ms; })
+    .define_method("fetch_ms", [](const zvec_rb::MaxSimResult& r) { return r.fetch_ms; })
+    .define_method("score_ms", [](const zvec_rb::MaxSimResult& r) { return r.score_ms; })
+    .define_method("to_s", [](const zvec_rb::MaxSimResult& r) -> std::string {
+      char buf[192];
+      std::snprintf(buf, sizeof(buf),
+                    "MaxSimResult(size=%zu, candidates=%zu, tokens=%zu, candidate=%.2fms, fetch=%.2fms, score=%.2fms)",
+                    r.hits.size(), r.candidate_count, r.token_count, r.candidate_ms, r.fetch_ms, r.score_ms);
+      return buf;
+    });
+}
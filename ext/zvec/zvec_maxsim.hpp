@@ -0,0 +1,44 @@
+#pragma once
+
+#include "zvec_common.hpp"
+
+namespace zvec_rb {
+
+// Multi-vector (late-interaction) documents are stored one row per token
+// vector: pk "<doc pk>#<token>", the doc pk in kMultiVectorParent and the
+// doc's token count in kMultiVectorTokenCount. The engine has no
+// multi-vector field type, so the per-token index is a regular vector
+// index on these rows (see Zvec::MultiVector).
+extern const char* const kMultiVectorParent;
+extern const char* const kMultiVectorTokenCount;
+
+struct MaxSimOptions {
+  std::string field;
+  uint32_t topk = 10;
+  uint32_t candidates = 64;  // token hits per query vector
+  std::string filter;
+  zvec::QueryParams::Ptr query_params;
+  zvec::MetricType metric = zvec::MetricType::UNDEFINED;
+  uint32_t concurrency = 0;  // 0 = all cores
+};
+
+struct MaxSimResult {
+  zvec::Status status;
+  std::vector<std::pair<std::string, float>> hits;  // doc pk, score; best first
+  size_t candidate_count = 0;                       // docs re-scored
+  size_t token_count = 0;                           // token vectors fetched
+  double candidate_ms = 0;
+  double fetch_ms = 0;
+  double score_ms = 0;
+};
+
+// Late-interaction search over a token field. Each query vector retrieves
+// its nearest token rows from the index; every doc they belong to is then
+// scored exactly as sum over query vectors of the best dot product with
+// any of its tokens (MaxSim). COSINE normalizes both sides first. Token
+// matrices are scored with the dot_tile kernel on native threads. Runs
+// without the GVL; engine errors come back in status.
+MaxSimResult maxsim_query(const zvec::Collection& collection, const zvec::FieldSchema& field,
+                          const std::vector<float>& queries, size_t nq, const MaxSimOptions& options);
+
+}  // namespace zvec_rb
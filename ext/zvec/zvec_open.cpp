@@ -0,0 +1,126 @@
+#include "zvec_open.hpp"
+#include "zvec_stats.hpp"
+
+#include <chrono>
+#include <fcntl.h>
+#include <filesystem>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace zvec_rb {
+
+using Clock = std::chrono::steady_clock;
+
+OpenProfile::OpenProfile(std::string root, bool lazy, std::vector<std::string> fields,
+                         const std::vector<std::string>& index_fields)
+    : root_(std::move(root)), lazy_(lazy), fields_(std::move(fields)) {
+  for (auto& f : index_fields) loads_.emplace(f, lazy ? Load::PENDING : Load::LOADED);
+}
+
+void OpenProfile::record(const std::string& phase, double ms) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  phases_.emplace_back(phase, ms);
+}
+
+void OpenProfile::touch(const std::string& field) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  auto it = loads_.find(field);
+  if (it == loads_.end() || it->second == Load::LOADED) return;
+  if (it->second == Load::LOADING) {
+    // Done either way: a failed walk goes back to PENDING, and this query
+    // proceeds without the hints rather than walking again
+    loaded_.wait(lock, [&] { return it->second != Load::LOADING; });
+    return;
+  }
+  it->second = Load::LOADING;
+  lock.unlock();
+
+  auto start = Clock::now();
+  size_t files = 0;
+  try {
+    files = prefetch(field);
+  } catch (...) {
+    // Leave it for the next caller; the engine still pages the files in itself
+    lock.lock();
+    it->second = Load::PENDING;
+    loaded_.notify_all();
+    return;
+  }
+  double ms = ms_since(start);
+
+  lock.lock();
+  it->second = files > 0 ? Load::LOADED : Load::UNMATCHED;
+  if (files > 0) phases_.emplace_back("index:" + field, ms);
+  loaded_.notify_all();
+}
+
+// Ask the kernel to read every file attributed to the field into the page
+// cache in the background, so later page faults on its mappings are served
+// from memory. Nothing here waits for the reads.
+size_t OpenProfile::prefetch(const std::string& field) const {
+  size_t files = 0;
+  std::error_code ec;
+  for (auto it = fs::recursive_directory_iterator(root_, ec); !ec && it != fs::recursive_directory_iterator();
+       it.increment(ec)) {
+    if (!it->is_regular_file(ec)) continue;
+    if (field_for_path(fs::relative(it->path(), root_, ec).string(), fields_) != field) continue;
+    files++;
+#if defined(POSIX_FADV_WILLNEED)
+    int fd = ::open(it->path().c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) continue;
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+    ::close(fd);
+#endif
+  }
+  return files;
+}
+
+std::vector<std::pair<std::string, double>> OpenProfile::phases() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return phases_;
+}
+
+std::vector<std::string> OpenProfile::with_state(Load state) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<std::string> out;
+  for (auto& [field, load] : loads_) {
+    if (load == state || (state == Load::PENDING && load == Load::LOADING)) out.push_back(field);
+  }
+  return out;
+}
+
+std::vector<std::string> OpenProfile::pending() const { return with_state(Load::PENDING); }
+
+std::vector<std::string> OpenProfile::unmatched() const { return with_state(Load::UNMATCHED); }
+
+zvec::Status open_profiled(const std::string& path, const zvec::CollectionSchema* schema,
+                           const zvec::CollectionOptions& options, bool lazy,
+                           zvec::Collection::Ptr& collection, std::shared_ptr<OpenProfile>& profile) {
+  // The engine reads its manifest and forward store here, and loads
+  // indexes unless they are mapped
+  auto start = Clock::now();
+  auto opened = schema ? zvec::Collection::CreateAndOpen(path, *schema, options)
+                       : zvec::Collection::Open(path, options);
+  double open_ms = ms_since(start);
+  if (!opened.has_value()) return opened.error();
+  collection = std::move(opened.value());
+
+  start = Clock::now();
+  auto loaded = collection->Schema();
+  if (!loaded.has_value()) return loaded.error();
+  std::vector<std::string> names = loaded.value().all_field_names();
+  std::vector<std::string> index_fields;
+  for (auto& name : names) {
+    const zvec::FieldSchema* fs = loaded.value().get_field(name);
+    if (fs && fs->is_vector_field() && fs->index_params()) index_fields.push_back(name);
+  }
+  double schema_ms = ms_since(start);
+
+  profile = std::make_shared<OpenProfile>(path, lazy, std::move(names), index_fields);
+  profile->record("open", open_ms);
+  profile->record("schema", schema_ms);
+  return zvec::Status();
+}
+
+}  // namespace zvec_rb
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "zvec_common.hpp"
+
+#include <condition_variable>
+#include <mutex>
+#include <unordered_map>
+
+namespace zvec_rb {
+
+// Where the time went when a collection was opened through the bindings.
+// In lazy mode the collection is opened with mmap on, and on first use of
+// each vector field the kernel is asked to read that field's index files
+// ahead (posix_fadvise WILLNEED), which shows up here as an "index:<field>"
+// phase. Files are found by name (field_for_path); a field none of whose
+// files could be identified is reported as unmatched, not loaded.
+class OpenProfile {
+ public:
+  OpenProfile(std::string root, bool lazy, std::vector<std::string> fields,
+              const std::vector<std::string>& index_fields);
+
+  bool lazy() const { return lazy_; }
+  void record(const std::string& phase, double ms);
+
+  // Start readahead of a field's index files once. The hints return
+  // without waiting for the reads, so the caller only pays for a directory
+  // walk. Concurrent callers for the same field wait for the first walk;
+  // later calls return immediately, and a failed walk is retried by the
+  // next caller. No-op unless lazy or for fields without a vector index.
+  void touch(const std::string& field);
+
+  std::vector<std::pair<std::string, double>> phases() const;
+  // Indexed fields not touched yet
+  std::vector<std::string> pending() const;
+  // Touched fields with no file attributed to them, so nothing was read ahead
+  std::vector<std::string> unmatched() const;
+
+ private:
+  enum class Load { PENDING, LOADING, LOADED, UNMATCHED };
+
+  // Files hinted
+  size_t prefetch(const std::string& field) const;
+  std::vector<std::string> with_state(Load state) const;
+
+  std::string root_;
+  bool lazy_;
+  std::vector<std::string> fields_;  // every schema field, for file attribution
+
+  mutable std::mutex mutex_;
+  std::condition_variable loaded_;
+  std::vector<std::pair<std::string, double>> phases_;
+  std::unordered_map<std::string, Load> loads_;
+};
+
+// Open (schema == nullptr) or create a collection and time each phase.
+// Takes no Ruby objects, so it may run without the GVL.
+zvec::Status open_profiled(const std::string& path, const zvec::CollectionSchema* schema,
+                           const zvec::CollectionOptions& options, bool lazy,
+                           zvec::Collection::Ptr& collection, std::shared_ptr<OpenProfile>& profile);
+
+}  // namespace zvec_rb
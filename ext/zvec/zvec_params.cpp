@@ -1,4 +1,5 @@
 #include "zvec_common.hpp"
+#include "zvec_kernels.hpp"
 
 using namespace Rice;
 
@@ -34,6 +35,22 @@ static std::pair<std::string, std::string> serialize_sparse_vector(Rice::Hash ru
   return {idx_buf, val_buf};
 }
 
+// Helper to take a pre-encoded query vector (e.g. from Zvec::Quantizer) as-is.
+// INT4 input is one int8 per element and is packed to match stored docs.
+static std::string serialize_packed_vector(const zvec::FieldSchema& fs, Rice::Object ruby_data) {
+  VALUE str = ruby_data.value();
+  Check_Type(str, T_STRING);
+  const char* data = RSTRING_PTR(str);
+  size_t len = static_cast<size_t>(RSTRING_LEN(str));
+  if (fs.data_type() != zvec::DataType::VECTOR_INT4) return std::string(data, len);
+  if (len % 2 != 0) throw std::invalid_argument("VECTOR_INT4 needs an even dimension, got " + std::to_string(len));
+
+  std::string buf(zvec_rb::kernels::int4_packed_size(len), '\0');
+  zvec_rb::kernels::pack_int4(reinterpret_cast<const int8_t*>(data),
+                              reinterpret_cast<uint8_t*>(&buf[0]), len);
+  return buf;
+}
+
 void init_zvec_params(Rice::Module& m) {
   // --- IndexParams hierarchy ---
 
@@ -182,6 +199,11 @@ void init_zvec_params(Rice::Module& m) {
         Rice::Array arr(ruby_data);
         q.query_vector_ = serialize_float_array(arr);
       }
+    })
+    .define_method("set_packed_vector", [](zvec::VectorQuery& q,
+                                           const zvec::FieldSchema& fs,
+                                           Rice::Object ruby_data) {
+      q.query_vector_ = serialize_packed_vector(fs, ruby_data);
     });
 
   // --- GroupByVectorQuery ---
@@ -214,18 +236,10 @@ void init_zvec_params(Rice::Module& m) {
         Rice::Array arr(ruby_data);
         q.query_vector_ = serialize_float_array(arr);
       }
-    });
-
-  // --- GroupResult ---
-  Rice::define_class_under<zvec::GroupResult>(m, "GroupResult")
-    .define_method("group_by_value", [](const zvec::GroupResult& gr) { return gr.group_by_value_; })
-    .define_method("docs", [](const zvec::GroupResult& gr) {
-      Rice::Array result;
-      for (const auto& doc : gr.docs_) {
-        // Copy doc into a shared_ptr for Ruby ownership
-        auto ptr = std::make_shared<zvec::Doc>(doc);
-        result.push(ptr);
-      }
-      return result;
+    })
+    .define_method("set_packed_vector", [](zvec::GroupByVectorQuery& q,
+                                           const zvec::FieldSchema& fs,
+                                           Rice::Object ruby_data) {
+      q.query_vector_ = serialize_packed_vector(fs, ruby_data);
     });
 }
@@ -0,0 +1,867 @@
+#include "zvec_partition.hpp"
+#include "zvec_doc_builder.hpp"
+#include "zvec_filter.hpp"
+#include "zvec_pool.hpp"
+#include "zvec_scheduler.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <set>
+
+using namespace Rice;
+
+namespace fs = std::filesystem;
+
+namespace zvec_rb {
+
+static const char* kKeyFile = "partition_key";
+static const char* kOwnersFile = "pk_partitions";
+// Superseded pk map log lines tolerated before the log is rewritten
+static const size_t kOwnersSlack = 4096;
+
+// --- Filter pruning ---
+
+// Canonical partition value of a filter literal, or false when the literal
+// cannot equal a key of this type
+static bool literal_value(const FilterToken& t, zvec::DataType key_type, std::string& out) {
+  bool string_key = key_type == zvec::DataType::STRING;
+  if (t.kind == FilterToken::Kind::STRING) {
+    if (!string_key) return false;
+    out.clear();
+    for (size_t i = 1; i + 1 < t.text.size(); i++) {
+      if (t.text[i] == '\\' && i + 2 < t.text.size()) i++;
+      out.push_back(t.text[i]);
+    }
+    return true;
+  }
+  if (t.kind != FilterToken::Kind::NUMBER || string_key) return false;
+  try {
+    size_t used = 0;
+    if (key_type == zvec::DataType::UINT32 || key_type == zvec::DataType::UINT64) {
+      if (t.text[0] == '-') return false;
+      out = std::to_string(std::stoull(t.text, &used));
+    } else {
+      out = std::to_string(std::stoll(t.text, &used));
+    }
+    return used == t.text.size();
+  } catch (const std::exception&) {
+    return false;
+  }
+}
+
+// Values pinned by one conjunct tokens[s, e), or false if it does not pin
+static bool conjunct_values(const std::vector<FilterToken>& t, size_t s, size_t e,
+                            const std::string& key, zvec::DataType key_type,
+                            std::set<std::string>& values) {
+  using K = FilterToken::Kind;
+  auto is_key = [&](size_t i) { return t[i].kind == K::IDENT && t[i].text == key; };
+  std::string v;
+  if (e - s == 3 && t[s + 1].kind == K::OP && t[s + 1].text == "=") {
+    if (is_key(s) && literal_value(t[s + 2], key_type, v)) return values.insert(v), true;
+    if (is_key(s + 2) && literal_value(t[s], key_type, v)) return values.insert(v), true;
+    return false;
+  }
+  if (e - s >= 5 && is_key(s) && t[s + 1].kind == K::KEYWORD && t[s + 1].text == "IN" &&
+      t[s + 2].kind == K::LPAREN && t[e - 1].kind == K::RPAREN) {
+    std::set<std::string> in;
+    for (size_t i = s + 3; i < e - 1; i += 2) {
+      if (!literal_value(t[i], key_type, v)) return false;
+      in.insert(v);
+      if (i + 1 < e - 1 && t[i + 1].kind != K::COMMA) return false;
+    }
+    values = std::move(in);
+    return true;
+  }
+  return false;
+}
+
+PartitionPruning prune_partitions(const std::string& filter, const std::string& key,
+                                  zvec::DataType key_type) {
+  PartitionPruning result;
+  result.residual = filter;
+  auto tokens = tokenize_filter(filter);
+
+  // Split on top-level AND; a top-level OR means the key is not pinned
+  std::vector<std::pair<size_t, size_t>> conjuncts;
+  int depth = 0;
+  size_t start = 0;
+  for (size_t i = 0; i < tokens.size(); i++) {
+    const auto& t = tokens[i];
+    if (t.kind == FilterToken::Kind::LPAREN) depth++;
+    if (t.kind == FilterToken::Kind::RPAREN) depth--;
+    if (depth != 0 || t.kind != FilterToken::Kind::KEYWORD) continue;
+    if (t.text == "OR") return result;
+    if (t.text == "AND") {
+      conjuncts.emplace_back(start, i);
+      start = i + 1;
+    }
+  }
+  conjuncts.emplace_back(start, tokens.size());
+
+  std::optional<std::set<std::string>> pinned;
+  std::string residual;
+  for (auto [s, e] : conjuncts) {
+    std::set<std::string> values;
+    if (s < e && conjunct_values(tokens, s, e, key, key_type, values)) {
+      if (pinned) {
+        std::set<std::string> both;
+        for (auto& v : values) {
+          if (pinned->count(v)) both.insert(v);
+        }
+        values = std::move(both);
+      }
+      pinned = std::move(values);
+      continue;
+    }
+    if (s >= e) continue;
+    size_t from = tokens[s].offset;
+    size_t to = tokens[e - 1].offset + tokens[e - 1].length;
+    if (!residual.empty()) residual += " AND ";
+    residual += filter.substr(from, to - from);
+  }
+  if (!pinned) return result;
+
+  result.pinned = true;
+  result.values.assign(pinned->begin(), pinned->end());
+  result.residual = residual;
+  return result;
+}
+
+// --- PartitionedCollection ---
+
+static bool valid_key_type(zvec::DataType t) {
+  return t == zvec::DataType::STRING || t == zvec::DataType::INT32 || t == zvec::DataType::INT64 ||
+         t == zvec::DataType::UINT32 || t == zvec::DataType::UINT64;
+}
+
+static std::string hex_encode(const std::string& s) {
+  static const char* hex = "0123456789abcdef";
+  std::string out;
+  out.reserve(s.size() * 2);
+  for (unsigned char c : s) {
+    out.push_back(hex[c >> 4]);
+    out.push_back(hex[c & 15]);
+  }
+  return out;
+}
+
+static int hex_digit(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  return -1;
+}
+
+// False for anything hex_encode could not have produced
+static bool hex_decode(const std::string& s, std::string& out) {
+  if (s.size() % 2) return false;
+  out.clear();
+  for (size_t i = 0; i < s.size(); i += 2) {
+    int hi = hex_digit(s[i]), lo = hex_digit(s[i + 1]);
+    if (hi < 0 || lo < 0) return false;
+    out.push_back(static_cast<char>(hi << 4 | lo));
+  }
+  return true;
+}
+
+static zvec::Status first_error(const std::vector<zvec::Status>& statuses) {
+  for (auto& s : statuses) {
+    if (!s.ok()) return s;
+  }
+  return zvec::Status();
+}
+
+PartitionedCollection::PartitionedCollection(std::string path, zvec::CollectionOptions options,
+                                             zvec::Collection::Ptr template_collection,
+                                             std::string key, zvec::DataType key_type)
+    : path_(std::move(path)),
+      options_(options),
+      template_(std::move(template_collection)),
+      key_(std::move(key)),
+      key_type_(key_type) {}
+
+PartitionedCollection* PartitionedCollection::create(const std::string& path,
+                                                     const zvec::CollectionSchema& schema,
+                                                     const std::string& key,
+                                                     const zvec::CollectionOptions& options,
+                                                     zvec::Status& status) {
+  const zvec::FieldSchema* field = schema.get_field(key);
+  if (!field) throw std::invalid_argument("Unknown partition key: " + key);
+  if (!valid_key_type(field->data_type()))
+    throw std::invalid_argument("partition key must be a STRING or integer field: " + key);
+  if (fs::exists(path)) throw std::invalid_argument("path already exists: " + path);
+
+  fs::create_directories(fs::path(path) / "partitions");
+  std::ofstream(fs::path(path) / kKeyFile) << key << "\n";
+  auto created = zvec::Collection::CreateAndOpen((fs::path(path) / "template").string(), schema, options);
+  if (!created.has_value()) {
+    status = created.error();
+    return nullptr;
+  }
+  std::unique_ptr<PartitionedCollection> pc(new PartitionedCollection(
+    path, options, register_collection(std::move(created.value())), key, field->data_type()));
+  pc->load_owners();
+  return pc.release();
+}
+
+PartitionedCollection* PartitionedCollection::open(const std::string& path,
+                                                   const zvec::CollectionOptions& options,
+                                                   zvec::Status& status) {
+  std::ifstream in(fs::path(path) / kKeyFile);
+  std::string key;
+  if (!std::getline(in, key) || key.empty())
+    throw std::invalid_argument("not a partitioned collection: " + path);
+
+  auto opened = zvec::Collection::Open((fs::path(path) / "template").string(), options);
+  if (!opened.has_value()) {
+    status = opened.error();
+    return nullptr;
+  }
+  auto template_collection = register_collection(std::move(opened.value()));
+  auto schema = template_collection->Schema();
+  if (!schema.has_value()) {
+    status = schema.error();
+    return nullptr;
+  }
+  const zvec::FieldSchema* field = schema.value().get_field(key);
+  if (!field) throw std::invalid_argument("partition key missing from schema: " + key);
+
+  std::unique_ptr<PartitionedCollection> pc(
+    new PartitionedCollection(path, options, template_collection, key, field->data_type()));
+
+  // Directory names are "p" + the hex-encoded value
+  for (auto& entry : fs::directory_iterator(fs::path(path) / "partitions")) {
+    std::string name = entry.path().filename().string();
+    std::string value;
+    if (!entry.is_directory() || name.empty() || name[0] != 'p' || !hex_decode(name.substr(1), value)) continue;
+    auto part = zvec::Collection::Open(entry.path().string(), options);
+    if (!part.has_value()) {
+      status = part.error();
+      return nullptr;
+    }
+    pc->partitions_.emplace(value, register_collection(std::move(part.value())));
+  }
+  pc->load_owners();
+  return pc.release();
+}
+
+std::string PartitionedCollection::partition_dir(const std::string& value) const {
+  return (fs::path(path_) / "partitions" / ("p" + hex_encode(value))).string();
+}
+
+// --- pk map ---
+//
+// Each log line is "<hex pk> <hex value>"; an empty value removes the pk.
+// Entries are written before the rows they describe, so an entry may name a
+// partition that never received the row (or has since lost it to
+// delete_by_filter or drop_partition), but a written row always has one.
+
+void PartitionedCollection::load_owners() {
+  std::ifstream in(fs::path(path_) / kOwnersFile);
+  std::string line, pk, value;
+  while (std::getline(in, line)) {
+    size_t space = line.find(' ');
+    // A line torn by a crash is skipped; its rows were never written
+    if (space == std::string::npos || !hex_decode(line.substr(0, space), pk) ||
+        !hex_decode(line.substr(space + 1), value))
+      continue;
+    owners_logged_++;
+    if (value.empty()) owners_.erase(pk);
+    else owners_[pk] = value;
+  }
+  // drop_partition leaves its entries behind; shed them here
+  for (auto it = owners_.begin(); it != owners_.end();) {
+    if (partitions_.count(it->second)) ++it;
+    else it = owners_.erase(it);
+  }
+  compact_owners();
+}
+
+void PartitionedCollection::append_owner(const std::string& pk, const std::string& value) {
+  owners_log_ << hex_encode(pk) << ' ' << hex_encode(value) << '\n';
+  owners_logged_++;
+}
+
+void PartitionedCollection::compact_owners() {
+  fs::path file = fs::path(path_) / kOwnersFile;
+  if (owners_logged_ > 2 * owners_.size() + kOwnersSlack) {
+    owners_log_.close();
+    fs::path tmp = file;
+    tmp += ".tmp";
+    std::ofstream out(tmp, std::ios::trunc);
+    for (auto& [pk, value] : owners_) out << hex_encode(pk) << ' ' << hex_encode(value) << '\n';
+    if (!out.flush()) throw fs::filesystem_error("write pk map", tmp, std::make_error_code(std::errc::io_error));
+    out.close();
+    fs::rename(tmp, file);
+    owners_logged_ = owners_.size();
+  }
+  if (!owners_log_.is_open()) owners_log_.open(file, std::ios::app);
+}
+
+void PartitionedCollection::record_owner(const std::vector<std::string>& pks, const std::string& value) {
+  std::lock_guard<std::mutex> lock(owners_mutex_);
+  for (auto& pk : pks) {
+    std::string& owner = owners_[pk];
+    if (owner == value) continue;
+    owner = value;
+    append_owner(pk, value);
+  }
+  if (!owners_log_.flush())
+    throw fs::filesystem_error("write pk map", fs::path(path_) / kOwnersFile, std::make_error_code(std::errc::io_error));
+  compact_owners();
+}
+
+void PartitionedCollection::forget_owner(const std::vector<std::string>& pks, const std::string& value) {
+  std::lock_guard<std::mutex> lock(owners_mutex_);
+  for (auto& pk : pks) {
+    auto it = owners_.find(pk);
+    if (it == owners_.end() || it->second != value) continue;
+    owners_.erase(it);
+    append_owner(pk, "");
+  }
+  if (!owners_log_.flush())
+    throw fs::filesystem_error("write pk map", fs::path(path_) / kOwnersFile, std::make_error_code(std::errc::io_error));
+  compact_owners();
+}
+
+std::vector<PartitionedCollection::Partition> PartitionedCollection::owners(
+    const std::vector<std::string>& pks) const {
+  PartitionPruning pruning;
+  pruning.pinned = true;
+  {
+    std::set<std::string> values;
+    std::lock_guard<std::mutex> lock(owners_mutex_);
+    for (auto& pk : pks) {
+      auto it = owners_.find(pk);
+      if (it != owners_.end()) values.insert(it->second);
+    }
+    pruning.values.assign(values.begin(), values.end());
+  }
+  return targets(pruning);
+}
+
+std::vector<PartitionedCollection::Partition> PartitionedCollection::partitions() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return {partitions_.begin(), partitions_.end()};
+}
+
+zvec::Collection::Ptr PartitionedCollection::find(const std::string& value) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = partitions_.find(value);
+  return it == partitions_.end() ? nullptr : it->second;
+}
+
+std::vector<PartitionedCollection::Partition> PartitionedCollection::targets(
+    const PartitionPruning& pruning) const {
+  if (!pruning.pinned) return partitions();
+  std::vector<Partition> out;
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto& v : pruning.values) {
+    auto it = partitions_.find(v);
+    if (it != partitions_.end()) out.push_back(*it);
+  }
+  return out;
+}
+
+zvec::Status PartitionedCollection::get_or_create(const std::string& value,
+                                                  zvec::Collection::Ptr& collection) {
+  // Held across CreateAndOpen so concurrent writers create a partition once
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = partitions_.find(value);
+  if (it != partitions_.end()) {
+    collection = it->second;
+    return zvec::Status();
+  }
+  auto schema = template_->Schema();
+  if (!schema.has_value()) return schema.error();
+  auto created = zvec::Collection::CreateAndOpen(partition_dir(value), schema.value(), options_);
+  if (!created.has_value()) return created.error();
+  collection = register_collection(std::move(created.value()));
+  partitions_.emplace(value, collection);
+  return zvec::Status();
+}
+
+bool PartitionedCollection::partition_value(const zvec::Doc& doc, std::string& value) const {
+  if (!doc.has(key_) || doc.is_null(key_)) return false;
+  switch (key_type_) {
+    case zvec::DataType::STRING: {
+      auto v = doc.get<std::string>(key_);
+      if (v) value = *v;
+      return v.has_value();
+    }
+    case zvec::DataType::INT32: {
+      auto v = doc.get<int32_t>(key_);
+      if (v) value = std::to_string(*v);
+      return v.has_value();
+    }
+    case zvec::DataType::INT64: {
+      auto v = doc.get<int64_t>(key_);
+      if (v) value = std::to_string(*v);
+      return v.has_value();
+    }
+    case zvec::DataType::UINT32: {
+      auto v = doc.get<uint32_t>(key_);
+      if (v) value = std::to_string(*v);
+      return v.has_value();
+    }
+    default: {
+      auto v = doc.get<uint64_t>(key_);
+      if (v) value = std::to_string(*v);
+      return v.has_value();
+    }
+  }
+}
+
+zvec::Status PartitionedCollection::held_elsewhere(const std::vector<std::string>& pks,
+                                                   const std::string& value,
+                                                   std::map<std::string, std::string>& holders) const {
+  std::map<std::string, std::vector<std::string>> by_owner;
+  {
+    std::lock_guard<std::mutex> lock(owners_mutex_);
+    for (auto& pk : pks) {
+      auto it = owners_.find(pk);
+      if (it != owners_.end() && it->second != value) by_owner[it->second].push_back(pk);
+    }
+  }
+  std::vector<std::pair<Partition, std::vector<std::string>>> checks;
+  for (auto& [owner, owned] : by_owner) {
+    if (auto collection = find(owner)) checks.push_back({{owner, collection}, std::move(owned)});
+  }
+
+  std::vector<zvec::Status> errors(checks.size());
+  std::vector<std::map<std::string, zvec::Doc::Ptr>> per(checks.size());
+  parallel_for(checks.size(), thread_count(0), [&](size_t, size_t t) {
+    auto result = checks[t].first.second->Fetch(checks[t].second);
+    if (result.has_value()) per[t] = std::move(result.value());
+    else errors[t] = result.error();
+  });
+  zvec::Status error = first_error(errors);
+  if (!error.ok()) return error;
+  for (size_t t = 0; t < checks.size(); t++) {
+    for (auto& [pk, doc] : per[t]) {
+      if (doc) holders[pk] = checks[t].first.first;
+    }
+  }
+  return zvec::Status();
+}
+
+zvec::Status PartitionedCollection::write(zvec::Operator op, std::vector<zvec::Doc>& docs,
+                                          std::vector<zvec::Status>& statuses) {
+  // Group rows by partition, keeping each row's original index
+  std::map<std::string, std::vector<size_t>> groups;
+  statuses.assign(docs.size(), zvec::Status());
+  std::string value;
+  for (size_t i = 0; i < docs.size(); i++) {
+    if (partition_value(docs[i], value)) groups[value].push_back(i);
+    else statuses[i] = zvec::Status::InvalidArgument("missing partition key " + key_);
+  }
+
+  for (auto& [v, group] : groups) {
+    zvec::Collection::Ptr collection;
+    zvec::Status status = get_or_create(v, collection);
+    if (!status.ok()) return status;
+
+    // A pk lives in one partition, and the pk map says which. Insert and
+    // update refuse rows whose pk another partition holds (an update carries
+    // only some fields, so it cannot move a row); upsert moves it, deleting
+    // the old row below.
+    std::vector<std::string> pks;
+    for (size_t i : group) pks.push_back(docs[i].pk());
+    std::map<std::string, std::string> holders;
+    status = held_elsewhere(pks, v, holders);
+    if (!status.ok()) return status;
+
+    std::vector<size_t> rows;
+    std::vector<std::string> written;
+    for (size_t g = 0; g < group.size(); g++) {
+      size_t i = group[g];
+      auto held = holders.find(pks[g]);
+      if (op == zvec::Operator::UPSERT || held == holders.end()) {
+        rows.push_back(i);
+        written.push_back(pks[g]);
+      } else if (op == zvec::Operator::INSERT) {
+        statuses[i] = zvec::Status::AlreadyExists("pk exists in partition " + held->second);
+      } else {
+        statuses[i] = zvec::Status::InvalidArgument("update cannot change the partition key (pk is in partition " +
+                                                    held->second + "); upsert the whole doc to move it");
+      }
+    }
+    if (rows.empty()) continue;
+    record_owner(written, v);
+
+    std::vector<zvec::Doc> batch;
+    batch.reserve(rows.size());
+    for (size_t i : rows) batch.push_back(std::move(docs[i]));
+    auto result = op == zvec::Operator::INSERT ? collection->Insert(batch)
+                : op == zvec::Operator::UPSERT ? collection->Upsert(batch)
+                                               : collection->Update(batch);
+    for (size_t r = 0; r < rows.size(); r++) docs[rows[r]] = std::move(batch[r]);
+    if (!result.has_value()) return result.error();
+    for (size_t r = 0; r < rows.size(); r++) statuses[rows[r]] = result.value()[r];
+
+    if (op == zvec::Operator::UPSERT && !holders.empty()) {
+      // Written first, so a failure here leaves a duplicate, never a loss
+      std::map<std::string, std::vector<std::string>> moved;
+      for (size_t r = 0; r < rows.size(); r++) {
+        auto held = holders.find(written[r]);
+        if (statuses[rows[r]].ok() && held != holders.end()) moved[held->second].push_back(written[r]);
+      }
+      for (auto& [owner, owned] : moved) {
+        auto old = find(owner);
+        if (!old) continue;
+        auto deleted = old->Delete(owned);
+        if (!deleted.has_value()) return deleted.error();
+      }
+    }
+  }
+  return zvec::Status();
+}
+
+zvec::Status PartitionedCollection::remove(const std::vector<std::string>& pks,
+                                           const std::vector<Partition>& targets,
+                                           std::vector<zvec::Status>& statuses) {
+  // A pk counts as deleted if any targeted partition held it
+  std::vector<zvec::Status> errors(targets.size());
+  std::vector<std::vector<zvec::Status>> per(targets.size());
+  parallel_for(targets.size(), thread_count(0), [&](size_t, size_t t) {
+    auto result = targets[t].second->Delete(pks);
+    if (result.has_value()) per[t] = std::move(result.value());
+    else errors[t] = result.error();
+  });
+  zvec::Status error = first_error(errors);
+  if (!error.ok()) return error;
+
+  statuses.assign(pks.size(), zvec::Status::NotFound("no partition holds this pk"));
+  for (size_t t = 0; t < targets.size(); t++) {
+    std::vector<std::string> deleted;
+    for (size_t i = 0; i < per[t].size(); i++) {
+      if (!per[t][i].ok()) continue;
+      statuses[i] = per[t][i];
+      deleted.push_back(pks[i]);
+    }
+    forget_owner(deleted, targets[t].first);
+  }
+  return zvec::Status();
+}
+
+zvec::Status PartitionedCollection::fetch(const std::vector<std::string>& pks,
+                                          const std::vector<Partition>& targets,
+                                          std::map<std::string, zvec::Doc::Ptr>& docs) const {
+  std::vector<zvec::Status> errors(targets.size());
+  std::vector<std::map<std::string, zvec::Doc::Ptr>> per(targets.size());
+  parallel_for(targets.size(), thread_count(0), [&](size_t, size_t t) {
+    auto result = targets[t].second->Fetch(pks);
+    if (result.has_value()) per[t] = std::move(result.value());
+    else errors[t] = result.error();
+  });
+  zvec::Status error = first_error(errors);
+  if (!error.ok()) return error;
+  for (auto& found : per) {
+    for (auto& [pk, doc] : found) {
+      if (doc) docs[pk] = doc;
+    }
+  }
+  return zvec::Status();
+}
+
+bool PartitionedCollection::higher_is_closer(const std::string& field) const {
+  auto schema = template_->Schema();
+  if (!schema.has_value()) return false;
+  const zvec::FieldSchema* fs = schema.value().get_field(field);
+  if (!fs) return false;
+  auto params = std::dynamic_pointer_cast<zvec::VectorIndexParams>(fs->index_params());
+  return params && params->metric_type() == zvec::MetricType::IP;
+}
+
+zvec::Status PartitionedCollection::query(const zvec::VectorQuery& query,
+                                          std::vector<zvec::Doc::Ptr>& docs) const {
+  PartitionPruning pruning = prune_partitions(query.filter_, key_, key_type_);
+  auto parts = targets(pruning);
+
+  // Pinned partitions hold only pinned values, so the key conjuncts can go
+  zvec::VectorQuery q = query;
+  q.filter_ = pruning.residual;
+
+  std::vector<zvec::Status> errors(parts.size());
+  std::vector<std::vector<zvec::Doc::Ptr>> per(parts.size());
+  parallel_for(parts.size(), thread_count(0), [&](size_t, size_t t) {
+    auto result = parts[t].second->Query(q);
+    if (result.has_value()) per[t] = std::move(result.value());
+    else errors[t] = result.error();
+  });
+  zvec::Status error = first_error(errors);
+  if (!error.ok()) return error;
+
+  docs.clear();
+  for (auto& list : per) docs.insert(docs.end(), list.begin(), list.end());
+  if (parts.size() > 1) {
+    bool descending = higher_is_closer(query.field_name_);
+    std::stable_sort(docs.begin(), docs.end(), [&](const zvec::Doc::Ptr& a, const zvec::Doc::Ptr& b) {
+      return descending ? a->score() > b->score() : a->score() < b->score();
+    });
+    if (query.topk_ > 0 && docs.size() > static_cast<size_t>(query.topk_)) docs.resize(query.topk_);
+  }
+  return zvec::Status();
+}
+
+zvec::Status PartitionedCollection::delete_by_filter(const std::string& filter) {
+  PartitionPruning pruning = prune_partitions(filter, key_, key_type_);
+  // Pinning the key and nothing else removes whole partitions
+  if (pruning.pinned && pruning.residual.empty()) {
+    for (auto& v : pruning.values) {
+      bool dropped = false;
+      zvec::Status status = drop_partition(v, dropped);
+      if (!status.ok()) return status;
+    }
+    return zvec::Status();
+  }
+  auto parts = targets(pruning);
+  std::vector<zvec::Status> errors(parts.size());
+  parallel_for(parts.size(), thread_count(0), [&](size_t, size_t t) {
+    errors[t] = parts[t].second->DeleteByFilter(pruning.residual);
+  });
+  return first_error(errors);
+}
+
+zvec::Status PartitionedCollection::drop_partition(const std::string& value, bool& dropped) {
+  zvec::Collection::Ptr collection;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = partitions_.find(value);
+    dropped = it != partitions_.end();
+    if (!dropped) return zvec::Status();
+    collection = std::move(it->second);
+    partitions_.erase(it);
+  }
+  return collection->Destroy();
+}
+
+}  // namespace zvec_rb
+
+using PartitionedCollection = zvec_rb::PartitionedCollection;
+
+static zvec::CollectionOptions options_from(Rice::Object opts_obj) {
+  zvec::CollectionOptions opts;
+  if (!opts_obj.is_nil()) {
+    opts = Rice::detail::From_Ruby<zvec::CollectionOptions>().convert(opts_obj.value());
+  }
+  return opts;
+}
+
+static std::vector<std::string> pks_from(Rice::Array ruby_pks) {
+  std::vector<std::string> pks;
+  pks.reserve(ruby_pks.size());
+  for (size_t i = 0; i < ruby_pks.size(); i++) {
+    pks.push_back(Rice::detail::From_Ruby<std::string>().convert(ruby_pks[i].value()));
+  }
+  return pks;
+}
+
+// Partitions named by partition: (a value or Array of values), or the ones
+// the pk map places pks in
+static std::vector<PartitionedCollection::Partition> named_targets(const PartitionedCollection& pc,
+                                                                   const std::vector<std::string>& pks,
+                                                                   Rice::Object partition) {
+  if (partition.is_nil()) return pc.owners(pks);
+  zvec_rb::PartitionPruning pruning;
+  pruning.pinned = true;
+  VALUE v = partition.value();
+  VALUE list = RB_TYPE_P(v, T_ARRAY) ? v : rb_ary_new_from_values(1, &v);
+  for (long i = 0; i < RARRAY_LEN(list); i++) {
+    VALUE s = rb_obj_as_string(rb_ary_entry(list, i));
+    pruning.values.emplace_back(RSTRING_PTR(s), RSTRING_LEN(s));
+  }
+  return pc.targets(pruning);
+}
+
+static zvec_rb::WriteResult partitioned_write(PartitionedCollection& pc, zvec::Operator op,
+                                              Rice::Object ruby_docs) {
+  zvec_rb::WriteDocs write(ruby_docs);
+  std::vector<zvec::Doc>& docs = write.get();
+  std::vector<zvec::Status> statuses;
+  zvec::Status status;
+  zvec_rb::without_gvl([&] { status = pc.write(op, docs, statuses); });
+  zvec_rb::throw_if_error(status);
+  return zvec_rb::WriteResult::from_statuses(statuses, [&](size_t i) { return docs[i].pk(); });
+}
+
+static Rice::Array docs_to_ruby(const std::vector<zvec::Doc::Ptr>& docs) {
+  Rice::Array arr;
+  for (auto& d : docs) {
+    zvec::Doc copy(*d);
+    arr.push(Rice::Object(Rice::detail::To_Ruby<zvec::Doc>().convert(std::move(copy))));
+  }
+  return arr;
+}
+
+void init_zvec_partition(Rice::Module& m) {
+  Rice::define_class_under<PartitionedCollection>(m, "PartitionedCollection")
+    .define_singleton_function("create", [](const std::string& path,
+                                            const zvec::CollectionSchema& schema,
+                                            const std::string& partition_key,
+                                            Rice::Object opts_obj) -> PartitionedCollection* {
+      zvec::Status status;
+      auto* pc = PartitionedCollection::create(path, schema, partition_key, options_from(opts_obj), status);
+      zvec_rb::throw_if_error(status);
+      return pc;
+    },
+      Rice::Return().takeOwnership(),
+      Rice::Arg("path"),
+      Rice::Arg("schema"),
+      Rice::Arg("partition_key"),
+      Rice::Arg("options") = Rice::Object(Qnil))
+    .define_singleton_function("open", [](const std::string& path,
+                                          Rice::Object opts_obj) -> PartitionedCollection* {
+      zvec::Status status;
+      auto* pc = PartitionedCollection::open(path, options_from(opts_obj), status);
+      zvec_rb::throw_if_error(status);
+      return pc;
+    },
+      Rice::Return().takeOwnership(),
+      Rice::Arg("path"),
+      Rice::Arg("options") = Rice::Object(Qnil))
+
+    // Metadata
+    .define_method("path", &PartitionedCollection::path)
+    .define_method("partition_key", &PartitionedCollection::key)
+    .define_method("schema", [](const PartitionedCollection& pc) {
+      return zvec_rb::unwrap_result(pc.template_collection()->Schema());
+    })
+    .define_method("partitions", [](const PartitionedCollection& pc) {
+      Rice::Array arr;
+      for (auto& [value, collection] : pc.partitions()) arr.push(value);
+      return arr;
+    })
+    // The engine collection behind one partition value, or nil
+    .define_method("partition", [](const PartitionedCollection& pc, Rice::Object value) -> Rice::Object {
+      VALUE s = rb_obj_as_string(value.value());
+      auto collection = pc.find(std::string(RSTRING_PTR(s), RSTRING_LEN(s)));
+      if (!collection) return Rice::Object(Qnil);
+      return Rice::Object(Rice::detail::To_Ruby<zvec::Collection::Ptr>().convert(collection));
+    })
+    // Partition values a filter would touch, or nil when it touches them all
+    .define_method("pruned_partitions", [](const PartitionedCollection& pc,
+                                           const std::string& filter) -> Rice::Object {
+      auto pruning = zvec_rb::prune_partitions(filter, pc.key(), pc.key_type());
+      if (!pruning.pinned) return Rice::Object(Qnil);
+      Rice::Array arr;
+      for (auto& [value, collection] : pc.targets(pruning)) arr.push(value);
+      return arr;
+    })
+    .define_method("doc_count", [](const PartitionedCollection& pc) {
+      uint64_t total = 0;
+      for (auto& [value, collection] : pc.partitions()) {
+        total += zvec_rb::unwrap_result(collection->Stats()).doc_count;
+      }
+      return total;
+    })
+
+    // DML
+    .define_method("insert", [](PartitionedCollection& pc, Rice::Object docs) {
+      return partitioned_write(pc, zvec::Operator::INSERT, docs);
+    })
+    .define_method("upsert", [](PartitionedCollection& pc, Rice::Object docs) {
+      return partitioned_write(pc, zvec::Operator::UPSERT, docs);
+    })
+    .define_method("update", [](PartitionedCollection& pc, Rice::Object docs) {
+      return partitioned_write(pc, zvec::Operator::UPDATE, docs);
+    })
+    .define_method("delete", [](PartitionedCollection& pc, Rice::Array ruby_pks, Rice::Object partition) {
+      auto pks = pks_from(ruby_pks);
+      auto targets = named_targets(pc, pks, partition);
+      std::vector<zvec::Status> statuses;
+      zvec::Status status;
+      zvec_rb::without_gvl([&] { status = pc.remove(pks, targets, statuses); });
+      zvec_rb::throw_if_error(status);
+      return zvec_rb::WriteResult::from_statuses(statuses, [&](size_t i) { return pks[i]; });
+    },
+      Rice::Arg("pks"),
+      Rice::Arg("partition") = Rice::Object(Qnil))
+    .define_method("delete_by_filter", [](PartitionedCollection& pc, const std::string& filter) {
+      zvec_rb::prune_partitions(filter, pc.key(), pc.key_type());
+      zvec::Status status;
+      zvec_rb::without_gvl([&] { status = pc.delete_by_filter(filter); });
+      zvec_rb::throw_if_error(status);
+    })
+    .define_method("drop_partition", [](PartitionedCollection& pc, Rice::Object value) {
+      VALUE s = rb_obj_as_string(value.value());
+      std::string v(RSTRING_PTR(s), RSTRING_LEN(s));
+      bool dropped = false;
+      zvec::Status status;
+      zvec_rb::without_gvl([&] { status = pc.drop_partition(v, dropped); });
+      zvec_rb::throw_if_error(status);
+      return dropped;
+    })
+
+    // DQL
+    .define_method("query", [](const PartitionedCollection& pc, const zvec::VectorQuery& vq) {
+      // Tokenize (and reject bad filters) while the GVL is held
+      zvec_rb::prune_partitions(vq.filter_, pc.key(), pc.key_type());
+      std::vector<zvec::Doc::Ptr> docs;
+      zvec::Status status;
+      zvec_rb::timed_query([&] { status = pc.query(vq, docs); });
+      zvec_rb::throw_if_error(status);
+      return docs_to_ruby(docs);
+    })
+    .define_method("fetch", [](const PartitionedCollection& pc, Rice::Array ruby_pks,
+                               Rice::Object partition) -> Rice::Object {
+      auto pks = pks_from(ruby_pks);
+      auto targets = named_targets(pc, pks, partition);
+      std::map<std::string, zvec::Doc::Ptr> docs;
+      zvec::Status status;
+      zvec_rb::without_gvl([&] { status = pc.fetch(pks, targets, docs); });
+      zvec_rb::throw_if_error(status);
+      VALUE rb_hash = rb_hash_new();
+      for (auto& [k, v] : docs) {
+        zvec::Doc copy = *v;
+        rb_hash_aset(rb_hash, Rice::detail::To_Ruby<std::string>().convert(k),
+                     Rice::detail::To_Ruby<zvec::Doc>().convert(copy));
+      }
+      return Rice::Object(rb_hash);
+    },
+      Rice::Arg("pks"),
+      Rice::Arg("partition") = Rice::Object(Qnil))
+
+    // Lifecycle and DDL, applied to the template and every partition
+    .define_method("flush", [](PartitionedCollection& pc) {
+      zvec::Status status;
+      zvec_rb::without_gvl([&] {
+        status = pc.each_collection([](zvec::Collection& c) { return c.Flush(); });
+      });
+      zvec_rb::throw_if_error(status);
+    })
+    .define_method("optimize", [](PartitionedCollection& pc, int concurrency) {
+      zvec::Status status = zvec_rb::scheduled_maintenance(concurrency, [&](int n) {
+        return pc.each_collection([&](zvec::Collection& c) { return c.Optimize(zvec::OptimizeOptions{n}); });
+      });
+      zvec_rb::throw_if_error(status);
+    },
+      Rice::Arg("concurrency") = 0)
+    .define_method("create_index", [](PartitionedCollection& pc, const std::string& column,
+                                      zvec::IndexParams::Ptr params, int concurrency) {
+      zvec::Status status = zvec_rb::scheduled_maintenance(concurrency, [&](int n) {
+        return pc.each_collection([&](zvec::Collection& c) {
+          return c.CreateIndex(column, params, zvec::CreateIndexOptions{n});
+        });
+      });
+      zvec_rb::throw_if_error(status);
+    },
+      Rice::Arg("column"),
+      Rice::Arg("params"),
+      Rice::Arg("concurrency") = 0)
+    .define_method("drop_index", [](PartitionedCollection& pc, const std::string& column) {
+      zvec::Status status;
+      zvec_rb::without_gvl([&] {
+        status = pc.each_collection([&](zvec::Collection& c) { return c.DropIndex(column); });
+      });
+      zvec_rb::throw_if_error(status);
+    })
+    .define_method("destroy!", [](PartitionedCollection& pc) {
+      zvec::Status status;
+      zvec_rb::without_gvl([&] {
+        status = pc.each_collection([](zvec::Collection& c) { return c.Destroy(); });
+        if (status.ok()) std::filesystem::remove_all(pc.path());
+      });
+      zvec_rb::throw_if_error(status);
+    });
+}
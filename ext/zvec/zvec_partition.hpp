@@ -0,0 +1,120 @@
+#pragma once
+
+#include "zvec_common.hpp"
+#include "zvec_write_result.hpp"
+
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+
+namespace zvec_rb {
+
+// Partition values a filter pins through its top-level AND conjuncts
+// (`key = v`, `v = key`, `key IN (v, ...)`), and the filter with those
+// conjuncts removed. Values are canonical strings (see partition_value).
+struct PartitionPruning {
+  bool pinned = false;
+  std::vector<std::string> values;
+  std::string residual;
+};
+
+PartitionPruning prune_partitions(const std::string& filter, const std::string& key,
+                                  zvec::DataType key_type);
+
+// A collection split on a scalar partition key. Each partition value is its
+// own engine collection (own segments and vector indexes) under
+// <path>/partitions, created on first write. Filters that pin the key only
+// touch the pinned partitions, and dropping a partition destroys its
+// collection instead of tombstoning its rows. <path>/template is an empty
+// collection that persists the schema for partitions created later.
+class PartitionedCollection {
+ public:
+  using Partition = std::pair<std::string, zvec::Collection::Ptr>;
+
+  // Engine failures are returned in status; argument errors throw
+  static PartitionedCollection* create(const std::string& path, const zvec::CollectionSchema& schema,
+                                       const std::string& key, const zvec::CollectionOptions& options,
+                                       zvec::Status& status);
+  static PartitionedCollection* open(const std::string& path, const zvec::CollectionOptions& options,
+                                     zvec::Status& status);
+
+  PartitionedCollection(const PartitionedCollection&) = delete;
+  PartitionedCollection& operator=(const PartitionedCollection&) = delete;
+
+  const std::string& path() const { return path_; }
+  const std::string& key() const { return key_; }
+  zvec::DataType key_type() const { return key_type_; }
+  const zvec::Collection::Ptr& template_collection() const { return template_; }
+
+  std::vector<Partition> partitions() const;
+  zvec::Collection::Ptr find(const std::string& value) const;
+  // Partitions for a pruning result (all partitions when not pinned)
+  std::vector<Partition> targets(const PartitionPruning& pruning) const;
+
+  // Canonical partition value of a doc; false when the key is missing
+  bool partition_value(const zvec::Doc& doc, std::string& value) const;
+
+  // The engine calls below take no Ruby objects and may run without the GVL
+  zvec::Status write(zvec::Operator op, std::vector<zvec::Doc>& docs,
+                     std::vector<zvec::Status>& statuses);
+  zvec::Status remove(const std::vector<std::string>& pks, const std::vector<Partition>& targets,
+                      std::vector<zvec::Status>& statuses);
+  zvec::Status fetch(const std::vector<std::string>& pks, const std::vector<Partition>& targets,
+                     std::map<std::string, zvec::Doc::Ptr>& docs) const;
+  // Partitions the pk map places pks in (pks it does not know are left out)
+  std::vector<Partition> owners(const std::vector<std::string>& pks) const;
+  zvec::Status query(const zvec::VectorQuery& query, std::vector<zvec::Doc::Ptr>& docs) const;
+  zvec::Status delete_by_filter(const std::string& filter);
+  zvec::Status drop_partition(const std::string& value, bool& dropped);
+  // Apply fn to the template and every partition, stopping at the first error
+  template <typename F>
+  zvec::Status each_collection(F&& fn) {
+    zvec::Status status = fn(*template_);
+    for (auto& [value, collection] : partitions()) {
+      if (!status.ok()) break;
+      status = fn(*collection);
+    }
+    return status;
+  }
+
+ private:
+  PartitionedCollection(std::string path, zvec::CollectionOptions options,
+                        zvec::Collection::Ptr template_collection, std::string key,
+                        zvec::DataType key_type);
+
+  std::string partition_dir(const std::string& value) const;
+  zvec::Status get_or_create(const std::string& value, zvec::Collection::Ptr& collection);
+  // Partition the pk map names for each of pks, where that is not value and
+  // the partition still holds the pk (entries go stale after
+  // delete_by_filter and drop_partition, so they are checked with one fetch)
+  zvec::Status held_elsewhere(const std::vector<std::string>& pks, const std::string& value,
+                              std::map<std::string, std::string>& holders) const;
+  // pk map upkeep. record_owner points pks at value; forget_owner drops
+  // the entries of pks that still point at value. Both append to the log,
+  // which is rewritten once most of its lines are superseded.
+  void load_owners();
+  void record_owner(const std::vector<std::string>& pks, const std::string& value);
+  void forget_owner(const std::vector<std::string>& pks, const std::string& value);
+  void append_owner(const std::string& pk, const std::string& value);
+  void compact_owners();
+  bool higher_is_closer(const std::string& field) const;
+
+  std::string path_;
+  zvec::CollectionOptions options_;
+  zvec::Collection::Ptr template_;
+  std::string key_;
+  zvec::DataType key_type_;
+
+  mutable std::mutex mutex_;
+  std::map<std::string, zvec::Collection::Ptr> partitions_;
+
+  // pk -> partition value, so a write checks only the partition a pk was
+  // last written to. Persisted as an append-only log in <path>/pk_partitions.
+  mutable std::mutex owners_mutex_;
+  std::unordered_map<std::string, std::string> owners_;
+  std::ofstream owners_log_;
+  size_t owners_logged_ = 0;
+};
+
+}  // namespace zvec_rb
@@ -0,0 +1,111 @@
+#include "zvec_pool.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace zvec_rb {
+
+// One run() call. Queued copies hold it by shared_ptr, so they can be
+// dequeued after the caller has returned and find it closed. The caller
+// works through the items itself, so a pool whose threads are gone (e.g. in
+// a forked child) only loses parallelism.
+struct Job {
+  const std::function<void(size_t)>* fn;
+  std::mutex mutex;
+  std::condition_variable done;
+  size_t next_worker = 1;
+  size_t active = 0;
+  bool closed = false;
+};
+
+struct WorkerPool::Impl {
+  std::mutex mutex;
+  std::condition_variable ready;
+  std::deque<std::shared_ptr<Job>> queue;
+  std::vector<std::thread> threads;
+  bool stopping = false;
+
+  void loop() {
+    for (;;) {
+      std::shared_ptr<Job> job;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        ready.wait(lock, [&] { return stopping || !queue.empty(); });
+        if (queue.empty()) return;
+        job = std::move(queue.front());
+        queue.pop_front();
+      }
+      size_t worker;
+      {
+        std::lock_guard<std::mutex> lock(job->mutex);
+        if (job->closed) continue;
+        worker = job->next_worker++;
+        job->active++;
+      }
+      try {
+        (*job->fn)(worker);
+      } catch (...) {
+        // parallel_for catches inside its job; anything else is dropped
+        // rather than escaping a pool thread
+      }
+      std::lock_guard<std::mutex> lock(job->mutex);
+      if (--job->active == 0) job->done.notify_all();
+    }
+  }
+};
+
+WorkerPool& WorkerPool::instance() {
+  static WorkerPool pool(std::max(1u, std::thread::hardware_concurrency()));
+  return pool;
+}
+
+WorkerPool::WorkerPool(size_t size) : impl_(new Impl), size_(size) {
+  for (size_t i = 0; i < size; i++) impl_->threads.emplace_back([this] { impl_->loop(); });
+}
+
+WorkerPool::~WorkerPool() {
+  {
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    impl_->stopping = true;
+    impl_->queue.clear();
+  }
+  impl_->ready.notify_all();
+  for (auto& t : impl_->threads) t.join();
+}
+
+void WorkerPool::run(size_t helpers, const std::function<void(size_t)>& fn) {
+  helpers = std::min(helpers, size_);
+  auto job = std::make_shared<Job>();
+  job->fn = &fn;
+  if (helpers > 0) {
+    {
+      std::lock_guard<std::mutex> lock(impl_->mutex);
+      for (size_t i = 0; i < helpers; i++) impl_->queue.push_back(job);
+    }
+    if (helpers == 1) impl_->ready.notify_one();
+    else impl_->ready.notify_all();
+  }
+  auto finish = [&] {
+    std::unique_lock<std::mutex> lock(job->mutex);
+    job->closed = true;
+    job->done.wait(lock, [&] { return job->active == 0; });
+  };
+  try {
+    fn(0);
+  } catch (...) {
+    finish();
+    throw;
+  }
+  finish();
+}
+
+size_t thread_count(size_t concurrency) {
+  size_t limit = WorkerPool::instance().size() + 1;
+  return concurrency ? std::min(concurrency, limit) : limit - 1;
+}
+
+}  // namespace zvec_rb
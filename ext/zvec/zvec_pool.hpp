@@ -0,0 +1,66 @@
+#pragma once
+
+// Process-wide worker threads for native fan-out (partition queries, dedup
+// self-queries, brute-force tiles, snapshot file placement, ...). Plain C++
+// with no Ruby dependency; nothing run on it may touch Ruby objects.
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+
+namespace zvec_rb {
+
+class WorkerPool {
+ public:
+  // One thread per core, started on first use
+  static WorkerPool& instance();
+
+  size_t size() const { return size_; }
+
+  // Run job(worker) on the calling thread as worker 0 and on up to helpers
+  // pool threads as workers 1..helpers. Returns once every copy that started
+  // has returned; copies still queued when the caller finishes are dropped,
+  // so a busy pool never blocks progress (and nested calls cannot deadlock).
+  void run(size_t helpers, const std::function<void(size_t)>& job);
+
+  ~WorkerPool();
+
+ private:
+  explicit WorkerPool(size_t size);
+  struct Impl;
+  std::unique_ptr<Impl> impl_;
+  size_t size_;
+};
+
+// Threads for a concurrency: option. 0 means one per core; larger requests
+// are capped at the pool size plus the calling thread.
+size_t thread_count(size_t concurrency);
+
+// Run fn(worker, item) for items [0, n) on up to `threads` workers of the
+// shared pool, worker indexes < threads, so per-worker state can be indexed
+// by worker. Items are handed out one at a time, which balances uneven work.
+// The first exception thrown by fn stops the hand-out and is rethrown here
+// once every worker has returned.
+template <typename F>
+void parallel_for(size_t n, size_t threads, F&& fn) {
+  if (n == 0) return;
+  threads = std::max<size_t>(1, std::min(threads, n));
+  std::atomic<size_t> next{0};
+  std::atomic<bool> failed{false};
+  std::exception_ptr error;
+  std::atomic_flag error_set = ATOMIC_FLAG_INIT;
+  WorkerPool::instance().run(threads - 1, [&](size_t w) {
+    try {
+      for (size_t i = next++; i < n && !failed; i = next++) fn(w, i);
+    } catch (...) {
+      if (!error_set.test_and_set()) error = std::current_exception();
+      failed = true;
+    }
+  });
+  if (error) std::rethrow_exception(error);
+}
+
+}  // namespace zvec_rb
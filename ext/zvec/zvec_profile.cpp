@@ -0,0 +1,314 @@
+#include "zvec_profile.hpp"
+#include "zvec_cursor.hpp"
+#include "zvec_filter.hpp"
+#include "zvec_stats.hpp"
+
+#include <algorithm>
+
+namespace zvec_rb {
+
+using Clock = std::chrono::steady_clock;
+
+static std::mutex g_ratios_mutex;
+static FilterRatios g_ratios = [] {
+  zvec::GlobalConfig::ConfigData defaults{};
+  return FilterRatios{defaults.invert_to_forward_scan_ratio, defaults.brute_force_by_keys_ratio};
+}();
+
+FilterRatios filter_ratios() {
+  std::lock_guard<std::mutex> lock(g_ratios_mutex);
+  return g_ratios;
+}
+
+void record_filter_ratios(const zvec::GlobalConfig::ConfigData& config) {
+  std::lock_guard<std::mutex> lock(g_ratios_mutex);
+  g_ratios = FilterRatios{config.invert_to_forward_scan_ratio, config.brute_force_by_keys_ratio};
+}
+
+// --- FilterHistory ---
+
+static constexpr double kHistoryWeight = 0.3;  // weight of the newest sample
+static constexpr size_t kHistoryShapes = 1024;
+
+void FilterHistory::record(const std::string& shape, double selectivity) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (entries_.size() >= kHistoryShapes && !entries_.count(shape)) entries_.clear();
+  Entry& e = entries_[shape];
+  e.selectivity = e.samples == 0 ? selectivity : e.selectivity + kHistoryWeight * (selectivity - e.selectivity);
+  e.samples++;
+}
+
+uint64_t FilterHistory::lookup(const std::string& shape, double& selectivity) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = entries_.find(shape);
+  if (it == entries_.end()) return 0;
+  selectivity = it->second.selectivity;
+  return it->second.samples;
+}
+
+// --- Planning ---
+
+static const char* index_type_name(zvec::IndexType type) {
+  switch (type) {
+    case zvec::IndexType::HNSW: return "HNSW";
+    case zvec::IndexType::IVF: return "IVF";
+    case zvec::IndexType::FLAT: return "FLAT";
+    default: return "NONE";
+  }
+}
+
+// Filter text with literal values replaced, so runs that differ only in
+// their values share one history entry
+static std::string filter_shape(const FilterPlan& plan) {
+  std::string out;
+  for (const auto& t : plan.tokens) {
+    if (!out.empty()) out += ' ';
+    bool literal = t.kind == FilterToken::Kind::NUMBER || t.kind == FilterToken::Kind::STRING;
+    out += literal ? "?" : t.text;
+  }
+  return out;
+}
+
+static std::string ratio_text(double v) {
+  char buf[32];
+  std::snprintf(buf, sizeof(buf), "%.4g", v);
+  return buf;
+}
+
+// Filter-only pages without vectors or fields; stops once limit is reached
+static zvec::Status count_matches(const zvec::Collection& collection, const std::string& filter,
+                                  uint64_t limit, uint64_t& matched, bool& capped) {
+  zvec::VectorQuery q;
+  q.filter_ = filter;
+  q.output_fields_ = std::vector<std::string>();
+  uint32_t batch = static_cast<uint32_t>(std::min<uint64_t>(std::max<uint64_t>(limit, 1), 4096));
+  ScanPager pager(std::move(q), batch);
+  std::vector<zvec::Doc::Ptr> docs;
+  bool last = false;
+  matched = 0;
+  while (!last && matched < limit) {
+    zvec::Status status = pager.next(collection, docs, last);
+    if (!status.ok()) return status;
+    matched += docs.size();
+  }
+  capped = !last;
+  return zvec::Status();
+}
+
+// Decide the filter and search strategies from the selectivity we have, and
+// estimate the search work from the index and query parameters
+static void plan_search(QueryProfile& p, const zvec::FieldSchema* fs, const zvec::QueryParams::Ptr& qp) {
+  double s = p.actual_selectivity >= 0 ? p.actual_selectivity : p.estimated_selectivity;
+  bool filtered = !p.filter.empty();
+  std::vector<std::string> reasons;
+
+  if (!filtered) {
+    p.filter_strategy = "none";
+  } else if (!p.unindexed_fields.empty()) {
+    p.filter_strategy = "forward_scan";
+    reasons.push_back("no inverted index on " + p.unindexed_fields.front());
+  } else if (s < 0) {
+    p.filter_strategy = "unknown";
+    reasons.push_back("selectivity unknown (profile the query or explain with count: true)");
+  } else if (s > p.ratios.invert_to_forward_scan_ratio) {
+    p.filter_strategy = "forward_scan";
+    reasons.push_back("selectivity " + ratio_text(s) + " > invert_to_forward_scan_ratio " +
+                      ratio_text(p.ratios.invert_to_forward_scan_ratio));
+  } else {
+    p.filter_strategy = "inverted_index";
+    reasons.push_back("selectivity " + ratio_text(s) + " <= invert_to_forward_scan_ratio " +
+                      ratio_text(p.ratios.invert_to_forward_scan_ratio));
+  }
+
+  uint64_t n = p.doc_count;
+  uint64_t keys = filtered && s >= 0 ? static_cast<uint64_t>(s * static_cast<double>(n) + 0.5) : n;
+  auto index_type = fs ? fs->index_type() : zvec::IndexType::UNDEFINED;
+  p.index_type = index_type_name(index_type);
+  p.estimated_nodes_visited = p.estimated_lists_visited = 0;
+  p.refiner = qp && qp->is_using_refiner();
+
+  if (filtered && s >= 0 && s < p.ratios.brute_force_by_keys_ratio) {
+    p.search_strategy = "brute_force_by_keys";
+    p.estimated_distance_computations = keys;
+    reasons.push_back("selectivity " + ratio_text(s) + " < brute_force_by_keys_ratio " +
+                      ratio_text(p.ratios.brute_force_by_keys_ratio));
+  } else if (qp && qp->is_linear()) {
+    p.search_strategy = "linear";
+    p.estimated_distance_computations = keys;
+    reasons.push_back("QueryParams#is_linear");
+  } else if (index_type == zvec::IndexType::HNSW) {
+    p.search_strategy = "graph";
+    auto hq = std::dynamic_pointer_cast<zvec::HnswQueryParams>(qp);
+    p.ef = std::max<int>(hq ? hq->ef() : zvec::HnswQueryParams().ef(), static_cast<int>(p.topk));
+    // A filtered beam has to expand about 1/s nodes per match it keeps
+    double expand = filtered && s > 0 ? 1.0 / s : 1.0;
+    p.estimated_nodes_visited = std::min<uint64_t>(n, static_cast<uint64_t>(p.ef * expand));
+    auto hp = std::dynamic_pointer_cast<zvec::HnswIndexParams>(fs->index_params());
+    uint64_t fanout = 2 * static_cast<uint64_t>(hp ? hp->m() : 16);
+    p.estimated_distance_computations = std::min<uint64_t>(n, p.estimated_nodes_visited * fanout);
+  } else if (index_type == zvec::IndexType::IVF) {
+    p.search_strategy = "ivf";
+    auto ip = std::dynamic_pointer_cast<zvec::IVFIndexParams>(fs->index_params());
+    auto iq = std::dynamic_pointer_cast<zvec::IVFQueryParams>(qp);
+    p.n_list = static_cast<uint32_t>(std::max(1, ip ? ip->n_list() : 1));
+    p.nprobe = static_cast<uint32_t>(iq ? iq->nprobe() : zvec::IVFQueryParams().nprobe());
+    p.estimated_lists_visited = std::min<uint64_t>(p.nprobe, p.n_list);
+    p.estimated_distance_computations = p.n_list + n * p.estimated_lists_visited / p.n_list;
+  } else {
+    p.search_strategy = "flat";
+    p.estimated_distance_computations = n;
+  }
+
+  if (p.refiner) {
+    float scale = 1;
+    if (auto iq = std::dynamic_pointer_cast<zvec::IVFQueryParams>(qp)) scale = iq->scale_factor();
+    else if (auto fq = std::dynamic_pointer_cast<zvec::FlatQueryParams>(qp)) scale = fq->scale_factor();
+    p.refine_candidates = static_cast<uint64_t>(std::max(1.0f, scale) * p.topk);
+  }
+
+  p.reason.clear();
+  for (const auto& r : reasons) p.reason += (p.reason.empty() ? "" : "; ") + r;
+}
+
+QueryProfile explain_query(const zvec::Collection& collection, CollectionState& state,
+                           const zvec::VectorQuery& query, bool count_filter, uint64_t count_limit) {
+  auto start = Clock::now();
+  QueryProfile p;
+  p.field = query.field_name_;
+  p.topk = static_cast<uint32_t>(std::max(0, query.topk_));
+  p.filter = query.filter_;
+  p.ratios = filter_ratios();
+
+  auto schema = collection.Schema();
+  if (!schema.has_value()) {
+    p.status = schema.error();
+    return p;
+  }
+  const zvec::FieldSchema* fs = schema.value().get_field(query.field_name_);
+  if (!fs) throw std::invalid_argument("Unknown field: " + query.field_name_);
+
+  auto stats = collection.Stats();
+  auto path = collection.Path();
+  if (!stats.has_value() || !path.has_value()) {
+    p.status = stats.has_value() ? path.error() : stats.error();
+    return p;
+  }
+  p.doc_count = stats.value().doc_count;
+  count_segments(path.value(), p.field, schema.value().all_field_names(), p.segments, p.segments_with_field);
+
+  if (!p.filter.empty()) {
+    auto plan = filter_plan(p.filter);
+    p.filter_shape = filter_shape(*plan);
+    p.filter_fields = plan->fields;
+    for (const auto& name : plan->fields) {
+      const zvec::FieldSchema* ff = schema.value().get_field(name);
+      // pk and engine columns are not schema fields
+      if (ff && !ff->has_invert_index()) p.unindexed_fields.push_back(name);
+    }
+    double estimate = 0;
+    p.estimate_samples = state.filter_history->lookup(p.filter_shape, estimate);
+    if (p.estimate_samples > 0) p.estimated_selectivity = estimate;
+  }
+  p.plan_ms = ms_since(start);
+
+  if (count_filter && !p.filter.empty()) {
+    auto counted = Clock::now();
+    p.status = count_matches(collection, p.filter, count_limit, p.matched, p.matched_capped);
+    p.filter_count_ms = ms_since(counted);
+    if (!p.status.ok()) return p;
+    if (p.doc_count > 0) {
+      p.actual_selectivity = std::min(1.0, static_cast<double>(p.matched) / static_cast<double>(p.doc_count));
+      if (!p.matched_capped) state.filter_history->record(p.filter_shape, p.actual_selectivity);
+    }
+  }
+
+  plan_search(p, fs, query.query_params_);
+  return p;
+}
+
+bool profile_requested(VALUE vector_query) {
+  return RTEST(rb_attr_get(vector_query, rb_intern("@profile")));
+}
+
+static VALUE g_query_result_class = Qnil;
+
+Rice::Object query_result(Rice::Array docs, QueryProfile profile) {
+  VALUE result = rb_class_new_instance(0, nullptr, g_query_result_class);
+  rb_ary_concat(result, docs.value());
+  VALUE rb_profile = Rice::detail::To_Ruby<QueryProfile>().convert(std::move(profile));
+  rb_ivar_set(result, rb_intern("@profile"), rb_profile);
+  return Rice::Object(result);
+}
+
+}  // namespace zvec_rb
+
+using zvec_rb::QueryProfile;
+
+static Rice::Array strings(const std::vector<std::string>& v) {
+  Rice::Array arr;
+  for (const auto& s : v) arr.push(Rice::String(s));
+  return arr;
+}
+
+// nil for "not known" values stored as negatives
+static Rice::Object known(double v) {
+  return v < 0 ? Rice::Object(Qnil) : Rice::Object(rb_float_new(v));
+}
+
+void init_zvec_profile(Rice::Module& m) {
+  Rice::Class rb_cQueryResult = Rice::define_class_under(m, "QueryResult", rb_cArray)
+    .define_method("profile", [](Rice::Object self) -> Rice::Object {
+      return Rice::Object(rb_attr_get(self.value(), rb_intern("@profile")));
+    });
+  zvec_rb::g_query_result_class = rb_cQueryResult.value();
+
+  Rice::define_class_under<QueryProfile>(m, "QueryProfile")
+    .define_method("executed?", [](const QueryProfile& p) { return p.executed; })
+    .define_method("field", [](const QueryProfile& p) { return p.field; })
+    .define_method("index_type", [](const QueryProfile& p) { return p.index_type; })
+    .define_method("topk", [](const QueryProfile& p) { return p.topk; })
+    .define_method("doc_count", [](const QueryProfile& p) { return p.doc_count; })
+    .define_method("filter", [](const QueryProfile& p) { return p.filter; })
+    .define_method("filter_shape", [](const QueryProfile& p) { return p.filter_shape; })
+    .define_method("filter_fields", [](const QueryProfile& p) { return strings(p.filter_fields); })
+    .define_method("unindexed_fields", [](const QueryProfile& p) { return strings(p.unindexed_fields); })
+    .define_method("filter_strategy", [](const QueryProfile& p) { return p.filter_strategy; })
+    .define_method("invert_to_forward_scan_ratio", [](const QueryProfile& p) {
+      return p.ratios.invert_to_forward_scan_ratio;
+    })
+    .define_method("brute_force_by_keys_ratio", [](const QueryProfile& p) {
+      return p.ratios.brute_force_by_keys_ratio;
+    })
+    .define_method("estimated_selectivity", [](const QueryProfile& p) { return known(p.estimated_selectivity); })
+    .define_method("estimate_samples", [](const QueryProfile& p) { return p.estimate_samples; })
+    .define_method("actual_selectivity", [](const QueryProfile& p) { return known(p.actual_selectivity); })
+    .define_method("matched", [](const QueryProfile& p) { return p.matched; })
+    .define_method("matched_capped?", [](const QueryProfile& p) { return p.matched_capped; })
+    .define_method("search_strategy", [](const QueryProfile& p) { return p.search_strategy; })
+    .define_method("reason", [](const QueryProfile& p) { return p.reason; })
+    .define_method("ef", [](const QueryProfile& p) { return p.ef; })
+    .define_method("n_list", [](const QueryProfile& p) { return p.n_list; })
+    .define_method("nprobe", [](const QueryProfile& p) { return p.nprobe; })
+    .define_method("estimated_nodes_visited", [](const QueryProfile& p) { return p.estimated_nodes_visited; })
+    .define_method("estimated_lists_visited", [](const QueryProfile& p) { return p.estimated_lists_visited; })
+    .define_method("estimated_distance_computations", [](const QueryProfile& p) {
+      return p.estimated_distance_computations;
+    })
+    .define_method("refiner?", [](const QueryProfile& p) { return p.refiner; })
+    .define_method("refine_candidates", [](const QueryProfile& p) { return p.refine_candidates; })
+    .define_method("segments", [](const QueryProfile& p) { return p.segments; })
+    .define_method("segments_with_field", [](const QueryProfile& p) { return p.segments_with_field; })
+    .define_method("plan_ms", [](const QueryProfile& p) { return p.plan_ms; })
+    .define_method("filter_count_ms", [](const QueryProfile& p) { return p.filter_count_ms; })
+    .define_method("search_ms", [](const QueryProfile& p) { return p.search_ms; })
+    .define_method("convert_ms", [](const QueryProfile& p) { return p.convert_ms; })
+    .define_method("total_ms", &QueryProfile::total_ms)
+    .define_method("to_s", [](const QueryProfile& p) -> std::string {
+      char buf[256];
+      std::snprintf(buf, sizeof(buf),
+                    "QueryProfile(%s, filter=%s, search=%s, distances~%llu, search=%.2fms, total=%.2fms)",
+                    p.executed ? "executed" : "plan", p.filter_strategy.c_str(), p.search_strategy.c_str(),
+                    static_cast<unsigned long long>(p.estimated_distance_computations), p.search_ms, p.total_ms());
+      return buf;
+    });
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "zvec_common.hpp"
+
+#include <mutex>
+#include <unordered_map>
+
+namespace zvec_rb {
+
+// Filter thresholds last handed to the engine by Zvec.configure (engine
+// defaults until then). The engine does not report them back.
+struct FilterRatios {
+  float invert_to_forward_scan_ratio = 0;
+  float brute_force_by_keys_ratio = 0;
+};
+FilterRatios filter_ratios();
+void record_filter_ratios(const zvec::GlobalConfig::ConfigData& config);
+
+// Selectivity observed by profiled queries, per filter shape (the filter
+// with its literals replaced by ?). Feeds the estimate in Collection#explain.
+class FilterHistory {
+ public:
+  // Exponentially weighted: recent runs count most
+  void record(const std::string& shape, double selectivity);
+  // Samples recorded for shape; selectivity is set when there are any
+  uint64_t lookup(const std::string& shape, double& selectivity) const;
+
+ private:
+  struct Entry {
+    double selectivity = 0;
+    uint64_t samples = 0;
+  };
+  mutable std::mutex mutex_;
+  std::unordered_map<std::string, Entry> entries_;
+};
+
+// Plan and, once executed, measurements of one vector query. The engine
+// reports neither its filter strategy nor its search counters, so the
+// strategy is derived from the same inputs the engine uses (field indexes,
+// selectivity, the configured ratios) and the work counters are estimates
+// from the index parameters. Phase times and selectivity are measured.
+struct QueryProfile {
+  zvec::Status status;
+  bool executed = false;
+
+  std::string field;
+  std::string index_type;  // HNSW, IVF, FLAT or NONE
+  uint32_t topk = 0;
+  uint64_t doc_count = 0;
+
+  // Filter
+  std::string filter;
+  std::string filter_shape;
+  std::vector<std::string> filter_fields;
+  std::vector<std::string> unindexed_fields;  // no inverted index
+  std::string filter_strategy;                // none, inverted_index, forward_scan or unknown
+  FilterRatios ratios;
+  double estimated_selectivity = -1;  // < 0: no history
+  uint64_t estimate_samples = 0;
+  double actual_selectivity = -1;  // < 0: not counted
+  uint64_t matched = 0;
+  bool matched_capped = false;  // stopped counting at the limit
+
+  // Search (estimated)
+  std::string search_strategy;  // graph, ivf, flat, linear or brute_force_by_keys
+  std::string reason;
+  int ef = 0;
+  uint32_t n_list = 0;
+  uint32_t nprobe = 0;
+  uint64_t estimated_nodes_visited = 0;
+  uint64_t estimated_lists_visited = 0;
+  uint64_t estimated_distance_computations = 0;
+  bool refiner = false;
+  uint64_t refine_candidates = 0;
+
+  // Storage
+  size_t segments = 0;
+  size_t segments_with_field = 0;
+
+  // Phases (ms)
+  double plan_ms = 0;
+  double filter_count_ms = 0;
+  double search_ms = 0;
+  double convert_ms = 0;
+
+  std::vector<zvec::Doc::Ptr> docs;
+
+  double total_ms() const { return plan_ms + filter_count_ms + search_ms + convert_ms; }
+};
+
+// Matches counted before a profile stops and reports a lower bound
+constexpr uint64_t kProfileCountLimit = 100000;
+
+// Build the plan for query from the engine's doc count and the segment
+// directories (a directory walk, nothing more). With count_filter the
+// filter is also run on its own (filter-only pages, no vectors) to measure
+// selectivity, stopping after count_limit matches; a complete count is added
+// to the filter history. Engine errors are returned in status. No Ruby
+// calls; run it without the GVL.
+QueryProfile explain_query(const zvec::Collection& collection, CollectionState& state,
+                           const zvec::VectorQuery& query, bool count_filter, uint64_t count_limit);
+
+// VectorQuery#profile = true (a Ruby ivar; the engine query has no field for it)
+bool profile_requested(VALUE vector_query);
+
+// Wrap docs in a Zvec::QueryResult (an Array) carrying profile
+Rice::Object query_result(Rice::Array docs, QueryProfile profile);
+
+}  // namespace zvec_rb
@@ -0,0 +1,262 @@
+#include "zvec_common.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+using namespace Rice;
+
+namespace zvec_rb {
+
+// Client-side scalar/binary quantizer. Scales are learned once from a sample
+// (symmetric, optionally clipped at a percentile of |x|) and then applied in
+// bulk so stored vectors and queries share one encoding.
+class Quantizer {
+ public:
+  enum class Kind : uint8_t { INT8 = 1, INT4 = 2, BINARY32 = 3, BINARY64 = 4 };
+
+  static Quantizer fit(Kind kind, const std::vector<float>& sample, size_t dim,
+                       bool per_dimension, double percentile) {
+    if (dim == 0 || sample.empty()) throw std::invalid_argument("sample matrix is empty");
+    if (percentile <= 0.0 || percentile > 1.0) throw std::invalid_argument("percentile must be in (0, 1]");
+
+    Quantizer q;
+    q.kind_ = kind;
+    q.dim_ = static_cast<uint32_t>(dim);
+    q.per_dimension_ = per_dimension;
+    size_t rows = sample.size() / dim;
+    size_t slots = per_dimension ? dim : 1;
+
+    if (q.is_binary()) {
+      // Binary codes threshold each dimension at its sample mean
+      q.params_.assign(slots, 0.0f);
+      std::vector<double> sums(slots, 0.0);
+      for (size_t r = 0; r < rows; r++)
+        for (size_t d = 0; d < dim; d++) sums[per_dimension ? d : 0] += sample[r * dim + d];
+      double count = per_dimension ? rows : rows * dim;
+      for (size_t s = 0; s < slots; s++) q.params_[s] = static_cast<float>(sums[s] / count);
+      return q;
+    }
+
+    // Scalar codes: scale = clip(|x|) / qmax, clip at the requested percentile
+    float qmax = kind == Kind::INT8 ? 127.0f : 7.0f;
+    q.params_.assign(slots, 1.0f);
+    std::vector<float> mags;
+    for (size_t s = 0; s < slots; s++) {
+      mags.clear();
+      for (size_t r = 0; r < rows; r++) {
+        if (per_dimension) {
+          mags.push_back(std::fabs(sample[r * dim + s]));
+        } else {
+          for (size_t d = 0; d < dim; d++) mags.push_back(std::fabs(sample[r * dim + d]));
+        }
+      }
+      size_t k = static_cast<size_t>(std::ceil(percentile * mags.size())) - 1;
+      std::nth_element(mags.begin(), mags.begin() + k, mags.end());
+      float clip = mags[k];
+      q.params_[s] = clip > 0.0f ? clip / qmax : 1.0f;
+    }
+    return q;
+  }
+
+  // Encode rows of a dense float matrix. Scalar codes produce one int8 per
+  // element (the Doc packs INT4 itself); binary codes produce uint32/uint64
+  // words with bit i set when x_i is above its threshold.
+  std::string encode(const float* x, size_t rows) const {
+    std::string out(rows * encoded_size(), '\0');
+    for (size_t r = 0; r < rows; r++) {
+      encode_row(x + r * dim_, &out[r * encoded_size()]);
+    }
+    return out;
+  }
+
+  size_t encoded_size() const {
+    switch (kind_) {
+      case Kind::BINARY32: return ((dim_ + 31) / 32) * sizeof(uint32_t);
+      case Kind::BINARY64: return ((dim_ + 63) / 64) * sizeof(uint64_t);
+      default: return dim_;
+    }
+  }
+
+  std::string dump() const {
+    std::string buf("ZVQ1");
+    buf.push_back(static_cast<char>(kind_));
+    buf.push_back(per_dimension_ ? 1 : 0);
+    buf.append(reinterpret_cast<const char*>(&dim_), sizeof(dim_));
+    buf.append(reinterpret_cast<const char*>(params_.data()), params_.size() * sizeof(float));
+    return buf;
+  }
+
+  static Quantizer load(const std::string& buf) {
+    const size_t header = 4 + 2 + sizeof(uint32_t);
+    if (buf.size() < header || buf.compare(0, 4, "ZVQ1") != 0)
+      throw std::invalid_argument("not a serialized Zvec::Quantizer");
+    uint8_t kind = static_cast<uint8_t>(buf[4]);
+    if (kind < static_cast<uint8_t>(Kind::INT8) || kind > static_cast<uint8_t>(Kind::BINARY64))
+      throw std::invalid_argument("unknown Zvec::Quantizer kind " + std::to_string(kind));
+    Quantizer q;
+    q.kind_ = static_cast<Kind>(kind);
+    q.per_dimension_ = buf[5] != 0;
+    std::memcpy(&q.dim_, buf.data() + 6, sizeof(q.dim_));
+    size_t slots = q.per_dimension_ ? q.dim_ : 1;
+    if (buf.size() != header + slots * sizeof(float))
+      throw std::invalid_argument("truncated Zvec::Quantizer data");
+    q.params_.resize(slots);
+    std::memcpy(q.params_.data(), buf.data() + header, slots * sizeof(float));
+    return q;
+  }
+
+  Kind kind() const { return kind_; }
+  uint32_t dimension() const { return dim_; }
+  bool per_dimension() const { return per_dimension_; }
+  const std::vector<float>& params() const { return params_; }
+  bool is_binary() const { return kind_ == Kind::BINARY32 || kind_ == Kind::BINARY64; }
+
+  zvec::DataType data_type() const {
+    switch (kind_) {
+      case Kind::INT8: return zvec::DataType::VECTOR_INT8;
+      case Kind::INT4: return zvec::DataType::VECTOR_INT4;
+      case Kind::BINARY32: return zvec::DataType::VECTOR_BINARY32;
+      default: return zvec::DataType::VECTOR_BINARY64;
+    }
+  }
+
+ private:
+  float param(size_t d) const { return params_[per_dimension_ ? d : 0]; }
+
+  void encode_row(const float* x, char* out) const {
+    if (is_binary()) {
+      size_t word_bits = kind_ == Kind::BINARY32 ? 32 : 64;
+      std::memset(out, 0, encoded_size());
+      for (size_t d = 0; d < dim_; d++) {
+        if (x[d] <= param(d)) continue;
+        if (word_bits == 32) {
+          reinterpret_cast<uint32_t*>(out)[d / 32] |= uint32_t(1) << (d % 32);
+        } else {
+          reinterpret_cast<uint64_t*>(out)[d / 64] |= uint64_t(1) << (d % 64);
+        }
+      }
+      return;
+    }
+
+    float lo = kind_ == Kind::INT8 ? -127.0f : -8.0f;
+    float hi = kind_ == Kind::INT8 ? 127.0f : 7.0f;
+    for (size_t d = 0; d < dim_; d++) {
+      float v = std::nearbyint(x[d] / param(d));
+      out[d] = static_cast<char>(static_cast<int8_t>(std::min(hi, std::max(lo, v))));
+    }
+  }
+
+  Kind kind_ = Kind::INT8;
+  uint32_t dim_ = 0;
+  bool per_dimension_ = true;
+  // Per-dimension (or single global) scale for scalar codes, threshold for binary
+  std::vector<float> params_;
+};
+
+}  // namespace zvec_rb
+
+using Quantizer = zvec_rb::Quantizer;
+
+static Quantizer::Kind quantizer_kind(Rice::Object type) {
+  VALUE s = rb_obj_as_string(type.value());
+  std::string name(RSTRING_PTR(s), RSTRING_LEN(s));
+  if (name == "int8") return Quantizer::Kind::INT8;
+  if (name == "int4") return Quantizer::Kind::INT4;
+  if (name == "binary" || name == "binary32") return Quantizer::Kind::BINARY32;
+  if (name == "binary64") return Quantizer::Kind::BINARY64;
+  throw std::invalid_argument("quantizer type must be :int8, :int4, :binary32 or :binary64");
+}
+
+static const char* quantizer_kind_name(Quantizer::Kind kind) {
+  switch (kind) {
+    case Quantizer::Kind::INT8: return "int8";
+    case Quantizer::Kind::INT4: return "int4";
+    case Quantizer::Kind::BINARY32: return "binary32";
+    default: return "binary64";
+  }
+}
+
+// Read a dense float matrix from an Array of Arrays or a packed float32 String
+// (row-major, dimension floats per row)
+static std::vector<float> read_matrix(Rice::Object matrix, size_t& dim) {
+  std::vector<float> out;
+  VALUE v = matrix.value();
+
+  if (RB_TYPE_P(v, T_STRING)) {
+    size_t len = static_cast<size_t>(RSTRING_LEN(v));
+    if (dim == 0 || len % (dim * sizeof(float)) != 0)
+      throw std::invalid_argument("packed matrix length must be a multiple of dimension * 4 bytes");
+    out.resize(len / sizeof(float));
+    std::memcpy(out.data(), RSTRING_PTR(v), len);
+    return out;
+  }
+
+  Rice::Array rows(matrix);
+  for (size_t r = 0; r < rows.size(); r++) {
+    Rice::Array row(rows[r]);
+    if (dim == 0) dim = row.size();
+    if (row.size() != dim) throw std::invalid_argument("matrix rows must all have the same dimension");
+    for (size_t d = 0; d < dim; d++) {
+      out.push_back(Rice::detail::From_Ruby<float>().convert(row[d].value()));
+    }
+  }
+  return out;
+}
+
+void init_zvec_quantize(Rice::Module& m) {
+  Rice::define_class_under<Quantizer>(m, "Quantizer")
+    .define_singleton_function("fit", [](Rice::Object sample, Rice::Object type,
+                                         bool per_dimension, double percentile,
+                                         uint32_t dimension) {
+      size_t dim = dimension;
+      auto data = read_matrix(sample, dim);
+      return Quantizer::fit(quantizer_kind(type), data, dim, per_dimension, percentile);
+    },
+      Rice::Arg("sample"),
+      Rice::Arg("type") = Rice::Object(rb_id2sym(rb_intern("int8"))),
+      Rice::Arg("per_dimension") = true,
+      Rice::Arg("percentile") = 1.0,
+      Rice::Arg("dimension") = (uint32_t)0)
+    .define_singleton_function("load", [](const std::string& data) {
+      return Quantizer::load(data);
+    })
+    .define_method("type", [](const Quantizer& q) {
+      return Rice::Symbol(quantizer_kind_name(q.kind()));
+    })
+    .define_method("dimension", &Quantizer::dimension)
+    .define_method("per_dimension?", &Quantizer::per_dimension)
+    .define_method("data_type", &Quantizer::data_type)
+    .define_method("params", [](const Quantizer& q) {
+      Rice::Array arr;
+      for (auto v : q.params()) arr.push(v);
+      return arr;
+    })
+    // Encode a matrix; returns one packed String per row, ready for
+    // Doc#set_packed_vector with #data_type
+    .define_method("quantize", [](const Quantizer& q, Rice::Object matrix) {
+      size_t dim = q.dimension();
+      auto data = read_matrix(matrix, dim);
+      if (dim != q.dimension()) throw std::invalid_argument("matrix dimension does not match quantizer");
+      size_t rows = data.size() / dim;
+      std::string codes = q.encode(data.data(), rows);
+      size_t width = q.encoded_size();
+      Rice::Array result;
+      for (size_t r = 0; r < rows; r++) {
+        result.push(Rice::Object(rb_str_new(codes.data() + r * width, static_cast<long>(width))));
+      }
+      return result;
+    })
+    // Encode a single vector (e.g. a query) to one packed String
+    .define_method("quantize_vector", [](const Quantizer& q, Rice::Array vector) -> Rice::Object {
+      if (vector.size() != q.dimension()) throw std::invalid_argument("vector dimension does not match quantizer");
+      std::vector<float> x(vector.size());
+      for (size_t i = 0; i < vector.size(); i++) x[i] = Rice::detail::From_Ruby<float>().convert(vector[i].value());
+      std::string code = q.encode(x.data(), 1);
+      return Rice::Object(rb_str_new(code.data(), static_cast<long>(code.size())));
+    })
+    .define_method("dump", [](const Quantizer& q) -> Rice::Object {
+      std::string buf = q.dump();
+      return Rice::Object(rb_str_new(buf.data(), static_cast<long>(buf.size())));
+    });
+}
@@ -0,0 +1,115 @@
+#include "zvec_refine.hpp"
+#include "zvec_kernels.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+using namespace Rice;
+
+namespace zvec_rb {
+
+using Clock = std::chrono::steady_clock;
+
+RefineResult refine_query(const zvec::Collection& collection, zvec::VectorQuery coarse,
+                          const std::string& refine_field, const std::vector<float>& query,
+                          uint32_t topk, uint32_t overfetch, zvec::MetricType metric) {
+  RefineResult result;
+
+  // Stage 1: candidates from the cheap field
+  auto start = Clock::now();
+  coarse.topk_ = static_cast<int>(topk * overfetch);
+  auto queried = collection.Query(coarse);
+  if (!queried.has_value()) {
+    result.status = queried.error();
+    return result;
+  }
+  auto candidates = std::move(queried.value());
+  result.candidate_count = candidates.size();
+  result.coarse_ms = ms_since(start);
+
+  // Stage 2: full-precision vectors for every candidate in one Fetch
+  start = Clock::now();
+  std::vector<std::string> pks;
+  pks.reserve(candidates.size());
+  for (auto& d : candidates) pks.push_back(d->pk());
+  auto fetched_result = collection.Fetch(pks);
+  if (!fetched_result.has_value()) {
+    result.status = fetched_result.error();
+    return result;
+  }
+  auto fetched = std::move(fetched_result.value());
+  result.fetch_ms = ms_since(start);
+
+  // Stage 3: exact scores, keep the best topk
+  start = Clock::now();
+  const size_t dim = query.size();
+  float query_norm = std::sqrt(kernels::dot(query.data(), query.data(), dim));
+  bool descending = metric == zvec::MetricType::IP;
+
+  std::vector<std::pair<float, size_t>> scored;
+  scored.reserve(candidates.size());
+  for (size_t i = 0; i < candidates.size(); i++) {
+    auto it = fetched.find(pks[i]);
+    // Deleted between the two stages
+    if (it == fetched.end() || !it->second) continue;
+    auto vec = it->second->get<std::vector<float>>(refine_field);
+    if (!vec || vec->size() != dim) continue;
+
+    const float* x = vec->data();
+    float score;
+    switch (metric) {
+      case zvec::MetricType::IP:
+        score = kernels::dot(query.data(), x, dim);
+        break;
+      case zvec::MetricType::COSINE: {
+        float denom = query_norm * std::sqrt(kernels::dot(x, x, dim));
+        score = denom > 0.0f ? 1.0f - kernels::dot(query.data(), x, dim) / denom : 1.0f;
+        break;
+      }
+      default:
+        score = kernels::l2_sqr(query.data(), x, dim);
+        break;
+    }
+    scored.emplace_back(descending ? -score : score, i);
+  }
+
+  size_t keep = std::min<size_t>(topk, scored.size());
+  std::partial_sort(scored.begin(), scored.begin() + keep, scored.end());
+  result.docs.reserve(keep);
+  for (size_t r = 0; r < keep; r++) {
+    auto& doc = candidates[scored[r].second];
+    doc->set_score(descending ? -scored[r].first : scored[r].first);
+    result.docs.push_back(doc);
+  }
+  result.rescore_ms = ms_since(start);
+  return result;
+}
+
+}  // namespace zvec_rb
+
+void init_zvec_refine(Rice::Module& m) {
+  Rice::define_class_under<zvec_rb::RefineResult>(m, "RefineResult")
+    .define_method("docs", [](const zvec_rb::RefineResult& r) {
+      Rice::Array arr;
+      for (auto& d : r.docs) {
+        zvec::Doc copy(*d);
+        arr.push(Rice::Object(Rice::detail::To_Ruby<zvec::Doc>().convert(std::move(copy))));
+      }
+      return arr;
+    })
+    .define_method("size", [](const zvec_rb::RefineResult& r) { return r.docs.size(); })
+    .define_method("candidate_count", [](const zvec_rb::RefineResult& r) { return r.candidate_count; })
+    .define_method("coarse_ms", [](const zvec_rb::RefineResult& r) { return r.coarse_ms; })
+    .define_method("fetch_ms", [](const zvec_rb::RefineResult& r) { return r.fetch_ms; })
+    .define_method("rescore_ms", [](const zvec_rb::RefineResult& r) { return r.rescore_ms; })
+    .define_method("total_ms", &zvec_rb::RefineResult::total_ms)
+    .define_method("to_s", [](const zvec_rb::RefineResult& r) -> std::string {
+      char buf[160];
+      std::snprintf(buf, sizeof(buf),
+                    "RefineResult(size=%zu, candidates=%zu, coarse=%.2fms, fetch=%.2fms, rescore=%.2fms)",
+                    r.docs.size(), r.candidate_count, r.coarse_ms, r.fetch_ms, r.rescore_ms);
+      return buf;
+    });
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "zvec_common.hpp"
+
+namespace zvec_rb {
+
+// Outcome of a two-stage query: the re-scored top-k plus per-stage timings
+struct RefineResult {
+  zvec::Status status;
+  std::vector<zvec::Doc::Ptr> docs;
+  size_t candidate_count = 0;
+  double coarse_ms = 0;
+  double fetch_ms = 0;
+  double rescore_ms = 0;
+
+  double total_ms() const { return coarse_ms + fetch_ms + rescore_ms; }
+};
+
+// Over-fetch topk * overfetch candidates with the coarse query (typically a
+// compact INT8/binary field), fetch each candidate's FP32 vector from
+// refine_field and re-score exactly against query. Scores follow the metric:
+// squared L2 and 1 - cosine ascend, inner product descends. Runs without the
+// GVL, so query must already be converted and engine errors are returned in
+// status rather than raised.
+RefineResult refine_query(const zvec::Collection& collection, zvec::VectorQuery coarse,
+                          const std::string& refine_field, const std::vector<float>& query,
+                          uint32_t topk, uint32_t overfetch, zvec::MetricType metric);
+
+}  // namespace zvec_rb
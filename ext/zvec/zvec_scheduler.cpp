@@ -0,0 +1,89 @@
+#include "zvec_scheduler.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+namespace zvec_rb {
+
+Scheduler& Scheduler::instance() {
+  static Scheduler scheduler;
+  return scheduler;
+}
+
+void Scheduler::configure(const Settings& settings) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  settings_ = settings;
+}
+
+Scheduler::Settings Scheduler::settings() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return settings_;
+}
+
+void Scheduler::record_query(double ms) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  samples_[next_] = Sample{Clock::now(), static_cast<float>(ms)};
+  next_ = (next_ + 1) % kSamples;
+  filled_ = std::min(filled_ + 1, kSamples);
+}
+
+double Scheduler::p99_locked(Clock::time_point now, size_t* count) const {
+  auto window = std::chrono::duration_cast<Clock::duration>(
+    std::chrono::duration<double>(settings_.window_s));
+  std::vector<float> recent;
+  recent.reserve(filled_);
+  for (size_t i = 0; i < filled_; i++) {
+    if (now - samples_[i].at <= window) recent.push_back(samples_[i].ms);
+  }
+  if (count) *count = recent.size();
+  if (recent.empty()) return 0;
+  size_t k = static_cast<size_t>(std::ceil(0.99 * recent.size())) - 1;
+  std::nth_element(recent.begin(), recent.begin() + k, recent.end());
+  return recent[k];
+}
+
+Scheduler::Stats Scheduler::stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Stats s;
+  s.query_p99_ms = p99_locked(Clock::now(), &s.window_samples);
+  s.maintenance_runs = maintenance_runs_;
+  s.maintenance_waits = maintenance_waits_;
+  s.maintenance_wait_ms = maintenance_wait_ms_;
+  return s;
+}
+
+int Scheduler::maintenance_concurrency(int requested) const {
+  double share = settings().maintenance_cpu_share;
+  if (share <= 0) return requested;
+  int cores = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+  int cap = std::max(1, static_cast<int>(share * cores));
+  // 0 asks the engine for its default (all optimize threads)
+  return requested <= 0 ? cap : std::min(requested, cap);
+}
+
+void Scheduler::wait_for_maintenance() {
+  auto start = Clock::now();
+  bool waited = false;
+  while (true) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      double limit = settings_.pause_p99_ms;
+      auto now = Clock::now();
+      bool timed_out = now - start >= std::chrono::duration<double>(settings_.max_wait_s);
+      if (limit <= 0 || timed_out || p99_locked(now, nullptr) <= limit) {
+        maintenance_runs_++;
+        if (waited) {
+          maintenance_waits_++;
+          maintenance_wait_ms_ += std::chrono::duration<double, std::milli>(now - start).count();
+        }
+        return;
+      }
+    }
+    waited = true;
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+}
+
+}  // namespace zvec_rb
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "zvec_common.hpp"
+
+#include <chrono>
+#include <mutex>
+
+namespace zvec_rb {
+
+// Binding-side arbitration between latency-sensitive queries and background
+// maintenance (optimize, index builds, column rewrites). Query latencies seen
+// by the bindings feed a rolling p99; maintenance entry points cap their
+// concurrency to a CPU share and wait while that p99 is over a threshold.
+class Scheduler {
+ public:
+  struct Settings {
+    double maintenance_cpu_share = 0;  // 0 = uncapped
+    double pause_p99_ms = 0;           // 0 = never pause
+    double window_s = 10;
+    double max_wait_s = 60;
+  };
+
+  struct Stats {
+    double query_p99_ms = 0;
+    size_t window_samples = 0;
+    uint64_t maintenance_runs = 0;
+    uint64_t maintenance_waits = 0;
+    double maintenance_wait_ms = 0;
+  };
+
+  static Scheduler& instance();
+
+  void configure(const Settings& settings);
+  Settings settings() const;
+
+  void record_query(double ms);
+  Stats stats() const;
+
+  // Concurrency to pass to the engine for a maintenance call
+  int maintenance_concurrency(int requested) const;
+
+  // Block until query p99 is under the pause threshold (or max_wait_s has
+  // passed). Call without the GVL.
+  void wait_for_maintenance();
+
+ private:
+  using Clock = std::chrono::steady_clock;
+  struct Sample {
+    Clock::time_point at;
+    float ms;
+  };
+  static constexpr size_t kSamples = 4096;
+
+  double p99_locked(Clock::time_point now, size_t* count) const;
+
+  mutable std::mutex mutex_;
+  Settings settings_;
+  Sample samples_[kSamples];
+  size_t next_ = 0;
+  size_t filled_ = 0;
+  uint64_t maintenance_runs_ = 0;
+  uint64_t maintenance_waits_ = 0;
+  double maintenance_wait_ms_ = 0;
+};
+
+// Run a query-path engine call without the GVL and record its latency
+template <typename F>
+void timed_query(F&& fn) {
+  auto start = std::chrono::steady_clock::now();
+  without_gvl(std::forward<F>(fn));
+  Scheduler::instance().record_query(ms_since(start));
+}
+
+// Run a maintenance engine call without the GVL, after the scheduler lets it
+// start. fn receives the concurrency to use; its Status is returned for the
+// caller to raise.
+template <typename F>
+zvec::Status scheduled_maintenance(int requested, F&& fn) {
+  Scheduler& scheduler = Scheduler::instance();
+  int concurrency = scheduler.maintenance_concurrency(requested);
+  zvec::Status status;
+  without_gvl([&] {
+    scheduler.wait_for_maintenance();
+    status = fn(concurrency);
+  });
+  return status;
+}
+
+}  // namespace zvec_rb
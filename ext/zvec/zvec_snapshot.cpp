@@ -0,0 +1,295 @@
+#include "zvec_snapshot.hpp"
+#include "zvec_pool.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+
+#include <sys/stat.h>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#elif defined(__APPLE__)
+#include <sys/clonefile.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace zvec_rb {
+
+using Clock = std::chrono::steady_clock;
+
+const char* const kSnapshotManifest = ".zvec-snapshot";
+
+WriteGate::WriteGate(const zvec::Collection& collection)
+    : state_(collection_state(collection)), lock_(state_->snapshot_gate, std::try_to_lock) {
+  if (!lock_.owns_lock()) without_gvl([&] { lock_.lock(); });
+}
+
+namespace {
+
+// size and mtime can survive a rewrite (same length, within one mtime tick,
+// or mtime restored), so a file is only reused from a base when its inode
+// and ctime match too: replacing a file changes the inode, and any write or
+// utime call bumps the ctime. Manifests from before ino/ctime were recorded
+// (version 1) load with ino 0, which never matches.
+struct FileEntry {
+  std::string rel;
+  uint64_t size = 0;
+  int64_t mtime = 0;
+  uint64_t ino = 0;
+  int64_t ctime = 0;
+};
+
+int64_t mtime_of(const fs::path& p) {
+  return static_cast<int64_t>(fs::last_write_time(p).time_since_epoch().count());
+}
+
+FileEntry file_entry(const fs::path& path, std::string rel) {
+  struct stat st;
+  if (::stat(path.c_str(), &st) != 0)
+    throw fs::filesystem_error("stat", path, std::error_code(errno, std::generic_category()));
+#if defined(__APPLE__)
+  const struct timespec& ct = st.st_ctimespec;
+#else
+  const struct timespec& ct = st.st_ctim;
+#endif
+  return FileEntry{std::move(rel), static_cast<uint64_t>(st.st_size), mtime_of(path),
+                   static_cast<uint64_t>(st.st_ino),
+                   static_cast<int64_t>(ct.tv_sec) * 1000000000 + ct.tv_nsec};
+}
+
+bool unchanged_since(const FileEntry& base, const FileEntry& now) {
+  return base.ino != 0 && base.ino == now.ino && base.ctime == now.ctime &&
+         base.size == now.size && base.mtime == now.mtime;
+}
+
+// Copy-on-write clone. False when the file system (or platform) cannot do it.
+bool clone_file(const fs::path& from, const fs::path& to) {
+#if defined(__linux__)
+  int in = ::open(from.c_str(), O_RDONLY | O_CLOEXEC);
+  if (in < 0) return false;
+  int out = ::open(to.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+  if (out < 0) {
+    ::close(in);
+    return false;
+  }
+  bool ok = ::ioctl(out, FICLONE, in) == 0;
+  ::close(out);
+  ::close(in);
+  if (!ok) ::unlink(to.c_str());
+  return ok;
+#elif defined(__APPLE__)
+  return ::clonefile(from.c_str(), to.c_str(), 0) == 0;
+#else
+  (void)from;
+  (void)to;
+  return false;
+#endif
+}
+
+std::unordered_map<std::string, FileEntry> read_manifest(const fs::path& dir) {
+  std::ifstream in(dir / kSnapshotManifest);
+  if (!in) throw std::invalid_argument("not a snapshot (no manifest): " + dir.string());
+  std::unordered_map<std::string, FileEntry> out;
+  std::string line;
+  std::getline(in, line);
+  bool with_identity = line != "zvec-snapshot 1";
+  while (std::getline(in, line)) {
+    std::istringstream row(line);
+    FileEntry e;
+    if (!(row >> e.size >> e.mtime)) continue;
+    if (with_identity && !(row >> e.ino >> e.ctime)) continue;
+    row.get();  // tab before the path, which may contain spaces
+    std::getline(row, e.rel);
+    out[e.rel] = e;
+  }
+  return out;
+}
+
+void write_manifest(const fs::path& dir, const std::vector<FileEntry>& files) {
+  std::ofstream out(dir / kSnapshotManifest, std::ios::trunc);
+  out << "zvec-snapshot 2\n";
+  for (const auto& f : files)
+    out << f.size << '\t' << f.mtime << '\t' << f.ino << '\t' << f.ctime << '\t' << f.rel << '\n';
+  if (!out.flush()) throw fs::filesystem_error("write manifest", dir, std::make_error_code(std::errc::io_error));
+}
+
+// Mirror the directory tree of src in dest and list its regular files
+std::vector<FileEntry> scan(const fs::path& src, const fs::path& dest) {
+  std::vector<FileEntry> files;
+  for (auto it = fs::recursive_directory_iterator(src); it != fs::recursive_directory_iterator(); ++it) {
+    fs::path rel = fs::relative(it->path(), src);
+    if (it->is_directory()) {
+      fs::create_directories(dest / rel);
+    } else if (it->is_regular_file() && rel != kSnapshotManifest) {
+      files.push_back(file_entry(it->path(), rel.string()));
+    }
+  }
+  return files;
+}
+
+// Place every file in dest on concurrency threads (0: one per core). base
+// may be empty. Without allow_copy, a file that can be neither linked nor
+// cloned is an error. Returns the first error; the caller removes the
+// partial directory.
+zvec::Status place_files(const fs::path& src, const fs::path& dest, const fs::path& base,
+                         const std::unordered_map<std::string, FileEntry>& base_files,
+                         const std::vector<FileEntry>& files, bool allow_copy, uint32_t concurrency,
+                         SnapshotStats& stats) {
+  // Per-worker counts, summed at the end
+  struct Counts {
+    size_t linked = 0, cloned = 0, copied = 0;
+    uint64_t bytes_copied = 0;
+  };
+  size_t threads = thread_count(concurrency);
+  std::vector<Counts> counts(threads);
+  std::mutex mutex;
+  std::string error;
+  std::atomic<bool> failed{false};
+  auto fail = [&](std::string message) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (error.empty()) error = std::move(message);
+    failed = true;
+  };
+
+  parallel_for(files.size(), threads, [&](size_t w, size_t i) {
+    if (failed) return;
+    const FileEntry& f = files[i];
+    Counts& c = counts[w];
+    fs::path to = dest / f.rel;
+    std::error_code ec;
+    auto prev = base_files.find(f.rel);
+    if (prev != base_files.end() && unchanged_since(prev->second, f)) {
+      fs::create_hard_link(base / f.rel, to, ec);
+      if (!ec) {
+        c.linked++;
+        return;
+      }
+      ec.clear();
+    }
+    if (clone_file(src / f.rel, to)) {
+      c.cloned++;
+      return;
+    }
+    if (!allow_copy) {
+      fail("cannot reflink " + f.rel + " on this file system; pass copy: true to copy it with writes blocked");
+      return;
+    }
+    fs::copy_file(src / f.rel, to, fs::copy_options::overwrite_existing, ec);
+    if (ec) {
+      fail("copy " + f.rel + ": " + ec.message());
+      return;
+    }
+    c.copied++;
+    c.bytes_copied += f.size;
+  });
+
+  for (const auto& c : counts) {
+    stats.linked += c.linked;
+    stats.cloned += c.cloned;
+    stats.copied += c.copied;
+    stats.bytes_copied += c.bytes_copied;
+  }
+  stats.files = files.size();
+  for (const auto& f : files) stats.bytes += f.size;
+  return error.empty() ? zvec::Status() : zvec::Status::InvalidArgument(error);
+}
+
+zvec::Status finish_partial(const fs::path& partial, const fs::path& dest, zvec::Status status) {
+  std::error_code ec;
+  if (status.ok()) {
+    fs::rename(partial, dest, ec);
+    if (!ec) return status;
+    status = zvec::Status::InvalidArgument("rename " + partial.string() + " -> " + dest.string() + ": " +
+                                           ec.message());
+  }
+  fs::remove_all(partial, ec);
+  return status;
+}
+
+fs::path start_partial(const fs::path& dest) {
+  if (fs::exists(dest)) throw std::invalid_argument("path already exists: " + dest.string());
+  fs::path partial = dest.string() + ".partial";
+  // Left over from a snapshot or restore that never finished
+  if (fs::exists(partial)) fs::remove_all(partial);
+  fs::create_directories(partial);
+  return partial;
+}
+
+}  // namespace
+
+Rice::Hash snapshot_stats_hash(const SnapshotStats& stats) {
+  Rice::Hash h;
+  h[Rice::Symbol("files")] = stats.files;
+  h[Rice::Symbol("linked")] = stats.linked;
+  h[Rice::Symbol("cloned")] = stats.cloned;
+  h[Rice::Symbol("copied")] = stats.copied;
+  h[Rice::Symbol("bytes")] = stats.bytes;
+  h[Rice::Symbol("bytes_copied")] = stats.bytes_copied;
+  h[Rice::Symbol("pause_ms")] = stats.pause_ms;
+  h[Rice::Symbol("total_ms")] = stats.total_ms;
+  return h;
+}
+
+zvec::Status snapshot_collection(zvec::Collection& collection, CollectionState& state, const std::string& dest,
+                                 const std::string& base, bool allow_copy, uint32_t concurrency,
+                                 SnapshotStats& stats) {
+  auto start = Clock::now();
+  auto path = collection.Path();
+  if (!path.has_value()) return path.error();
+  fs::path src = fs::canonical(path.value());
+  fs::path target = fs::weakly_canonical(dest);
+  if (std::mismatch(src.begin(), src.end(), target.begin(), target.end()).first == src.end())
+    throw std::invalid_argument("snapshot destination is inside the collection: " + dest);
+  std::unordered_map<std::string, FileEntry> base_files;
+  if (!base.empty()) base_files = read_manifest(base);
+  fs::path partial = start_partial(dest);
+
+  zvec::Status status;
+  try {
+    std::unique_lock<std::shared_mutex> gate(state.snapshot_gate);
+    auto paused = Clock::now();
+    status = collection.Flush();
+    if (status.ok()) {
+      state.unflushed_writes = 0;
+      auto files = scan(src, partial);
+      status = place_files(src, partial, base, base_files, files, allow_copy, concurrency, stats);
+      gate.unlock();
+      stats.pause_ms = ms_since(paused);
+      if (status.ok()) write_manifest(partial, files);
+    }
+  } catch (const fs::filesystem_error& e) {
+    status = zvec::Status::InvalidArgument(e.what());
+  }
+  status = finish_partial(partial, dest, status);
+  stats.total_ms = ms_since(start);
+  return status;
+}
+
+zvec::Status restore_snapshot(const std::string& snapshot, const std::string& path, uint32_t concurrency,
+                              SnapshotStats& stats) {
+  auto start = Clock::now();
+  read_manifest(snapshot);  // throws unless snapshot is one
+  fs::path partial = start_partial(path);
+
+  zvec::Status status;
+  try {
+    auto files = scan(snapshot, partial);
+    status = place_files(snapshot, partial, fs::path(), {}, files, true, concurrency, stats);
+  } catch (const fs::filesystem_error& e) {
+    status = zvec::Status::InvalidArgument(e.what());
+  }
+  status = finish_partial(partial, path, status);
+  stats.total_ms = ms_since(start);
+  return status;
+}
+
+}  // namespace zvec_rb
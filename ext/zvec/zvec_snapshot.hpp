@@ -0,0 +1,58 @@
+#pragma once
+
+#include "zvec_common.hpp"
+
+#include <shared_mutex>
+
+namespace zvec_rb {
+
+// Shared hold on a collection's snapshot gate for the length of one engine
+// write. Waits for a running snapshot without the GVL, so other Ruby threads
+// keep going. Keep it inside the op.engine lambda: it must be released before
+// anything can raise.
+class WriteGate {
+ public:
+  explicit WriteGate(const zvec::Collection& collection);
+
+ private:
+  std::shared_ptr<CollectionState> state_;
+  std::shared_lock<std::shared_mutex> lock_;
+};
+
+struct SnapshotStats {
+  size_t files = 0;
+  size_t linked = 0;   // hardlinked from the base snapshot
+  size_t cloned = 0;   // reflinked (copy-on-write clone)
+  size_t copied = 0;   // byte copy
+  uint64_t bytes = 0;
+  uint64_t bytes_copied = 0;
+  double pause_ms = 0;  // writes blocked: flush + capture
+  double total_ms = 0;
+};
+
+// {files:, linked:, cloned:, copied:, bytes:, bytes_copied:, pause_ms:, total_ms:}
+Rice::Hash snapshot_stats_hash(const SnapshotStats& stats);
+
+// Name of the manifest written into every snapshot directory
+extern const char* const kSnapshotManifest;
+
+// Flush the collection and capture its directory into dest with writes
+// paused. Files that are unchanged since base (same size and mtime in its
+// manifest) are hardlinked from base; the rest are reflinked where the file
+// system supports it. Those that cannot be reflinked are byte-copied only
+// with allow_copy, since writes stay blocked for the whole copy; otherwise
+// the snapshot fails. Live files are never hardlinked, so the engine
+// rewriting a file in place cannot change a snapshot. The snapshot is
+// assembled in <dest>.partial and renamed into place. No Ruby calls; run it
+// without the GVL.
+zvec::Status snapshot_collection(zvec::Collection& collection, CollectionState& state, const std::string& dest,
+                                 const std::string& base, bool allow_copy, uint32_t concurrency,
+                                 SnapshotStats& stats);
+
+// Materialize a snapshot as a collection directory at path (which must not
+// exist) by reflinking or copying each file, then renaming from
+// <path>.partial. The snapshot stays intact and can be restored again.
+zvec::Status restore_snapshot(const std::string& snapshot, const std::string& path, uint32_t concurrency,
+                              SnapshotStats& stats);
+
+}  // namespace zvec_rb
@@ -0,0 +1,168 @@
+#include "zvec_stats.hpp"
+
+#include <cctype>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <sys/stat.h>
+
+using namespace Rice;
+
+namespace fs = std::filesystem;
+
+namespace zvec_rb {
+
+// True when name occurs in rel as a whole token: bounded on each side by the
+// ends of the path or by a character that cannot continue an identifier
+static bool has_token(const std::string& rel, const std::string& name) {
+  auto boundary = [](char c) { return !std::isalnum(static_cast<unsigned char>(c)); };
+  for (size_t at = rel.find(name); at != std::string::npos; at = rel.find(name, at + 1)) {
+    size_t end = at + name.size();
+    if ((at == 0 || boundary(rel[at - 1])) && (end == rel.size() || boundary(rel[end]))) return true;
+  }
+  return false;
+}
+
+std::string field_for_path(const std::string& rel, const std::vector<std::string>& fields) {
+  std::string best;
+  for (const auto& name : fields) {
+    if (!name.empty() && name.size() > best.size() && has_token(rel, name)) best = name;
+  }
+  return best;
+}
+
+#if defined(__linux__)
+// Sum Size/Rss of every mapping under root, per file
+static bool read_smaps(const std::string& root,
+                       std::unordered_map<std::string, std::pair<uint64_t, uint64_t>>& out) {
+  std::ifstream smaps("/proc/self/smaps");
+  if (!smaps) return false;
+
+  std::string line;
+  std::pair<uint64_t, uint64_t>* current = nullptr;
+  while (std::getline(smaps, line)) {
+    std::istringstream in(line);
+    std::string first;
+    in >> first;
+    if (first.empty()) continue;
+
+    if (first.back() != ':') {
+      // Mapping header: address perms offset dev inode [path]
+      std::string perms, offset, dev, inode, path;
+      in >> perms >> offset >> dev >> inode;
+      std::getline(in, path);
+      size_t start = path.find_first_not_of(' ');
+      path = start == std::string::npos ? "" : path.substr(start);
+      current = path.compare(0, root.size(), root) == 0 ? &out[path] : nullptr;
+    } else if (current && (first == "Size:" || first == "Rss:")) {
+      uint64_t kb = 0;
+      in >> kb;
+      (first == "Size:" ? current->first : current->second) += kb * 1024;
+    }
+  }
+  return true;
+}
+#endif
+
+DetailedStats read_detailed_stats(const zvec::Collection& collection, const CollectionState& state) {
+  auto start = std::chrono::steady_clock::now();
+  DetailedStats stats;
+  auto engine_stats = unwrap_result(collection.Stats());
+  stats.doc_count = engine_stats.doc_count;
+  stats.index_completeness = engine_stats.index_completeness;
+  stats.max_buffer_size = unwrap_result(collection.Options()).max_buffer_size_;
+  stats.unflushed_writes = state.unflushed_writes.load();
+  stats.deletes_since_optimize = state.deletes_since_optimize.load();
+  stats.fields = unwrap_result(collection.Schema()).all_field_names();
+  stats.root = unwrap_result(collection.Path());
+  stats.collect_ms = ms_since(start);
+  return stats;
+}
+
+void collect_disk_usage(DetailedStats& stats) {
+  auto start = std::chrono::steady_clock::now();
+  std::error_code ec;
+  fs::path root = fs::canonical(stats.root, ec);
+  if (ec) return;
+
+  std::unordered_map<std::string, std::pair<uint64_t, uint64_t>> maps;
+#if defined(__linux__)
+  stats.memory_available = read_smaps(root.string() + "/", maps);
+#endif
+
+  for (auto it = fs::recursive_directory_iterator(root, ec); !ec && it != fs::recursive_directory_iterator();
+       it.increment(ec)) {
+    if (!it->is_regular_file(ec)) continue;
+    struct stat st;
+    if (::stat(it->path().c_str(), &st) != 0) continue;
+
+    FileUsage f;
+    fs::path rel = fs::relative(it->path(), root, ec);
+    f.path = rel.string();
+    f.segment = std::distance(rel.begin(), rel.end()) > 1 ? rel.begin()->string() : "";
+    f.field = field_for_path(f.path, stats.fields);
+    f.bytes = static_cast<uint64_t>(st.st_size);
+    f.allocated = static_cast<uint64_t>(st.st_blocks) * 512;
+    auto m = maps.find(it->path().string());
+    if (m != maps.end()) {
+      f.mapped = m->second.first;
+      f.resident = m->second.second;
+    }
+    stats.files.push_back(std::move(f));
+  }
+
+  stats.collect_ms += ms_since(start);
+}
+
+void count_segments(const std::string& root, const std::string& field,
+                    const std::vector<std::string>& fields, size_t& segments, size_t& with_field) {
+  std::set<std::string> all, holding;
+  std::error_code ec;
+  for (auto it = fs::recursive_directory_iterator(root, ec); !ec && it != fs::recursive_directory_iterator();
+       it.increment(ec)) {
+    if (!it->is_regular_file(ec)) continue;
+    fs::path rel = fs::relative(it->path(), root, ec);
+    if (std::distance(rel.begin(), rel.end()) < 2) continue;
+    all.insert(rel.begin()->string());
+    if (field_for_path(rel.string(), fields) == field) holding.insert(rel.begin()->string());
+  }
+  segments = all.size();
+  with_field = holding.size();
+}
+
+}  // namespace zvec_rb
+
+using zvec_rb::DetailedStats;
+
+void init_zvec_stats(Rice::Module& m) {
+  Rice::define_class_under<DetailedStats>(m, "DetailedStats")
+    .define_method("doc_count", [](const DetailedStats& s) { return s.doc_count; })
+    .define_method("index_completeness", [](const DetailedStats& s) {
+      Rice::Hash result;
+      for (const auto& [k, v] : s.index_completeness) result[Rice::String(k)] = v;
+      return result;
+    })
+    // One Hash per file: path, segment, field, bytes, allocated, mapped, resident
+    .define_method("files", [](const DetailedStats& s) {
+      Rice::Array arr;
+      for (const auto& f : s.files) {
+        Rice::Hash h;
+        h[Rice::Symbol("path")] = f.path;
+        h[Rice::Symbol("segment")] = f.segment;
+        h[Rice::Symbol("field")] = f.field.empty() ? Rice::Object(Qnil) : Rice::Object(Rice::String(f.field));
+        h[Rice::Symbol("bytes")] = f.bytes;
+        h[Rice::Symbol("allocated")] = f.allocated;
+        h[Rice::Symbol("mapped")] = f.mapped;
+        h[Rice::Symbol("resident")] = f.resident;
+        arr.push(h);
+      }
+      return arr;
+    })
+    .define_method("memory_available?", [](const DetailedStats& s) { return s.memory_available; })
+    .define_method("unflushed_writes", [](const DetailedStats& s) { return s.unflushed_writes; })
+    .define_method("max_buffer_size", [](const DetailedStats& s) { return s.max_buffer_size; })
+    .define_method("deletes_since_optimize", [](const DetailedStats& s) { return s.deletes_since_optimize; })
+    .define_method("collect_ms", [](const DetailedStats& s) { return s.collect_ms; });
+}
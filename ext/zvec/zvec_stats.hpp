@@ -0,0 +1,51 @@
+#pragma once
+
+#include "zvec_common.hpp"
+
+namespace zvec_rb {
+
+// On-disk and in-memory footprint of one file in a collection directory
+struct FileUsage {
+  std::string path;     // relative to the collection root
+  std::string segment;  // first directory component ("" for root files)
+  std::string field;    // schema field named in the file path, if any
+  uint64_t bytes = 0;       // logical size
+  uint64_t allocated = 0;   // blocks on disk
+  uint64_t mapped = 0;      // mmapped into this process
+  uint64_t resident = 0;    // mmapped pages currently in RAM
+};
+
+struct DetailedStats {
+  uint64_t doc_count = 0;
+  std::unordered_map<std::string, float> index_completeness;
+  std::vector<FileUsage> files;
+  bool memory_available = false;  // /proc/self/smaps could be read
+  uint64_t unflushed_writes = 0;
+  uint64_t max_buffer_size = 0;
+  uint64_t deletes_since_optimize = 0;
+  double collect_ms = 0;
+
+  // Read by read_detailed_stats for collect_disk_usage
+  std::string root;
+  std::vector<std::string> fields;
+};
+
+// Longest schema field name appearing as a whole token (between '/', '.',
+// '_', '-' or the ends) of a collection-relative file path, so "id" does not
+// claim "index" or "vec" claim "vector"
+std::string field_for_path(const std::string& rel, const std::vector<std::string>& fields);
+
+// Engine counts, options and this process's write counters. Raises on
+// engine errors, so call it with the GVL held.
+DetailedStats read_detailed_stats(const zvec::Collection& collection, const CollectionState& state);
+
+// Walk the collection directory and (on Linux) this process's mappings into
+// stats.files. No engine or Ruby calls; run it without the GVL.
+void collect_disk_usage(DetailedStats& stats);
+
+// Segment directories under root, and how many hold a file attributed to
+// field. A directory walk only: no stat, smaps or engine calls.
+void count_segments(const std::string& root, const std::string& field,
+                    const std::vector<std::string>& fields, size_t& segments, size_t& with_field);
+
+}  // namespace zvec_rb
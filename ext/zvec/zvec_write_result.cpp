@@ -0,0 +1,40 @@
+#include "zvec_write_result.hpp"
+
+using namespace Rice;
+
+namespace zvec_rb {
+
+std::string WriteResult::to_string() const {
+  return "WriteResult(ok=" + std::to_string(ok_count()) +
+         ", failed=" + std::to_string(failed_count()) + ")";
+}
+
+}  // namespace zvec_rb
+
+void init_zvec_write_result(Rice::Module& m) {
+  // WriteFailure — one failed row (index into the batch, pk, status)
+  Rice::define_class_under<zvec_rb::WriteFailure>(m, "WriteFailure")
+    .define_method("index", [](const zvec_rb::WriteFailure& f) { return f.index; })
+    .define_method("pk", [](const zvec_rb::WriteFailure& f) { return f.pk; })
+    .define_method("code", [](const zvec_rb::WriteFailure& f) { return f.status.code(); })
+    .define_method("message", [](const zvec_rb::WriteFailure& f) { return f.status.message(); })
+    .define_method("to_s", [](const zvec_rb::WriteFailure& f) -> std::string {
+      return "#" + std::to_string(f.index) + " " + f.pk + ": Error(" +
+             std::to_string(static_cast<int>(f.status.code())) + "): " + f.status.message();
+    });
+
+  // WriteResult — counts for the whole batch, failures materialized lazily
+  Rice::define_class_under<zvec_rb::WriteResult>(m, "WriteResult")
+    .define_method("size", &zvec_rb::WriteResult::size)
+    .define_method("ok_count", &zvec_rb::WriteResult::ok_count)
+    .define_method("failed_count", &zvec_rb::WriteResult::failed_count)
+    .define_method("all_ok?", &zvec_rb::WriteResult::all_ok)
+    .define_method("failures", [](const zvec_rb::WriteResult& r) {
+      Rice::Array arr;
+      for (const auto& f : r.failures()) {
+        arr.push(Rice::Object(Rice::detail::To_Ruby<zvec_rb::WriteFailure>().convert(f)));
+      }
+      return arr;
+    })
+    .define_method("to_s", &zvec_rb::WriteResult::to_string);
+}
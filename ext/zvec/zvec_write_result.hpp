@@ -0,0 +1,44 @@
+#pragma once
+
+#include "zvec_common.hpp"
+
+namespace zvec_rb {
+
+// A failed row of a batch write
+struct WriteFailure {
+  size_t index;
+  std::string pk;
+  zvec::Status status;
+};
+
+// Outcome of insert/upsert/update/delete. Successful rows are only counted;
+// Ruby objects for failures are built on demand.
+class WriteResult {
+ public:
+  // Build from the engine's per-row statuses in one pass. pk_at(i) is only
+  // called for failed rows.
+  template <typename Statuses, typename PkAt>
+  static WriteResult from_statuses(const Statuses& statuses, PkAt pk_at) {
+    WriteResult result;
+    result.size_ = statuses.size();
+    for (size_t i = 0; i < statuses.size(); i++) {
+      const zvec::Status& s = statuses[i];
+      if (s.ok()) continue;
+      result.failures_.push_back(WriteFailure{i, pk_at(i), s});
+    }
+    return result;
+  }
+
+  size_t size() const { return size_; }
+  size_t ok_count() const { return size_ - failures_.size(); }
+  size_t failed_count() const { return failures_.size(); }
+  bool all_ok() const { return failures_.empty(); }
+  const std::vector<WriteFailure>& failures() const { return failures_; }
+  std::string to_string() const;
+
+ private:
+  size_t size_ = 0;
+  std::vector<WriteFailure> failures_;
+};
+
+}  // namespace zvec_rb
@@ -1,9 +1,21 @@
 # frozen_string_literal: true
 
 require_relative "zvec/version"
-require "zvec_ext"
+require_relative "zvec/native"
 require_relative "zvec/collection"
+require_relative "zvec/shared_collection"
+require_relative "zvec/collection_builder"
+require_relative "zvec/partitioned_collection"
 require_relative "zvec/doc"
+require_relative "zvec/filter"
+require_relative "zvec/cursor"
+require_relative "zvec/near_duplicate_scan"
+require_relative "zvec/ivf_partitioner"
+require_relative "zvec/multi_vector"
+require_relative "zvec/detailed_stats"
+require_relative "zvec/instrumentation"
+require_relative "zvec/group_results"
+require_relative "zvec/query_profile"
 
 module Zvec
   # Rice wraps shared_ptr<Collection> as Std::SharedPtr<zvec::Collection>,
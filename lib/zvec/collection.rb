@@ -1,10 +1,25 @@
 # frozen_string_literal: true
 
+require "fileutils"
+
 module Zvec
+  class CollectionOptions
+    # Open with mmap and read each vector index into the page cache on its
+    # first query instead of up front (see Collection#open_stats). Kept on
+    # the Ruby object because the engine's options have no such flag.
+    attr_writer :lazy_load
+
+    def lazy_load?
+      @lazy_load == true
+    end
+  end
+
   module CollectionConvenience
     # Convenience: build a VectorQuery and execute it
-    def query_vector(field_name, vector, top_k:, filter: nil, include_vector: false, query_params: nil, output_fields: nil)
+    def query_vector(field_name, vector, top_k:, filter: nil, include_vector: false, query_params: nil, output_fields: nil,
+                     profile: false)
       vq = Zvec::VectorQuery.new
+      vq.profile = profile
       vq.topk = top_k
       vq.field_name = field_name
       vq.filter = filter if filter
@@ -19,6 +34,79 @@ module Zvec
       vq.set_vector(fs, vector)
       query(vq)
     end
+
+    # Convenience: stream every match within radius through a QueryCursor
+    def range_query(field_name, vector, radius:, batch_size: 100, filter: nil, query_params: nil,
+                    output_fields: nil, include_vector: false)
+      vq = Zvec::VectorQuery.new
+      vq.field_name = field_name
+      vq.filter = filter if filter
+      vq.include_vector = include_vector
+      vq.query_params = query_params if query_params
+      vq.output_fields = output_fields if output_fields
+
+      fs = schema.get_field(field_name)
+      raise ArgumentError, "Unknown field: #{field_name}" unless fs
+
+      vq.set_vector(fs, vector)
+      query_cursor(vq, batch_size: batch_size, radius: radius)
+    end
+
+    # Convenience: two-stage search. Over-fetches from a compact coarse field
+    # (encoded with quantizer when given) and re-scores against the FP32 field.
+    def refine_query_vector(coarse_field, refine_field, vector, top_k:, overfetch: 4, filter: nil,
+                            query_params: nil, output_fields: nil, quantizer: nil, metric: nil)
+      vq = Zvec::VectorQuery.new
+      vq.topk = top_k
+      vq.field_name = coarse_field
+      vq.filter = filter if filter
+      vq.query_params = query_params if query_params
+      vq.output_fields = output_fields if output_fields
+
+      fs = schema.get_field(coarse_field)
+      raise ArgumentError, "Unknown field: #{coarse_field}" unless fs
+
+      if quantizer
+        vq.set_packed_vector(fs, quantizer.quantize_vector(vector))
+      else
+        vq.set_vector(fs, vector)
+      end
+      refine_query(vq, refine_field, vector, topk: top_k, overfetch: overfetch, metric: metric)
+    end
+
+    # Convenience: exact top-k for a batch of query vectors (Array of Arrays
+    # or a packed float32 String), e.g. as ground truth for recall checks
+    def exact_batch_query(field_name, queries, top_k:, filter: "", metric: nil, concurrency: 0)
+      index = brute_force_index(field_name, metric: metric, filter: filter)
+      index.search(queries, topk: top_k, concurrency: concurrency)
+    end
+
+    # Quantizer scales live beside the collection directory, not inside it,
+    # so the engine never sees files it did not write
+    def quantizer_path(field_name)
+      "#{File.expand_path(path)}.quantizer-#{field_name}.zvq"
+    end
+
+    def save_quantizer(field_name, quantizer)
+      File.binwrite(quantizer_path(field_name), quantizer.dump)
+    end
+
+    # Returns nil when no quantizer has been saved for the field. Falls back
+    # to the file earlier versions wrote inside the collection directory.
+    def load_quantizer(field_name)
+      file = [quantizer_path(field_name), File.join(path, "quantizer-#{field_name}.zvq")].find { |f| File.exist?(f) }
+      Zvec::Quantizer.load(File.binread(file)) if file
+    end
+
+    # Convenience: snapshot into a new timestamped directory under root. Files
+    # unchanged since the newest snapshot already there are hardlinked from it.
+    # Returns the snapshot stats plus its :path. copy: as for #snapshot.
+    def snapshot_into(root, copy: false, concurrency: 0)
+      FileUtils.mkdir_p(root)
+      base = Dir.glob(File.join(root, "*", ".zvec-snapshot")).map { |m| File.dirname(m) }.max
+      dest = File.join(root, Time.now.utc.strftime("%Y%m%dT%H%M%S%6NZ"))
+      snapshot(dest, base: base || "", copy: copy, concurrency: concurrency).merge(path: dest)
+    end
   end
 
   # Block-form open: yields the collection and flushes on block exit
@@ -0,0 +1,33 @@
+# frozen_string_literal: true
+
+module Zvec
+  class CollectionBuilder
+    # Create a builder, yield it and finish. If the block raises, the partial
+    # directory is removed and the error re-raised. Returns the final path.
+    def self.build(path, schema, concurrency: 0, options: nil)
+      builder = create(File.expand_path(path), schema, concurrency, options)
+      begin
+        yield builder
+      rescue Exception
+        builder.abort
+        raise
+      end
+      builder.finish
+    end
+
+    # Add rows as Hashes through a DocBuilder, batch_size at a time
+    def add_rows(rows, schema:, batch_size: 1000)
+      doc_builder = DocBuilder.new(schema)
+      rows.each_slice(batch_size) do |slice|
+        batch = doc_builder.build_many(slice)
+        unless batch.ok?
+          row, message = batch.errors.first
+          raise ArgumentError, "row #{row}: #{message}"
+        end
+
+        add(batch)
+      end
+      self
+    end
+  end
+end
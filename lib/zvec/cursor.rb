@@ -0,0 +1,24 @@
+# frozen_string_literal: true
+
+module Zvec
+  class Cursor
+    include Enumerable
+
+    # Yield each document; batches are prefetched natively one page ahead
+    def each(&block)
+      return enum_for(:each) unless block
+
+      each_batch { |batch| batch.each(&block) }
+    end
+
+    # Yield each batch (an Array of Doc) until the scan is exhausted
+    def each_batch
+      return enum_for(:each_batch) unless block_given?
+
+      until (batch = next_batch).empty?
+        yield batch
+      end
+      self
+    end
+  end
+end
@@ -0,0 +1,64 @@
+# frozen_string_literal: true
+
+module Zvec
+  class DetailedStats
+    SIZE_KEYS = %i[bytes allocated mapped resident].freeze
+
+    # Per-file usage summed by segment directory ("" holds root-level files)
+    def segments
+      group_files(:segment)
+    end
+
+    # Per-file usage summed by the schema field named in the file path
+    # (nil holds files not attributable to a field)
+    def fields
+      group_files(:field)
+    end
+
+    def totals
+      sum_sizes(files)
+    end
+
+    def segment_count
+      segments.keys.count { |name| !name.empty? }
+    end
+
+    # Deleted docs still occupying space until the next optimize, as a
+    # fraction of live + deleted docs. A lower bound: it counts deletes by pk
+    # through this handle since it was opened, not delete_by_filter.
+    def deleted_ratio
+      total = doc_count + deletes_since_optimize
+      total.zero? ? 0.0 : deletes_since_optimize.fdiv(total)
+    end
+
+    # Docs per index that are not yet covered by the built index
+    def pending_index_docs
+      index_completeness.transform_values { |c| (doc_count * (1.0 - c)).round }
+    end
+
+    def to_h
+      {
+        doc_count: doc_count,
+        totals: totals,
+        segments: segments,
+        fields: fields,
+        unflushed_writes: unflushed_writes,
+        max_buffer_size: max_buffer_size,
+        deleted_ratio: deleted_ratio,
+        pending_index_docs: pending_index_docs,
+        memory_available: memory_available?,
+        collect_ms: collect_ms
+      }
+    end
+
+    private
+
+    def group_files(key)
+      files.group_by { |f| f[key] }.transform_values { |group| sum_sizes(group) }
+    end
+
+    def sum_sizes(group)
+      SIZE_KEYS.to_h { |k| [k, group.sum { |f| f[k] }] }
+    end
+  end
+end
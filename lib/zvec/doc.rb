@@ -16,4 +16,15 @@ module Zvec
       result
     end
   end
+  class DocBatch
+    include Enumerable
+
+    # Yield a copy of each converted Doc
+    def each(&block)
+      return enum_for(:each) unless block
+
+      docs.each(&block)
+      self
+    end
+  end
 end
@@ -0,0 +1,14 @@
+# frozen_string_literal: true
+
+module Zvec
+  class Filter
+    # Bind one value per `?` placeholder and return the filter String
+    def bind(*values)
+      bind_values(values)
+    end
+
+    def inspect
+      "#<Zvec::Filter #{source.inspect}>"
+    end
+  end
+end
@@ -0,0 +1,33 @@
+# frozen_string_literal: true
+
+module Zvec
+  class GroupResults
+    include Enumerable
+
+    # Yield each GroupResult view; the native result is shared, not copied
+    def each
+      return enum_for(:each) unless block_given?
+
+      size.times { |i| yield self[i] }
+      self
+    end
+
+    alias length size
+
+    def empty?
+      size.zero?
+    end
+  end
+
+  class GroupResult
+    include Enumerable
+
+    # Yield each doc in the group without copying it
+    def each
+      return enum_for(:each) unless block_given?
+
+      size.times { |i| yield doc(i) }
+      self
+    end
+  end
+end
@@ -0,0 +1,72 @@
+# frozen_string_literal: true
+
+module Zvec
+  # Start/finish events for Collection operations, emitted natively. Event
+  # names follow ActiveSupport::Notifications ("query.zvec", "insert.zvec",
+  # ...) and subscribers use its listener interface, so
+  # forward_to_active_support! is all an APM integration needs.
+  #
+  # Payload keys: :operation, :path, :doc_count, :topk, :filter on start;
+  # :engine_ms, :conversion_ms, :result_size (or :error) added on finish.
+  # Subscribers are kept per Ractor and only see that Ractor's operations.
+  module Instrumentation
+    # Adapts a block to the listener interface. The block gets the same
+    # arguments as an ActiveSupport::Notifications.subscribe block.
+    class BlockSubscriber
+      def initialize(block)
+        @block = block
+        @started = {}
+      end
+
+      def start(_name, id, _payload)
+        @started[id] = Process.clock_gettime(Process::CLOCK_MONOTONIC)
+      end
+
+      def finish(name, id, payload)
+        started = @started.delete(id)
+        @block.call(name, started, Process.clock_gettime(Process::CLOCK_MONOTONIC), id, payload)
+      end
+    end
+
+    # Re-emits every event through ActiveSupport::Notifications
+    class ActiveSupportForwarder
+      def start(name, _id, payload)
+        ActiveSupport::Notifications.instrumenter.start(name, payload)
+      end
+
+      def finish(name, _id, payload)
+        ActiveSupport::Notifications.instrumenter.finish(name, payload)
+      end
+    end
+
+    class << self
+      # Attach a listener (responding to start and finish) or a block. Returns
+      # the subscriber to pass to unsubscribe.
+      def subscribe(listener = nil, &block)
+        subscriber = listener || BlockSubscriber.new(block)
+        subscribers << subscriber
+        attach
+        subscriber
+      end
+
+      def unsubscribe(subscriber)
+        detach if subscribers.delete(subscriber)
+        nil
+      end
+
+      def forward_to_active_support!
+        require "active_support/notifications"
+        subscribe(ActiveSupportForwarder.new)
+      end
+
+      def subscribers
+        Ractor.current[:zvec_subscribers] ||= []
+      end
+
+      # Called by the extension with the GVL held
+      def dispatch(phase, name, id, payload)
+        subscribers.each { |s| s.public_send(phase, name, id, payload) }
+      end
+    end
+  end
+end
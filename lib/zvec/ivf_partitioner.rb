@@ -0,0 +1,17 @@
+# frozen_string_literal: true
+
+module Zvec
+  class IvfPartitioner
+    # Lists holding more than factor x the mean list size
+    def skewed_lists(factor: 2.0)
+      sizes = list_sizes
+      limit = factor * sizes.sum / sizes.size.to_f
+      sizes.each_index.select { |l| sizes[l] > limit }
+    end
+
+    # Centroids as one Array of Floats per list
+    def centroid_rows
+      centroids.unpack("f*").each_slice(dimension).to_a
+    end
+  end
+end
@@ -0,0 +1,61 @@
+# frozen_string_literal: true
+
+module Zvec
+  # Multi-vector (late-interaction, ColBERT-style) documents. The engine has
+  # no multi-vector field type, so each token vector is its own row: pk
+  # "<doc pk>#<token>", the doc pk in PARENT_FIELD and the doc's token count
+  # in TOKEN_COUNT_FIELD. The vector field's index is then the per-token
+  # index that Collection#maxsim_query draws candidates from.
+  module MultiVector
+    PARENT_FIELD = "parent"
+    TOKEN_COUNT_FIELD = "token_count"
+
+    # Collection schema for token rows. Extra scalar fields are copied onto
+    # every token row, so filters on them apply during candidate generation.
+    def self.schema(name, field:, dimension:, index_params:, data_type: DataType::VECTOR_FP32, fields: [])
+      CollectionSchema.create(name, [
+        FieldSchema.create("pk", DataType::STRING),
+        FieldSchema.create(PARENT_FIELD, DataType::STRING, index_params: InvertIndexParams.new),
+        FieldSchema.create(TOKEN_COUNT_FIELD, DataType::INT32),
+        FieldSchema.create(field, data_type, dimension: dimension, index_params: index_params),
+        *fields
+      ])
+    end
+
+    def self.token_pk(pk, token) = "#{pk}##{token}"
+  end
+
+  module CollectionConvenience
+    # Write one multi-vector doc: a row per token vector (Arrays or packed
+    # Strings), each carrying `fields`. Token rows left over from a longer
+    # previous version are deleted.
+    def upsert_multi_vector(pk, field, vectors, fields = {})
+      raise ArgumentError, "a multi-vector doc needs at least one vector" if vectors.empty?
+
+      previous = multi_vector_token_count(pk)
+      rows = vectors.each_with_index.map do |vector, token|
+        fields.merge("pk" => MultiVector.token_pk(pk, token), MultiVector::PARENT_FIELD => pk,
+                     MultiVector::TOKEN_COUNT_FIELD => vectors.size, field => vector)
+      end
+      batch = DocBuilder.new(schema).build_many(rows)
+      unless batch.ok?
+        row, message = batch.errors.first
+        raise ArgumentError, "token #{row}: #{message}"
+      end
+      result = upsert(batch)
+      delete((vectors.size...previous).map { |token| MultiVector.token_pk(pk, token) }) if previous > vectors.size
+      result
+    end
+
+    def delete_multi_vector(pk)
+      count = multi_vector_token_count(pk)
+      delete(Array.new(count) { |token| MultiVector.token_pk(pk, token) })
+    end
+
+    # Token rows stored for pk (0 when absent)
+    def multi_vector_token_count(pk)
+      doc = fetch([MultiVector.token_pk(pk, 0)]).values.first
+      doc ? doc.get_field(MultiVector::TOKEN_COUNT_FIELD, DataType::INT32) : 0
+    end
+  end
+end
@@ -0,0 +1,69 @@
+# frozen_string_literal: true
+
+require "rbconfig"
+
+module Zvec
+  # Loads the native extension. Release builds may ship -march tuned variants
+  # under zvec/native/<level>/ (see ZVEC_MARCH in ext/CMakeLists.txt); the
+  # highest level this CPU supports wins, falling back to the baseline build.
+  # Set ZVEC_MARCH=baseline (or a level name) to override the choice.
+  module Native
+    # x86-64 micro-architecture levels, best first, with the /proc/cpuinfo
+    # flags each one requires on top of the previous level
+    X86_LEVELS = {
+      "x86-64-v4" => %w[avx512f avx512bw avx512cd avx512dq avx512vl],
+      "x86-64-v3" => %w[avx avx2 bmi1 bmi2 f16c fma abm movbe xsave],
+      "x86-64-v2" => %w[cx16 lahf_lm popcnt pni sse4_1 sse4_2 ssse3]
+    }.freeze
+
+    class << self
+      attr_reader :variant
+
+      def load!
+        level = ENV.fetch("ZVEC_MARCH") { supported_levels.find { |l| variant_path(l) } }
+        path = level && level != "baseline" && variant_path(level)
+        if path
+          require path
+          @variant = level
+        else
+          require "zvec_ext"
+          @variant = "baseline"
+        end
+      end
+
+      # Levels this CPU can run, best first
+      def supported_levels
+        flags = cpu_flags
+        levels = []
+        required = []
+        X86_LEVELS.reverse_each do |level, needs|
+          required += needs
+          break unless (required - flags).empty?
+
+          levels.unshift(level)
+        end
+        levels
+      end
+
+      def variant_path(level)
+        file = File.join("zvec", "native", level, "zvec_ext.#{RbConfig::CONFIG["DLEXT"]}")
+        $LOAD_PATH.each do |dir|
+          path = File.join(dir, file)
+          return path if File.exist?(path)
+        end
+        nil
+      end
+
+      private
+
+      def cpu_flags
+        return [] unless RbConfig::CONFIG["host_cpu"] =~ /x86_64|amd64/ && File.readable?("/proc/cpuinfo")
+
+        line = File.foreach("/proc/cpuinfo").find { |l| l.start_with?("flags") }
+        line ? line.split(":", 2).last.split : []
+      end
+    end
+  end
+end
+
+Zvec::Native.load!
@@ -0,0 +1,30 @@
+# frozen_string_literal: true
+
+module Zvec
+  class NearDuplicateScan
+    include Enumerable
+
+    # Yield each pair as (pk_a, pk_b, score), pk_a < pk_b
+    def each
+      return enum_for(:each) unless block_given?
+
+      each_batch { |batch| batch.each { |a, b, score| yield a, b, score } }
+    end
+
+    # Yield each non-empty batch of [pk_a, pk_b, score] until the scan is done
+    def each_batch
+      return enum_for(:each_batch) unless block_given?
+
+      until (batch = next_batch).empty?
+        yield batch
+      end
+      self
+    end
+
+    # Finish the scan and return groups of pks linked by near-duplicate pairs
+    def components
+      each_batch { nil }
+      components_so_far
+    end
+  end
+end
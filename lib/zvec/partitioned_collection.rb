@@ -0,0 +1,15 @@
+# frozen_string_literal: true
+
+module Zvec
+  class PartitionedCollection
+    define_method(:query_vector, CollectionConvenience.instance_method(:query_vector))
+
+    # Yield each partition value with its engine collection
+    def each_partition
+      return enum_for(:each_partition) unless block_given?
+
+      partitions.each { |value| yield value, partition(value) }
+      self
+    end
+  end
+end
@@ -0,0 +1,55 @@
+# frozen_string_literal: true
+
+module Zvec
+  class VectorQuery
+    # When true, Collection#query returns a QueryResult with a QueryProfile
+    attr_writer :profile
+
+    def profile?
+      @profile == true
+    end
+  end
+
+  class QueryProfile
+    KEYS = %i[
+      executed? field index_type topk doc_count
+      filter filter_shape filter_fields unindexed_fields filter_strategy
+      invert_to_forward_scan_ratio brute_force_by_keys_ratio
+      estimated_selectivity estimate_samples actual_selectivity matched matched_capped?
+      search_strategy reason ef n_list nprobe
+      estimated_nodes_visited estimated_lists_visited estimated_distance_computations
+      refiner? refine_candidates segments segments_with_field
+      plan_ms filter_count_ms search_ms convert_ms total_ms
+    ].freeze
+
+    def to_h
+      KEYS.to_h { |k| [k.to_s.delete_suffix("?").to_sym, public_send(k)] }
+    end
+
+    # Human-readable plan, one line per stage
+    def explain
+      lines = ["#{executed? ? "Profile" : "Plan"}: #{field} (#{index_type}), topk #{topk}, " \
+               "#{doc_count} docs, #{segments_with_field}/#{segments} segments hold #{field}"]
+      unless filter.empty?
+        lines << "Filter: #{filter_shape} -> #{filter_strategy}"
+        lines << "  estimated selectivity #{format_ratio(estimated_selectivity)} (#{estimate_samples} runs), " \
+                 "actual #{format_ratio(actual_selectivity)} (#{matched}#{matched_capped? ? "+" : ""} matches)"
+      end
+      search = "Search: #{search_strategy}"
+      search += ", ef #{ef}, ~#{estimated_nodes_visited} nodes visited" if search_strategy == "graph"
+      search += ", #{estimated_lists_visited}/#{n_list} lists" if search_strategy == "ivf"
+      lines << "#{search}, ~#{estimated_distance_computations} distance computations"
+      lines << "Refiner: ~#{refine_candidates} candidates re-scored" if refiner?
+      lines << "Why: #{reason}" unless reason.empty?
+      lines << format("Phases: plan %.2fms, filter count %.2fms, search %.2fms, convert %.2fms, total %.2fms",
+                      plan_ms, filter_count_ms, search_ms, convert_ms, total_ms)
+      lines.join("\n")
+    end
+
+    private
+
+    def format_ratio(value)
+      value.nil? ? "unknown" : format("%.4g", value)
+    end
+  end
+end
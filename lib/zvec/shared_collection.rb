@@ -0,0 +1,56 @@
+# frozen_string_literal: true
+
+module Zvec
+  # Shareable handle to a collection opened read-only once per process (its
+  # own instance, even if a writer here has the path open). The handle
+  # itself is deeply frozen, so it can be passed to any Ractor; each Ractor
+  # wraps the same native collection and caches its own schema copy.
+  SharedCollection = Data.define(:path) do
+    def self.open(path)
+      path = File.expand_path(path)
+      Collection.open_shared(path)
+      Ractor.make_shareable(new(path: path))
+    end
+
+    # Re-fetched after a reload_from in any Ractor
+    def collection
+      cache = (Ractor.current[:zvec_shared_collections] ||= {})
+      generation = Collection.shared_generation(path)
+      cached = cache[path]
+      return cached[1] if cached && cached[0] == generation
+
+      Ractor.current[:zvec_shared_schemas]&.delete(path)
+      cache[path] = [generation, Collection.open_shared(path)]
+      cache[path][1]
+    end
+
+    def schema
+      cache = (Ractor.current[:zvec_shared_schemas] ||= {})
+      cache[path] ||= collection.schema
+    end
+
+    # Atomically switch every reader of this handle to the collection at dir
+    # (e.g. one built by CollectionBuilder). Queries already running finish
+    # on the old collection, which closes once they release it.
+    def reload_from(dir)
+      Ractor.current[:zvec_shared_collections]&.delete(path)
+      Ractor.current[:zvec_shared_schemas]&.delete(path)
+      Collection.reload_shared(path, File.expand_path(dir))
+      self
+    end
+
+    def query(vector_query) = collection.query(vector_query)
+    def query_vector(...) = collection.query_vector(...)
+    def group_by_query(group_query) = collection.group_by_query(group_query)
+    def fetch(pks) = collection.fetch(pks)
+    def stats = collection.stats
+
+    # Drop the process-wide instance; Ractors that still hold a wrapper keep
+    # the collection open until they release it
+    def close
+      Ractor.current[:zvec_shared_collections]&.delete(path)
+      Ractor.current[:zvec_shared_schemas]&.delete(path)
+      Collection.close_shared(path)
+    end
+  end
+end
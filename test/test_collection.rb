@@ -3,6 +3,7 @@
 require "test_helper"
 require "tmpdir"
 require "fileutils"
+require "open3"
 
 class TestCollection < Minitest::Test
   def make_schema
@@ -36,9 +37,9 @@ class TestCollection < Minitest::Test
       col = Zvec::Collection.create_and_open(File.join(dir, "col"), make_schema)
 
       doc = make_doc("doc1", [1.0, 0.0, 0.0, 0.0])
-      results = col.insert([doc])
-      assert_equal 1, results.size
-      assert results.first.ok?, "Insert failed: #{results.first.to_s}"
+      result = col.insert([doc])
+      assert_equal 1, result.size
+      assert result.all_ok?, "Insert failed: #{result.failures.map(&:to_s)}"
 
       col.flush
 
@@ -97,8 +98,8 @@ class TestCollection < Minitest::Test
       col.insert([make_doc("to_delete", [1.0, 0.0, 0.0, 0.0])])
       col.flush
 
-      results = col.delete(["to_delete"])
-      assert_equal 1, results.size
+      result = col.delete(["to_delete"])
+      assert_equal 1, result.size
       col.flush
 
       fetched = col.fetch(["to_delete"])
@@ -108,6 +109,28 @@ class TestCollection < Minitest::Test
     end
   end
 
+  def test_write_result_reports_failures
+    Dir.mktmpdir("zvec") do |dir|
+      col = Zvec::Collection.create_and_open(File.join(dir, "col"), make_schema)
+
+      assert col.insert([make_doc("dup", [1.0, 0.0, 0.0, 0.0])]).all_ok?
+      result = col.insert([make_doc("fresh", [0.0, 1.0, 0.0, 0.0]),
+                           make_doc("dup", [1.0, 0.0, 0.0, 0.0])])
+
+      assert_equal 2, result.size
+      assert_equal 1, result.ok_count
+      assert_equal 1, result.failed_count
+      refute result.all_ok?
+
+      failure = result.failures.first
+      assert_equal 1, failure.index
+      assert_equal "dup", failure.pk
+      refute_equal Zvec::StatusCode::OK, failure.code
+
+      col.destroy!
+    end
+  end
+
   def test_reopen_collection
     dir = Dir.mktmpdir("zvec")
     col_path = File.join(dir, "col")
@@ -143,4 +166,555 @@ class TestCollection < Minitest::Test
       col.destroy!
     end
   end
+
+  def test_group_by_query
+    Dir.mktmpdir("zvec") do |dir|
+      pk = Zvec::FieldSchema.create("pk", Zvec::DataType::STRING)
+      seller = Zvec::FieldSchema.create("seller", Zvec::DataType::STRING,
+        index_params: Zvec::InvertIndexParams.new)
+      vec = Zvec::FieldSchema.create("vec", Zvec::DataType::VECTOR_FP32,
+        dimension: 4,
+        index_params: Zvec::HnswIndexParams.new(Zvec::MetricType::L2))
+      col = Zvec::Collection.create_and_open(File.join(dir, "col"),
+        Zvec::CollectionSchema.create("group_col", [pk, seller, vec]))
+
+      docs = 6.times.map do |i|
+        doc = make_doc("g#{i}", [i.to_f, 0.0, 0.0, 0.0])
+        doc.set_field("seller", Zvec::DataType::STRING, "s#{i % 2}")
+        doc
+      end
+      col.insert(docs)
+      col.flush
+
+      gq = Zvec::GroupByVectorQuery.new
+      gq.field_name = "vec"
+      gq.group_by_field_name = "seller"
+      gq.group_count = 2
+      gq.group_topk = 2
+      gq.set_vector(col.schema.get_field("vec"), [0.0, 0.0, 0.0, 0.0])
+
+      groups = col.group_by_query(gq)
+      assert_equal 2, groups.size
+      assert_equal 4, groups.doc_count
+      assert_equal %w[s0 s1], groups.map(&:group_by_value).sort
+      assert_equal groups[0].pks, groups[0].docs.map(&:pk)
+
+      group_index, pks, scores = groups.packed
+      assert_equal groups.flat_map(&:pks), pks
+      assert_equal [0, 0, 1, 1], group_index.unpack("L*")
+      assert_equal groups.flat_map(&:scores), scores.unpack("f*")
+
+      col.destroy!
+    end
+  end
+
+  def test_refine_query
+    Dir.mktmpdir("zvec") do |dir|
+      pk = Zvec::FieldSchema.create("pk", Zvec::DataType::STRING)
+      coarse = Zvec::FieldSchema.create("coarse", Zvec::DataType::VECTOR_INT8,
+        dimension: 4,
+        index_params: Zvec::HnswIndexParams.new(Zvec::MetricType::L2))
+      fine = Zvec::FieldSchema.create("fine", Zvec::DataType::VECTOR_FP32, dimension: 4)
+      schema = Zvec::CollectionSchema.create("refine_col", [pk, coarse, fine])
+      col = Zvec::Collection.create_and_open(File.join(dir, "col"), schema)
+
+      vectors = [[1.0, 0.0, 0.0, 0.0], [0.9, 0.1, 0.0, 0.0], [0.0, 1.0, 0.0, 0.0]]
+      quantizer = Zvec::Quantizer.fit(vectors, type: :int8)
+      docs = vectors.each_with_index.map do |v, i|
+        doc = Zvec::Doc.new
+        doc.pk = "r#{i}"
+        doc.set_field("pk", Zvec::DataType::STRING, doc.pk)
+        doc.set_packed_vector("coarse", Zvec::DataType::VECTOR_INT8, quantizer.quantize_vector(v))
+        doc.set_field("fine", Zvec::DataType::VECTOR_FP32, v)
+        doc
+      end
+      col.insert(docs)
+      col.flush
+
+      result = col.refine_query_vector("coarse", "fine", [0.95, 0.05, 0.0, 0.0],
+        top_k: 2, overfetch: 2, quantizer: quantizer)
+      assert_equal 2, result.size
+      assert result.candidate_count >= result.size
+      assert_equal %w[r0 r1].sort, result.docs.map(&:pk).sort
+      assert_in_delta 0.005, result.docs.first.score, 1e-4
+      assert result.total_ms >= 0
+
+      col.destroy!
+    end
+  end
+
+  def test_query_cursor_pages_and_resumes
+    Dir.mktmpdir("zvec") do |dir|
+      col = Zvec::Collection.create_and_open(File.join(dir, "col"), make_schema)
+      col.insert(7.times.map { |i| make_doc("p#{i}", [1.0, i * 0.1, 0.0, 0.0]) })
+      col.flush
+
+      vq = Zvec::VectorQuery.new
+      vq.field_name = "vec"
+      vq.set_vector(col.schema.get_field("vec"), [1.0, 0.0, 0.0, 0.0])
+
+      cursor = col.query_cursor(vq, batch_size: 3)
+      first = cursor.next_batch
+      assert_equal 3, first.size
+      # Wait for the worker to prefetch the second page; it must not move the position
+      Thread.pass until cursor.ready?
+      token = cursor.position
+      assert_equal "3:#{first.last.pk}", token
+      cursor.close
+
+      resumed = col.query_cursor(vq, batch_size: 3, after: token)
+      rest = resumed.each_batch.to_a.flatten
+      all = first.map(&:pk) + rest.map(&:pk)
+      assert_equal 7, all.uniq.size
+      assert resumed.exhausted?
+
+      col.destroy!
+    end
+  end
+
+  def test_range_query
+    Dir.mktmpdir("zvec") do |dir|
+      col = Zvec::Collection.create_and_open(File.join(dir, "col"), make_schema)
+      col.insert([
+        make_doc("near", [1.0, 0.0, 0.0, 0.0]),
+        make_doc("far", [0.0, 1.0, 0.0, 0.0])
+      ])
+      col.flush
+
+      pks = col.range_query("vec", [1.0, 0.0, 0.0, 0.0], radius: 0.5, batch_size: 1).map(&:pk)
+      assert_equal ["near"], pks
+
+      col.destroy!
+    end
+  end
+
+  def test_shared_collection_across_ractors
+    Dir.mktmpdir("zvec") do |dir|
+      col = Zvec::Collection.create_and_open(File.join(dir, "col"), make_schema)
+      col.insert([make_doc("shared", [1.0, 0.0, 0.0, 0.0])])
+      col.flush
+
+      handle = Zvec::SharedCollection.open(col.path)
+      assert Ractor.shareable?(handle)
+      assert handle.collection.options.read_only?
+
+      Warning[:experimental] = false
+      ractor = Ractor.new(handle) do |h|
+        h.query_vector("vec", [1.0, 0.0, 0.0, 0.0], top_k: 1).map(&:pk)
+      end
+      assert_equal ["shared"], ractor.value
+
+      assert handle.close
+      col.destroy!
+    end
+  end
+
+  # Rice registers some wrapper types on first use, so run the first calls in
+  # a fresh process, from several Ractors at once
+  def test_first_use_from_ractors
+    Dir.mktmpdir("zvec") do |dir|
+      col = Zvec::Collection.create_and_open(File.join(dir, "col"), make_schema)
+      col.insert([make_doc("shared", [1.0, 0.0, 0.0, 0.0])])
+      col.flush
+
+      script = <<~RUBY
+        require "zvec"
+        Warning[:experimental] = false
+        handle = Zvec::SharedCollection.open(ARGV[0])
+        ractors = 4.times.map do
+          Ractor.new(handle) do |h|
+            [h.query_vector("vec", [1.0, 0.0, 0.0, 0.0], top_k: 1).map(&:pk),
+             h.fetch(["shared"]).keys, h.stats.doc_count, h.schema.all_field_names.to_a.sort]
+          end
+        end
+        p ractors.map(&:value).uniq
+      RUBY
+      out, err, status = Open3.capture3(RbConfig.ruby, "-rbundler/setup", "-e", script, col.path)
+      assert status.success?, err
+      assert_equal %([[["shared"], ["shared"], 1, ["pk", "vec"]]]\n), out
+
+      col.destroy!
+    end
+  end
+
+  def test_collection_builder_and_reload
+    Dir.mktmpdir("zvec") do |dir|
+      v1 = Zvec::CollectionBuilder.build(File.join(dir, "v1"), make_schema) do |b|
+        b.add([make_doc("old", [1.0, 0.0, 0.0, 0.0])])
+      end
+      refute File.exist?(File.join(dir, "v1.partial"))
+
+      handle = Zvec::SharedCollection.open(v1)
+      assert_equal ["old"], handle.query_vector("vec", [1.0, 0.0, 0.0, 0.0], top_k: 1).map(&:pk)
+
+      builder = Zvec::CollectionBuilder.create(File.join(dir, "v2"), make_schema, 2)
+      builder.add([make_doc("new", [1.0, 0.0, 0.0, 0.0]), make_doc("other", [0.0, 1.0, 0.0, 0.0])])
+      v2 = builder.finish
+      assert_equal 2, builder.docs_written
+      assert_equal 0, builder.docs_failed
+
+      handle.reload_from(v2)
+      assert_equal ["new"], handle.query_vector("vec", [1.0, 0.0, 0.0, 0.0], top_k: 1).map(&:pk)
+      assert_equal 1, Zvec::Collection.shared_generation(v1)
+
+      assert handle.close
+    end
+  end
+
+  def test_snapshot_and_restore
+    Dir.mktmpdir("zvec") do |dir|
+      col = Zvec::Collection.create_and_open(File.join(dir, "col"), make_schema)
+      col.insert([make_doc("a", [1.0, 0.0, 0.0, 0.0])])
+
+      # Byte copies block writes, so they need copy: true (reflinks do not)
+      begin
+        cloned = col.snapshot(File.join(dir, "cloned"))
+        assert_equal 0, cloned[:copied]
+      rescue Zvec::InvalidArgumentError => e
+        assert_match(/copy: true/, e.message)
+        refute Dir.exist?(File.join(dir, "cloned.partial"))
+      end
+
+      first = col.snapshot(File.join(dir, "snap1"), copy: true)
+      assert first[:files].positive?
+      assert_equal 0, first[:linked]
+      assert_equal 0, col.detailed_stats.unflushed_writes
+
+      col.insert([make_doc("b", [0.0, 1.0, 0.0, 0.0])])
+      second = col.snapshot(File.join(dir, "snap2"), base: File.join(dir, "snap1"), copy: true)
+      assert_equal second[:files], second[:linked] + second[:cloned] + second[:copied]
+      assert_raises(ArgumentError) { col.snapshot(File.join(dir, "snap2"), copy: true) }
+
+      # A same-size rewrite with its mtime put back is not linked from the base
+      extra = File.join(col.path, "extra.bin")
+      File.binwrite(extra, "old!")
+      col.snapshot(File.join(dir, "snap3"), copy: true)
+      mtime = File.mtime(extra)
+      File.binwrite(extra, "new!")
+      File.utime(mtime, mtime, extra)
+      col.snapshot(File.join(dir, "snap4"), base: File.join(dir, "snap3"), copy: true)
+      assert_equal "new!", File.binread(File.join(dir, "snap4", "extra.bin"))
+
+      Zvec::Collection.restore_snapshot(File.join(dir, "snap1"), File.join(dir, "restored"))
+      restored = Zvec::Collection.open(File.join(dir, "restored"))
+      assert_equal 1, restored.stats.doc_count
+      assert_empty restored.fetch(["b"])
+
+      col.destroy!
+    end
+  end
+
+  def test_query_profile_and_explain
+    Dir.mktmpdir("zvec") do |dir|
+      col = Zvec::Collection.create_and_open(File.join(dir, "col"), make_schema)
+      col.insert([make_doc("a", [1.0, 0.0, 0.0, 0.0]), make_doc("b", [0.0, 1.0, 0.0, 0.0]),
+                  make_doc("c", [0.0, 0.0, 1.0, 0.0])])
+      col.flush
+
+      plain = col.query_vector("vec", [1.0, 0.0, 0.0, 0.0], top_k: 1)
+      refute_respond_to plain, :profile
+
+      result = col.query_vector("vec", [1.0, 0.0, 0.0, 0.0], top_k: 1, filter: "pk = 'a'", profile: true)
+      assert_equal ["a"], result.map(&:pk)
+      profile = result.profile
+      assert profile.executed?
+      assert_equal "HNSW", profile.index_type
+      assert_equal ["pk"], profile.unindexed_fields
+      assert_equal "forward_scan", profile.filter_strategy
+      assert_equal 1, profile.matched
+      assert_in_delta 1.0 / 3, profile.actual_selectivity, 1e-6
+      assert_nil profile.estimated_selectivity
+      assert profile.search_ms >= 0
+      assert profile.estimated_distance_computations.positive?
+      refute_respond_to profile, :distance_computations
+
+      vq = Zvec::VectorQuery.new
+      vq.field_name = "vec"
+      vq.topk = 1
+      vq.filter = "pk = 'b'"
+      plan = col.explain(vq)
+      refute plan.executed?
+      assert_equal "pk = ?", plan.filter_shape
+      assert_equal 1, plan.estimate_samples
+      assert_in_delta 1.0 / 3, plan.estimated_selectivity, 1e-6
+      assert_nil plan.actual_selectivity
+      assert_includes plan.explain, "forward_scan"
+
+      col.destroy!
+    end
+  end
+
+  def test_detailed_stats
+    Dir.mktmpdir("zvec") do |dir|
+      col = Zvec::Collection.create_and_open(File.join(dir, "col"), make_schema)
+      col.insert([make_doc("a", [1.0, 0.0, 0.0, 0.0]), make_doc("b", [0.0, 1.0, 0.0, 0.0])])
+      assert_equal 2, col.detailed_stats.unflushed_writes
+
+      col.delete(["b"])
+      col.flush
+
+      stats = col.detailed_stats
+      assert_equal 0, stats.unflushed_writes
+      assert_equal 1, stats.deletes_since_optimize
+      assert_in_delta 0.5, stats.deleted_ratio, 1e-9
+      assert stats.totals[:bytes].positive?
+      assert_equal stats.totals[:bytes], stats.segments.values.sum { |s| s[:bytes] }
+      assert stats.collect_ms >= 0
+      # Fields are attributed by whole path tokens only ("vec" never claims "vector")
+      stats.files.each do |f|
+        next unless f[:field]
+
+        assert_match(/(?<![A-Za-z0-9])#{Regexp.escape(f[:field])}(?![A-Za-z0-9])/, f[:path])
+      end
+      refute stats.to_h.key?(:buffer_fill)
+
+      col.destroy!
+    end
+  end
+
+  def test_instrumentation_events
+    Dir.mktmpdir("zvec") do |dir|
+      col = Zvec::Collection.create_and_open(File.join(dir, "col"), make_schema)
+      events = []
+      sub = Zvec::Instrumentation.subscribe { |name, start, finish, _id, payload| events << [name, finish - start, payload] }
+      assert Zvec::Instrumentation.enabled?
+
+      col.insert([make_doc("a", [1.0, 0.0, 0.0, 0.0]), make_doc("b", [0.0, 1.0, 0.0, 0.0])])
+      col.query_vector("vec", [1.0, 0.0, 0.0, 0.0], top_k: 1, filter: "pk = 'a'")
+
+      insert = events.find { |name, _, _| name == "insert.zvec" }
+      assert_equal 2, insert[2][:doc_count]
+      assert_equal 2, insert[2][:result_size]
+      assert insert[2][:engine_ms] >= 0
+
+      query = events.find { |name, _, _| name == "query.zvec" }
+      assert_equal 1, query[2][:topk]
+      assert query[2][:filter]
+      assert_equal col.path, query[2][:path]
+
+      Zvec::Instrumentation.unsubscribe(sub)
+      refute Zvec::Instrumentation.enabled?
+      count = events.size
+      col.fetch(["a"])
+      assert_equal count, events.size
+
+      col.destroy!
+    end
+  end
+
+  def test_find_near_duplicates
+    Dir.mktmpdir("zvec") do |dir|
+      col = Zvec::Collection.create_and_open(File.join(dir, "col"), make_schema)
+      col.insert([
+        make_doc("a", [1.0, 0.0, 0.0, 0.0]),
+        make_doc("a2", [0.999, 0.01, 0.0, 0.0]),
+        make_doc("a3", [0.998, 0.02, 0.0, 0.0]),
+        make_doc("b", [0.0, 1.0, 0.0, 0.0]),
+        make_doc("c", [0.0, 0.0, 1.0, 0.0])
+      ])
+      col.flush
+
+      scan = col.find_near_duplicates("vec", threshold: 0.01, topk_per_doc: 3, concurrency: 2, batch_size: 2)
+      pairs = scan.to_a
+      assert_equal [%w[a a2], %w[a a3], %w[a2 a3]], pairs.map { |a, b, _| [a, b] }.sort
+      assert pairs.all? { |_, _, score| score <= 0.01 }
+      assert_equal 5, scan.scanned
+      assert_equal [%w[a a2 a3]], scan.components.map(&:sort)
+
+      col.destroy!
+    end
+  end
+
+  def test_scan
+    Dir.mktmpdir("zvec") do |dir|
+      col = Zvec::Collection.create_and_open(File.join(dir, "col"), make_schema)
+
+      pks = (0...5).map { |i| "scan#{i}" }
+      col.insert(pks.map { |pk| make_doc(pk, [1.0, 0.0, 0.0, 0.0]) })
+      col.flush
+
+      cursor = col.scan(batch_size: 2)
+      batches = cursor.each_batch.to_a
+      assert batches.all? { |b| b.size <= 2 }
+      assert_equal pks.sort, batches.flatten.map(&:pk).sort
+      assert cursor.exhausted?
+
+      col.destroy!
+    end
+  end
+
+  # Scan pages on the engine's _zvec_g_doc_id_ column and assumes filter-only
+  # queries return rows in ascending doc id order across segments; pin both
+  def test_scan_across_segments
+    Dir.mktmpdir("zvec") do |dir|
+      col = Zvec::Collection.create_and_open(File.join(dir, "col"), make_schema)
+
+      pks = []
+      3.times do |round|
+        batch = (0...4).map { |i| "seg#{round}-#{i}" }
+        col.insert(batch.map { |pk| make_doc(pk, [1.0, 0.0, 0.0, 0.0]) })
+        col.flush
+        pks.concat(batch)
+      end
+      # An upsert re-inserts under a new doc id; a delete leaves a gap
+      col.upsert([make_doc("seg0-1", [0.0, 1.0, 0.0, 0.0])])
+      col.delete(["seg1-2"])
+      pks.delete("seg1-2")
+      col.flush
+      assert_operator col.detailed_stats.segment_count, :>, 1
+
+      batches = col.scan(batch_size: 3).each_batch.to_a
+      ids = batches.flatten.map(&:doc_id)
+      assert_equal ids.sort, ids
+      assert_equal ids.uniq, ids
+      assert_equal pks.sort, batches.flatten.map(&:pk).sort
+
+      col.destroy!
+    end
+  end
+
+  def test_lazy_open_stats
+    Dir.mktmpdir("zvec") do |dir|
+      path = File.join(dir, "col")
+      col = Zvec::Collection.create_and_open(path, make_schema)
+      col.insert([make_doc("doc1", [1.0, 0.0, 0.0, 0.0])])
+      col.flush
+      refute col.open_stats[:lazy]
+      assert_equal [], col.open_stats[:pending]
+      assert_equal [], col.open_stats[:unmatched]
+      col = nil
+      GC.start
+
+      opts = Zvec::CollectionOptions.new
+      opts.lazy_load = true
+      col = Zvec::Collection.open(path, opts)
+      stats = col.open_stats
+      assert stats[:lazy]
+      assert_equal %w[open schema], stats[:phases].keys
+      assert_equal ["vec"], stats[:pending]
+
+      col.query_vector("vec", [1.0, 0.0, 0.0, 0.0], top_k: 1)
+      stats = col.open_stats
+      assert_equal [], stats[:pending]
+      # A phase only when some file was attributed to the field
+      assert_equal stats[:unmatched].empty?, stats[:phases].key?("index:vec")
+      assert_in_delta stats[:phases].values.sum, stats[:total_ms], 1e-6
+
+      col.destroy!
+    end
+  end
+
+  def test_insert_doc_batch
+    Dir.mktmpdir("zvec") do |dir|
+      col = Zvec::Collection.create_and_open(File.join(dir, "col"), make_schema)
+      rows = 3.times.map { |i| {"pk" => "row#{i}", "vec" => [1.0, i.to_f, 0.0, 0.0]} }
+      batch = Zvec::DocBuilder.new(col.schema).build_many(rows)
+      assert batch.ok?
+
+      assert col.insert(batch).all_ok?
+      col.flush
+      assert_equal 3, col.stats.doc_count
+
+      col.destroy!
+    end
+  end
+
+  def test_brute_force_index
+    Dir.mktmpdir("zvec") do |dir|
+      col = Zvec::Collection.create_and_open(File.join(dir, "col"), make_schema)
+      col.insert(5.times.map { |i| make_doc("bf#{i}", [1.0, i * 0.5, 0.0, 0.0]) })
+      col.flush
+
+      index = col.brute_force_index("vec", metric: Zvec::MetricType::L2)
+      assert_equal 5, index.size
+      assert_equal 4, index.dimension
+
+      hits = index.search([[1.0, 0.0, 0.0, 0.0], [1.0, 2.0, 0.0, 0.0]], topk: 2, concurrency: 2)
+      assert_equal [%w[bf0 bf1], %w[bf4 bf3]], hits.map { |row| row.map(&:first) }
+      assert_in_delta 0.25, hits[0][1][1], 1e-5
+
+      packed = index.search([1.0, 0.0, 0.0, 0.0].pack("f*"), topk: 1)
+      assert_equal "bf0", packed[0][0][0]
+
+      col.destroy!
+    end
+  end
+
+  def test_maxsim_query
+    Dir.mktmpdir("zvec") do |dir|
+      schema = Zvec::MultiVector.schema("tokens", field: "tok", dimension: 4,
+        index_params: Zvec::HnswIndexParams.new(Zvec::MetricType::IP))
+      col = Zvec::Collection.create_and_open(File.join(dir, "col"), schema)
+      col.upsert_multi_vector("a", "tok", [[1.0, 0.0, 0.0, 0.0], [0.0, 1.0, 0.0, 0.0]])
+      col.upsert_multi_vector("b", "tok", [[1.0, 0.0, 0.0, 0.0], [0.0, 0.0, 1.0, 0.0], [0.0, 0.0, 0.0, 1.0]])
+      col.flush
+
+      result = col.maxsim_query("tok", [[1.0, 0.0, 0.0, 0.0], [0.0, 1.0, 0.0, 0.0]], topk: 2, candidates: 8)
+      assert_equal %w[a b], result.pks
+      assert_in_delta 2.0, result.hits[0][1], 1e-5
+      assert_in_delta 1.0, result.hits[1][1], 1e-5
+      assert_equal 5, result.token_count
+
+      col.upsert_multi_vector("b", "tok", [[0.0, 1.0, 0.0, 0.0]])
+      assert_equal 1, col.multi_vector_token_count("b")
+      assert_empty col.fetch([Zvec::MultiVector.token_pk("b", 2)])
+
+      assert_raises(ArgumentError) { col.maxsim_query("tok", [[1.0, 0.0]]) }
+      col.destroy!
+    end
+  end
+
+  def test_ivf_partitioner
+    Dir.mktmpdir("zvec") do |dir|
+      col = Zvec::Collection.create_and_open(File.join(dir, "col"), make_schema)
+      docs = 4.times.map { |i| make_doc("x#{i}", [1.0, 0.01 * i, 0.0, 0.0]) } +
+             4.times.map { |i| make_doc("y#{i}", [0.0, 0.01 * i, 1.0, 0.0]) }
+      col.insert(docs)
+      col.flush
+
+      ivf = col.ivf_partitioner("vec", n_list: 2, n_iters: 5)
+      assert_equal 2, ivf.n_list
+      assert_equal 8, ivf.size
+      assert_equal [4, 4], ivf.list_sizes
+      assert_in_delta 1.0, ivf.imbalance, 1e-9
+      assert_empty ivf.skewed_lists
+
+      lists = ivf.assignments
+      x_list = lists["x0"]
+      assert_equal [x_list] * 4, %w[x0 x1 x2 x3].map { |pk| lists[pk] }
+      refute_equal x_list, lists["y0"]
+
+      assert_equal [x_list, 1 - x_list], ivf.assign([[2.0, 0.0, 0.0, 0.0], [0.0, 0.0, 3.0, 0.0]])
+      assert_equal [[x_list, 1 - x_list]], ivf.route([[1.0, 0.0, 0.1, 0.0]], nprobe: 2)
+
+      restored = Zvec::IvfPartitioner.from_centroids(ivf.centroids, 4, Zvec::MetricType::COSINE)
+      assert_equal [x_list], restored.assign([[1.0, 0.0, 0.0, 0.0]])
+      assert_equal 2, ivf.centroid_rows.size
+
+      col.destroy!
+    end
+  end
+
+  def test_repack_int4_skips_packed_rows
+    Dir.mktmpdir("zvec") do |dir|
+      pk = Zvec::FieldSchema.create("pk", Zvec::DataType::STRING)
+      codes = Zvec::FieldSchema.create("codes", Zvec::DataType::VECTOR_INT4, dimension: 4)
+      schema = Zvec::CollectionSchema.create("int4_col", [pk, codes])
+      col = Zvec::Collection.create_and_open(File.join(dir, "col"), schema)
+
+      doc = Zvec::Doc.new
+      doc.pk = "q0"
+      doc.set_field("pk", Zvec::DataType::STRING, "q0")
+      doc.set_field("codes", Zvec::DataType::VECTOR_INT4, [-8, 7, 0, 3])
+      col.insert([doc])
+      col.flush
+
+      assert_equal 0, col.repack_int4("codes")
+      fetched = col.fetch(["q0"])["q0"]
+      assert_equal [-8, 7, 0, 3], fetched.get_field("codes", Zvec::DataType::VECTOR_INT4)
+      assert_raises(ArgumentError) { col.repack_int4("pk") }
+
+      col.destroy!
+    end
+  end
 end
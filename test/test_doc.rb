@@ -89,4 +89,99 @@ class TestDoc < Minitest::Test
     doc = Zvec::Doc.new
     assert_nil doc.get_field("nonexistent", Zvec::DataType::STRING)
   end
+
+  def test_doc_vector_fp16
+    doc = Zvec::Doc.new
+    vec = [0.5, -1.25, 3.0, 1024.0, 0.1, 0.0, -0.0, 7.5, 2.0]
+    doc.set_field("vec", Zvec::DataType::VECTOR_FP16, vec)
+    result = doc.get_field("vec", Zvec::DataType::VECTOR_FP16)
+    assert_equal vec.size, result.size
+    result.each_with_index do |v, i|
+      assert_in_delta vec[i], v, 0.001
+    end
+  end
+
+  def test_doc_vector_int4_round_trip
+    doc = Zvec::Doc.new
+    vec = [-8, -1, 0, 1, 7, 3]
+    doc.set_field("vec", Zvec::DataType::VECTOR_INT4, vec)
+    assert_equal vec, doc.get_field("vec", Zvec::DataType::VECTOR_INT4)
+  end
+
+  def test_doc_vector_int4_odd_dimension
+    doc = Zvec::Doc.new
+    vec = [-8, -1, 0, 1, 7]
+    assert_raises(ArgumentError) { doc.set_field("vec", Zvec::DataType::VECTOR_INT4, vec) }
+    assert_raises(ArgumentError) do
+      doc.set_packed_vector("vec", Zvec::DataType::VECTOR_INT4, vec.pack("c*"))
+    end
+    refute doc.has_field?("vec")
+  end
+
+  def test_doc_vector_int4_out_of_range
+    doc = Zvec::Doc.new
+    assert_raises(RangeError) do
+      doc.set_field("vec", Zvec::DataType::VECTOR_INT4, [8, 0])
+    end
+  end
+
+  def test_doc_packed_vector_fp16
+    doc = Zvec::Doc.new
+    vec = [1.0, -2.0, 0.25, 4.0]
+    doc.set_packed_vector("vec", Zvec::DataType::VECTOR_FP16, vec.pack("f*"))
+    assert_equal vec, doc.packed_vector("vec", Zvec::DataType::VECTOR_FP16).unpack("f*")
+    assert_equal vec, doc.get_field("vec", Zvec::DataType::VECTOR_FP16)
+  end
+
+  def test_doc_packed_vector_bad_length
+    doc = Zvec::Doc.new
+    assert_raises(ArgumentError) do
+      doc.set_packed_vector("vec", Zvec::DataType::VECTOR_FP32, "\x00\x00\x00")
+    end
+  end
+
+  def test_doc_packed_vector_binary32
+    doc = Zvec::Doc.new
+    words = [0xdeadbeef, 1]
+    doc.set_packed_vector("bits", Zvec::DataType::VECTOR_BINARY32, words.pack("L*"))
+    assert_equal words, doc.packed_vector("bits", Zvec::DataType::VECTOR_BINARY32).unpack("L*")
+  end
+
+  def builder_schema
+    pk = Zvec::FieldSchema.create("pk", Zvec::DataType::STRING)
+    year = Zvec::FieldSchema.create("year", Zvec::DataType::INT32)
+    vec = Zvec::FieldSchema.create("vec", Zvec::DataType::VECTOR_FP32, dimension: 3)
+    Zvec::CollectionSchema.create("builder", [pk, year, vec])
+  end
+
+  def test_doc_builder_build
+    builder = Zvec::DocBuilder.new(builder_schema)
+    assert_equal %w[pk vec year], builder.field_names.sort
+
+    doc = builder.build({"pk" => "a", "year" => 2024, vec: [1.0, 2, 3.5]})
+    assert_equal "a", doc.pk
+    assert_equal 2024, doc.get_field("year", Zvec::DataType::INT32)
+    assert_equal [1.0, 2.0, 3.5], doc.get_field("vec", Zvec::DataType::VECTOR_FP32)
+
+    packed = builder.build({"pk" => "b", "vec" => [1.0, 2.0, 3.0].pack("f*")})
+    assert_equal [1.0, 2.0, 3.0], packed.get_field("vec", Zvec::DataType::VECTOR_FP32)
+  end
+
+  def test_doc_builder_build_many_reports_bad_rows
+    builder = Zvec::DocBuilder.new(builder_schema)
+    batch = builder.build_many([
+      {"pk" => "ok1", "year" => 1, "vec" => [0.0, 0.0, 1.0]},
+      {"pk" => "short", "vec" => [1.0]},
+      {"pk" => "typo", "yaer" => 2},
+      {"pk" => "ok2", "year" => nil}
+    ])
+
+    assert_equal 2, batch.size
+    refute batch.ok?
+    assert_equal [0, 3], batch.rows
+    assert_equal [1, 2], batch.errors.map(&:first)
+    assert_match(/vec/, batch.errors.first.last)
+    assert_equal %w[ok1 ok2], batch.map(&:pk)
+    assert batch.docs.last.null?("year")
+  end
 end
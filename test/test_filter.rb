@@ -0,0 +1,71 @@
+# frozen_string_literal: true
+
+require "test_helper"
+
+class TestFilter < Minitest::Test
+  def schema
+    Zvec::CollectionSchema.create("filter_col", [
+      Zvec::FieldSchema.create("tenant_id", Zvec::DataType::STRING),
+      Zvec::FieldSchema.create("price", Zvec::DataType::DOUBLE),
+      Zvec::FieldSchema.create("year", Zvec::DataType::INT32),
+      Zvec::FieldSchema.create("vec", Zvec::DataType::VECTOR_FP32, dimension: 4)
+    ])
+  end
+
+  def test_bind
+    f = Zvec::Filter.compile("tenant_id = ? AND price < ? AND year IN (?, ?)", schema: schema)
+    assert_equal 4, f.placeholder_count
+    assert_equal %w[tenant_id price year], f.fields
+    assert_equal "tenant_id = 'acme' AND price < 9.5 AND year IN (2023, 2024)",
+      f.bind("acme", 9.5, 2023, 2024)
+  end
+
+  def test_compile_is_cached
+    Zvec::Filter.clear_cache
+    Zvec::Filter.compile("year > ?", schema: schema)
+    Zvec::Filter.compile("year > ?", schema: schema)
+    assert_equal 1, Zvec::Filter.cache_size
+  end
+
+  def test_cache_is_bounded
+    Zvec::Filter.clear_cache
+    (Zvec::Filter.cache_limit + 10).times { |i| Zvec::Filter.compile("year > #{i} AND price < ?") }
+    assert_equal Zvec::Filter.cache_limit, Zvec::Filter.cache_size
+  ensure
+    Zvec::Filter.clear_cache
+  end
+
+  def test_rejects_unknown_field
+    assert_raises(ArgumentError) { Zvec::Filter.compile("owner = ?", schema: schema) }
+  end
+
+  def test_rejects_wrong_type
+    f = Zvec::Filter.compile("year > ?", schema: schema)
+    assert_raises(ArgumentError) { f.bind("2020") }
+    assert_raises(RangeError) { f.bind(2**40) }
+  end
+
+  def test_rejects_injection
+    f = Zvec::Filter.compile("tenant_id = ?", schema: schema)
+    assert_raises(ArgumentError) { f.bind("x' OR tenant_id != 'x") }
+    assert_raises(ArgumentError) { f.bind("O'Brien") }
+    assert_raises(ArgumentError) { f.bind("a\\' OR 1=1") }
+    assert_raises(ArgumentError) { f.bind("a\\b") }
+  end
+
+  def test_placeholder_against_function_needs_a_field
+    assert_raises(ArgumentError) { Zvec::Filter.compile("? = lower(tenant_id)", schema: schema) }
+    assert_equal 1, Zvec::Filter.compile("? = lower(tenant_id)").placeholder_count
+  end
+
+  def test_wrong_arity
+    f = Zvec::Filter.compile("year > ? AND year < ?")
+    assert_raises(ArgumentError) { f.bind(1) }
+  end
+
+  def test_placeholder_inside_string_is_literal
+    f = Zvec::Filter.compile("tenant_id = 'a?b' AND year = ?")
+    assert_equal 1, f.placeholder_count
+    assert_equal "tenant_id = 'a?b' AND year = 7", f.bind(7)
+  end
+end
@@ -0,0 +1,124 @@
+# frozen_string_literal: true
+
+require "test_helper"
+require "tmpdir"
+
+class TestPartitionedCollection < Minitest::Test
+  def make_schema
+    pk = Zvec::FieldSchema.create("pk", Zvec::DataType::STRING)
+    tenant = Zvec::FieldSchema.create("tenant", Zvec::DataType::STRING,
+      index_params: Zvec::InvertIndexParams.new)
+    year = Zvec::FieldSchema.create("year", Zvec::DataType::INT32,
+      index_params: Zvec::InvertIndexParams.new)
+    vec = Zvec::FieldSchema.create("vec", Zvec::DataType::VECTOR_FP32,
+      dimension: 4,
+      index_params: Zvec::HnswIndexParams.new(Zvec::MetricType::COSINE))
+    Zvec::CollectionSchema.create("tenants", [pk, tenant, year, vec])
+  end
+
+  def make_doc(pk, tenant, year, vec)
+    doc = Zvec::Doc.new
+    doc.pk = pk
+    doc.set_field("pk", Zvec::DataType::STRING, pk)
+    doc.set_field("tenant", Zvec::DataType::STRING, tenant)
+    doc.set_field("year", Zvec::DataType::INT32, year)
+    doc.set_field("vec", Zvec::DataType::VECTOR_FP32, vec)
+    doc
+  end
+
+  def test_pruned_partitions
+    Dir.mktmpdir("zvec") do |dir|
+      col = Zvec::PartitionedCollection.create(File.join(dir, "col"), make_schema, "tenant")
+      col.insert([make_doc("a1", "acme", 2020, [1.0, 0.0, 0.0, 0.0]),
+                  make_doc("b1", "beta", 2021, [0.0, 1.0, 0.0, 0.0])])
+
+      assert_equal %w[acme beta], col.partitions.sort
+      assert_equal ["acme"], col.pruned_partitions("tenant = 'acme' AND year > 2000")
+      assert_equal ["beta"], col.pruned_partitions("tenant IN ('beta', 'gone')")
+      assert_equal [], col.pruned_partitions("tenant = 'acme' AND tenant = 'beta'")
+      assert_nil col.pruned_partitions("tenant = 'acme' OR year > 2000")
+      assert_nil col.pruned_partitions("year > 2000")
+
+      col.destroy!
+    end
+  end
+
+  def test_query_and_drop_partition
+    Dir.mktmpdir("zvec") do |dir|
+      path = File.join(dir, "col")
+      col = Zvec::PartitionedCollection.create(path, make_schema, "tenant")
+      result = col.insert([
+        make_doc("a1", "acme", 2020, [1.0, 0.0, 0.0, 0.0]),
+        make_doc("a2", "acme", 2021, [0.9, 0.1, 0.0, 0.0]),
+        make_doc("b1", "beta", 2021, [1.0, 0.0, 0.0, 0.0])
+      ])
+      assert result.all_ok?
+      col.flush
+      assert_equal 3, col.doc_count
+
+      pinned = col.query_vector("vec", [1.0, 0.0, 0.0, 0.0], top_k: 10, filter: "tenant = 'acme'")
+      assert_equal %w[a1 a2], pinned.map(&:pk).sort
+
+      all = col.query_vector("vec", [1.0, 0.0, 0.0, 0.0], top_k: 2)
+      assert_equal 2, all.size
+      assert_equal %w[a1 b1], all.map(&:pk).sort
+
+      assert_equal ["a1"], col.fetch(["a1", "b1"], partition: "acme").keys
+
+      col.delete_by_filter("tenant = 'beta'")
+      assert_equal ["acme"], col.partitions
+      refute Dir.exist?(File.join(path, "partitions", "p62657461"))
+
+      reopened = Zvec::PartitionedCollection.open(path)
+      assert_equal "tenant", reopened.partition_key
+      assert_equal ["acme"], reopened.partitions
+      reopened.destroy!
+    end
+  end
+
+  def test_partition_key_change
+    Dir.mktmpdir("zvec") do |dir|
+      col = Zvec::PartitionedCollection.create(File.join(dir, "col"), make_schema, "tenant")
+      col.insert([make_doc("a1", "acme", 2020, [1.0, 0.0, 0.0, 0.0])])
+
+      # Upsert moves the row instead of leaving a copy behind
+      assert col.upsert([make_doc("a1", "beta", 2021, [0.0, 1.0, 0.0, 0.0])]).all_ok?
+      col.flush
+      assert_equal 1, col.doc_count
+      assert_empty col.fetch(["a1"], partition: "acme")
+      assert_equal ["a1"], col.fetch(["a1"], partition: "beta").keys
+
+      # Insert and update refuse to put the pk in a second partition
+      refute col.insert([make_doc("a1", "acme", 2022, [1.0, 0.0, 0.0, 0.0])]).all_ok?
+      update = col.update([make_doc("a1", "acme", 2022, [1.0, 0.0, 0.0, 0.0])])
+      assert_equal 1, update.failed_count
+      assert_match(/partition key/, update.failures.first.message)
+      col.flush
+      assert_equal 1, col.doc_count
+
+      col.destroy!
+    end
+  end
+
+  def test_pk_map_survives_reopen
+    Dir.mktmpdir("zvec") do |dir|
+      path = File.join(dir, "col")
+      col = Zvec::PartitionedCollection.create(path, make_schema, "tenant")
+      col.insert([make_doc("a1", "acme", 2020, [1.0, 0.0, 0.0, 0.0]),
+                  make_doc("b1", "beta", 2021, [0.0, 1.0, 0.0, 0.0])])
+      col.flush
+      assert File.exist?(File.join(path, "pk_partitions"))
+
+      reopened = Zvec::PartitionedCollection.open(path)
+      assert_equal %w[a1 b1], reopened.fetch(%w[a1 b1]).keys.sort
+      refute reopened.insert([make_doc("a1", "beta", 2022, [0.0, 1.0, 0.0, 0.0])]).all_ok?
+
+      # A stale entry (row removed by filter) does not block a new partition
+      reopened.delete_by_filter("year = 2020")
+      assert reopened.insert([make_doc("a1", "beta", 2022, [0.0, 1.0, 0.0, 0.0])]).all_ok?
+      assert reopened.delete(["a1"]).all_ok?
+      assert_empty reopened.fetch(["a1"])
+      reopened.destroy!
+    end
+  end
+end
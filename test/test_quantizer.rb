@@ -0,0 +1,75 @@
+# frozen_string_literal: true
+
+require "test_helper"
+require "tmpdir"
+
+class TestQuantizer < Minitest::Test
+  SAMPLE = [
+    [1.0, -0.5, 0.25, 2.0],
+    [-1.0, 0.5, -0.25, -2.0],
+    [0.5, 0.0, 0.125, 1.0]
+  ].freeze
+
+  def test_fit_int8_per_dimension
+    q = Zvec::Quantizer.fit(SAMPLE, type: :int8)
+    assert_equal :int8, q.type
+    assert_equal 4, q.dimension
+    assert q.per_dimension?
+    assert_equal Zvec::DataType::VECTOR_INT8, q.data_type
+    assert_in_delta 2.0 / 127, q.params[3], 1e-6
+  end
+
+  def test_quantize_int8_scales_to_full_range
+    q = Zvec::Quantizer.fit(SAMPLE, type: :int8)
+    codes = q.quantize(SAMPLE)
+    assert_equal 3, codes.size
+    assert_equal [127, -127, 127, 127], codes[0].unpack("c*")
+  end
+
+  def test_quantize_int4_clamps
+    q = Zvec::Quantizer.fit(SAMPLE, type: :int4, per_dimension: false)
+    code = q.quantize_vector([4.0, -4.0, 0.0, 1.0]).unpack("c*")
+    assert_equal [7, -8, 0, 4], code
+  end
+
+  def test_quantize_binary
+    q = Zvec::Quantizer.fit(SAMPLE, type: :binary32)
+    code = q.quantize_vector([1.0, -1.0, 1.0, -1.0])
+    assert_equal 4, code.bytesize
+    assert_equal [0b0101], code.unpack("L*")
+  end
+
+  def test_dump_and_load
+    q = Zvec::Quantizer.fit(SAMPLE, type: :int8, percentile: 0.5)
+    restored = Zvec::Quantizer.load(q.dump)
+    assert_equal q.params, restored.params
+    assert_equal q.quantize(SAMPLE), restored.quantize(SAMPLE)
+  end
+
+  def test_load_rejects_unknown_kind
+    data = Zvec::Quantizer.fit(SAMPLE, type: :int8).dump.b
+    data.setbyte(4, 9)
+    assert_raises(ArgumentError) { Zvec::Quantizer.load(data) }
+  end
+
+  def test_save_quantizer_beside_collection
+    Dir.mktmpdir("zvec") do |dir|
+      pk = Zvec::FieldSchema.create("pk", Zvec::DataType::STRING)
+      vec = Zvec::FieldSchema.create("vec", Zvec::DataType::VECTOR_INT8, dimension: 4)
+      col = Zvec::Collection.create_and_open(File.join(dir, "col"),
+        Zvec::CollectionSchema.create("q_col", [pk, vec]))
+      q = Zvec::Quantizer.fit(SAMPLE, type: :int8)
+
+      col.save_quantizer("vec", q)
+      assert_equal File.join(dir, "col.quantizer-vec.zvq"), col.quantizer_path("vec")
+      assert_empty Dir.glob(File.join(dir, "col", "*.zvq"))
+      assert_equal q.params, col.load_quantizer("vec").params
+
+      col.destroy!
+    end
+  end
+
+  def test_rejects_unknown_type
+    assert_raises(ArgumentError) { Zvec::Quantizer.fit(SAMPLE, type: :int2) }
+  end
+end
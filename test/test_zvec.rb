@@ -1,6 +1,7 @@
 # frozen_string_literal: true
 
 require "test_helper"
+require "etc"
 
 class TestZvec < Minitest::Test
   def test_version
@@ -10,4 +11,52 @@ class TestZvec < Minitest::Test
   def test_zvec_available
     assert Zvec.zvec_available?
   end
+
+  def test_scheduler_configure_and_stats
+    Zvec.configure(maintenance_cpu_share: 0.5, maintenance_pause_p99_ms: 250.0)
+    stats = Zvec.scheduler_stats
+    assert_kind_of Float, stats[:query_p99_ms]
+    assert stats.key?(:maintenance_waits)
+  ensure
+    Zvec.configure(maintenance_pause_p99_ms: 0.0)
+  end
+
+  def test_query_cpu_share_alone_sets_query_threads
+    Zvec.configure(query_cpu_share: 0.5)
+    expected = [1, (0.5 * Etc.nprocessors).to_i].max
+    assert_equal expected, Zvec.configuration[:query_thread_count]
+  end
+
+  def test_maintenance_cpu_share_alone_sets_optimize_threads
+    Zvec.configure(maintenance_cpu_share: 0.5)
+    config = Zvec.configuration
+    assert_equal [1, (0.5 * Etc.nprocessors).to_i].max, config[:optimize_thread_count]
+    assert_in_delta 0.5, config[:maintenance_cpu_share]
+  end
+
+  def test_scheduler_keys_alone_keep_other_settings
+    Zvec.configure(maintenance_cpu_share: 0.25, memory_limit_mb: 256)
+    Zvec.configure(maintenance_pause_p99_ms: 40.0)
+    Zvec.configure(maintenance_max_wait_s: 5.0)
+    Zvec.configure(latency_window_s: 2.0)
+    config = Zvec.configuration
+    assert_in_delta 0.25, config[:maintenance_cpu_share]
+    assert_in_delta 40.0, config[:maintenance_pause_p99_ms]
+    assert_in_delta 5.0, config[:maintenance_max_wait_s]
+    assert_in_delta 2.0, config[:latency_window_s]
+    assert_equal 256, config[:memory_limit_mb]
+  ensure
+    Zvec.configure(maintenance_pause_p99_ms: 0.0, maintenance_max_wait_s: 60.0, latency_window_s: 10.0)
+  end
+
+  def test_configure_rejects_unknown_keys
+    before = Zvec.configuration
+    assert_raises(ArgumentError) { Zvec.configure(maintenance_pause_p99_ms: 40.0, query_threads: 4) }
+    assert_raises(ArgumentError) { Zvec.configure("memory_limit_mb" => 256) }
+    assert_equal before, Zvec.configuration
+  end
+
+  def test_scheduler_rejects_bad_share
+    assert_raises(ArgumentError) { Zvec.configure(maintenance_cpu_share: 1.5) }
+  end
 end